@@ -26,7 +26,9 @@ Coder.prototype.gen = function(inputFileName, outputFilename, coderMapper) {
 }
 
 Coder.prototype.copyFiles = function(modelName) {
-    var files = ['ni_modelframework.c', 'ni_modelframework.h'];
+    var files = ['ni_modelframework.c', 'ni_modelframework.h', 'ni_runner.c', 'ni_shmreader.c', 'ni_shmreader.h', 'ni_monitor.c',
+        'ni_server.h', 'ni_server.c', 'ni_client.c', 'ni_serverbench.c',
+        'ni_archive.h', 'ni_archive.c', 'ni_archivebench.c', 'ni_sequence.hpp', 'ni_sequence.cpp', 'ni_filter.h', 'ni_filter.c'];
     files.forEach(function(filename) {
         var src = 'templates/'+filename;
         var dst = modelName+'/'+filename;
@@ -47,23 +49,525 @@ Coder.prototype.run = function(filename) {
         fs.mkdirSync(name);
     }
 
-    if(json.ImplFileName) {
+    this.subModels = [];
+    if(json.Models) {
+        if(!this.initComposite(filename)) {
+            return;
+        }
+    }else if(json.ImplFileName) {
         this.ImplFileName = path.dirname(filename) + '/' + json.ImplFileName;
     }else{
         this.ImplFileName = 'templates/impl.c';
     }
+    if(json.Sequence) {
+        this.SequenceFileName = path.dirname(filename) + '/' + json.Sequence.file;
+    }
+
+    try {
+        this.genHeader(this.json);
+        this.genContent(this.json);
+        this.genSubModels(this.json);
+        this.genSequence(this.json);
+        this.genMakeFile(this.json, "CMakeLists.txt");
+        this.genLayoutReport(this.json);
+        this.copyFiles(name);
+    }catch(e) {
+        console.log(e.message);
+    }
+}
+
+/*
+ * A composite definition instantiates existing model definitions and connects
+ * outports of one instance to inports of another:
+ *
+ *  "Models" : { "<instance>" : "<definition.json>", ... },
+ *  "Connections" : [ { "from" : "<instance>/<outport>", "to" : "<instance>/<inport>" }, ... ]
+ *
+ * It is flattened into a regular definition whose fields are grouped per instance
+ * ("<instance>.<field>"). Each instance's implementation is compiled in its own 
+ * translation unit and called from a static schedule in topological order of the
+ * connections. Unconnected inports become the composite's inports, all outports
+ * are exported as the composite's outports.
+ */
+Coder.prototype.initComposite = function(filename) {
+    var json = this.json;
+    var dir = path.dirname(filename);
+    var instances = Object.keys(json.Models);
+    var connections = json.Connections || [];
+    var models = {};
+    var order = [];
+    var error = null;
+
+    instances.forEach(function(inst) {
+        var defFile = dir + '/' + json.Models[inst];
+        var def = null;
+
+        try {
+            def = JSON.parse(fs.readFileSync(defFile, "utf-8").toString());
+        }catch(e) {
+            console.dir(e);
+            error = error || "Cannot load definition of " + inst;
+            return;
+        }
+
+        if(Number(def.baserate) !== Number(json.baserate)) {
+            error = error || inst + ": baserate " + def.baserate + " differs from " + json.baserate;
+        }
+
+        models[inst] = {
+            instance : inst,
+            definition : defFile,
+            json : def,
+            ImplFileName : def.ImplFileName ? path.dirname(defFile) + '/' + def.ImplFileName : 'templates/impl.c',
+            sources : {},
+            deps : []
+        };
+    });
+
+    connections.forEach(function(conn) {
+        var from = String(conn.from).split('/');
+        var to = String(conn.to).split('/');
+        var src = models[from[0]];
+        var dst = models[to[0]];
+
+        if(!src || !dst || !(src.json.Outports || {})[from[1]] || !(dst.json.Inports || {})[to[1]]) {
+            error = error || "Invalid connection " + conn.from + " => " + conn.to;
+        }else if(dst.sources[to[1]]) {
+            error = error || to.join('/') + " is connected more than once";
+        }else {
+            dst.sources[to[1]] = { instance : from[0], port : from[1] };
+            if(dst.deps.indexOf(from[0]) < 0) {
+                dst.deps.push(from[0]);
+            }
+        }
+    });
+
+    if(error) {
+        console.log(error);
+        return false;
+    }
+
+    /* Static schedule: topological order of the connections, stable with respect to the declaration order */
+    while(order.length < instances.length) {
+        var ready = instances.filter(function(inst) {
+            return order.indexOf(inst) < 0 && models[inst].deps.every(function(dep) {
+                return order.indexOf(dep) >= 0;
+            });
+        });
+
+        if(!ready.length) {
+            console.log("Connections of " + json.name + " contain a loop, there is no static schedule.");
+            return false;
+        }
+        order.push(ready[0]);
+    }
+
+    var flat = {
+        name : json.name,
+        baserate : json.baserate,
+        desc : json.desc,
+        Parameters : {},
+        Inports : {},
+        Outports : {},
+        Signals : {}
+    };
+
+    order.forEach(function(inst) {
+        var def = models[inst].json;
+        var groups = ['Parameters', 'Inports', 'Outports', 'Signals'];
+
+        groups.forEach(function(group) {
+            var fields = def[group] || {};
+            for(var key in fields) {
+                var info = JSON.parse(JSON.stringify(fields[key]));
+                info.desc = group == 'Parameters' ? inst + '/' + (info.desc || key) : info.desc;
+                if(group == 'Inports') {
+                    info.external = !models[inst].sources[key];
+                }
+                flat[group][inst + '.' + key] = info;
+            }
+        });
+    });
+
+    this.json = flat;
+    this.subModels = order.map(function(inst) {
+        return models[inst];
+    });
+    this.implementation = this.genSchedule(flat.name, this.subModels);
+
+    return true;
+}
+
+/* Generates USER_TakeOneStep of a composite model: the sub-model steps in schedule order, wired through the output bus */
+Coder.prototype.genSchedule = function(name, subModels) {
+    var str = "";
+    var bus = {};
+    var nbus = 0;
+    var next = 0;
+    var step = "";
+
+    subModels.forEach(function(model) {
+        bus[model.instance] = nbus;
+        nbus += Object.keys(model.json.Outports || {}).length;
+    });
+
+    /* Index of an outport on the output bus */
+    function busIndex(src) {
+        var model = subModels.filter(function(m) { return m.instance == src.instance; })[0];
+        return bus[src.instance] + Object.keys(model.json.Outports).indexOf(src.port);
+    }
+
+    str += '/* Static step schedule of the composite model, sub-models in topological order of their connections.\n';
+    str += '   Every sub-model writes its outports straight into its slice of the output bus, which is the\n';
+    str += '   host\'s outData when available. Connected inports read from the bus in place where possible. */\n';
+
+    subModels.forEach(function(model) {
+        var inst = model.instance;
+        var inportKeys = Object.keys(model.json.Inports || {});
+        var fn = name + '_' + inst + '_TakeOneStep';
+        var external = inportKeys.filter(function(key) { return !model.sources[key]; });
+        var wiring = inportKeys.map(function(key) {
+            var src = model.sources[key];
+            return key + ' <- ' + (src ? src.instance + '/' + src.port : 'external');
+        });
+        var inData = 'NULL';
+        var gather = "";
+
+        str += 'int32_t ' + fn + '(double *inData, double *outData, double timestamp);\n';
+
+        if(inportKeys.length) {
+            var first = model.sources[inportKeys[0]];
+            var aliased = first && inportKeys.every(function(key, index) {
+                var src = model.sources[key];
+                return src && src.instance == first.instance && busIndex(src) == busIndex(first) + index;
+            });
+
+            if(aliased) {
+                /* All inports are fed, in order, by consecutive outports of one upstream sub-model */
+                inData = 'bus + ' + busIndex(first);
+            }else if(external.length == inportKeys.length) {
+                /* All inports are external, they are contiguous in the composite's inData */
+                inData = 'inData ? inData + ' + next + ' : NULL';
+            }else {
+                /* Mixed sources, gather the inports */
+                str += 'static double rtInData_' + inst + '[' + inportKeys.length + '];\n';
+                inportKeys.forEach(function(key, index) {
+                    var src = model.sources[key];
+                    if(src) {
+                        gather += '\trtInData_' + inst + '[' + index + '] = bus[' + busIndex(src) + '];\n';
+                    }else {
+                        gather += '\tif (inData) rtInData_' + inst + '[' + index + '] = inData[' + (next + external.indexOf(key)) + '];\n';
+                    }
+                });
+                inData = 'rtInData_' + inst;
+            }
+        }
+
+        step += '\t/* ' + inst + (wiring.length ? ': ' + wiring.join(', ') : '') + ' */\n';
+        step += gather;
+        step += '\tretval |= ' + fn + '(' + inData + ', bus + ' + bus[inst] + ', timestamp);\n\n';
+        next += external.length;
+    });
+
+    str += '\nstatic double rtBus[' + Math.max(nbus, 1) + '];\n\n';
+    str += '/* INPUT: *inData, pointer to inport data at the current timestamp, to be \n';
+    str += '  	      consumed by the function\n';
+    str += '   OUTPUT: *outData, pointer to outport data at current time + baserate, to be\n';
+    str += '  	       produced by the function\n';
+    str += '   INPUT: timestamp, current simulation time */\n';
+    str += 'int32_t USER_TakeOneStep(double *inData, double *outData, double timestamp)\n{\n';
+    str += '\tdouble *bus = outData ? outData : rtBus;\n';
+    str += '\tint32_t retval = NI_OK;\n\n';
+    str += step;
+    str += '\treturn retval;\n}\n';
+
+    return str;
+}
+
+/* Writes one translation unit per sub-model of a composite model */
+Coder.prototype.genSubModels = function(json) {
+    var coder = this;
+    var name = json.name.toString();
+
+    this.subModels.forEach(function(model) {
+        var coderMapper = {
+            "@model-name@" : function() {
+                return name;
+            },
+            "@instance@" : function() {
+                return model.instance;
+            },
+            "@definition@" : function() {
+                return model.definition;
+            },
+            "@Subsystems-Decl@" : function() {
+                var str = "";
+                if(coder.getSubsystems(model.json).length) {
+                    str += '/* Subsystems of a sub-model run in order on the step thread */\n';
+                    str += 'static int32_t ' + name + '_' + model.instance + '_RunSubsystems(double timestamp);\n';
+                    str += '#define NI_RunSubsystems ' + name + '_' + model.instance + '_RunSubsystems\n';
+                }
+                return str;
+            },
+            "@Subsystems@" : function() {
+                var subsystems = coder.getSubsystems(model.json);
+                var str = coder.genSubsystemMemo(model.json, subsystems);
+                if(subsystems.length) {
+                    subsystems.forEach(function(sub) {
+                        str += sub.optional ? '\n/* running cost estimate of the optional subsystem ' + sub.name + ' */\nstatic double ' + sub.name + '_cost;\n' : "";
+                    });
+                    str += '\nstatic int32_t ' + name + '_' + model.instance + '_RunSubsystems(double timestamp)\n{\n';
+                    subsystems.forEach(function(sub) {
+                        str += sub.optional ? '\tNI_RunOptionalSubsystem(' + sub.entry + ', &' + sub.name + '_cost, timestamp);\n' : '\t' + sub.entry + '(timestamp);\n';
+                    });
+                    str += '\treturn NI_OK;\n}\n';
+                }
+                return str;
+            },
+            "@LTI@" : function() {
+                return coder.genLTI(model.json, 'rtModel.lti.' + model.instance);
+            },
+            "@Filters@" : function() {
+                return coder.genFilters(model.json, 'rtModel.filters.' + model.instance);
+            },
+            "@implementation@" : function() {
+                return fs.readFileSync(model.ImplFileName, "utf-8");
+            }
+        }
+
+        coder.gen("templates/submodel.c", name + '/' + name + '_' + model.instance + '.c', coderMapper);
+    });
+}
+
+/*
+ * Writes the translation unit of the sequence coroutine, compiled as C++20:
+ * "Sequence" : { "file" : "<file defining NI_Sequence USER_Sequence()>", "frame" : <bytes of the frame> }
+ */
+Coder.prototype.genSequence = function(json) {
+    var coder = this;
+    var name = json.name.toString();
+
+    if(!json.Sequence) {
+        return;
+    }
+
+    var coderMapper = {
+        "@model-name@" : function() {
+            return name;
+        },
+        "@definition@" : function() {
+            return coder.SequenceFileName;
+        },
+        "@implementation@" : function() {
+            return fs.readFileSync(coder.SequenceFileName, "utf-8");
+        }
+    }
+
+    this.gen("templates/sequence.cpp", name + '/' + name + '_sequence.cpp', coderMapper);
+}
+
+/* Size of the field types, fields are assumed to be naturally aligned */
+var typeSizes = { 'char' : 1, 'short' : 2, 'int' : 4, 'float' : 4, 'int32_t' : 4, 'uint32_t' : 4, 'double' : 8, 'int64_t' : 8 };
+
+/*
+ * Orders the fields of a struct for a compact, cache friendly layout: fields marked "hot"
+ * come first so the ones used every step share the first cache lines, then by decreasing
+ * alignment so no padding is needed between them. Fields of the same hotness and alignment
+ * keep their declared order. Nested structs ("<group>.<field>") move as a whole and are
+ * ordered the same way inside. "Layout" : "declared" keeps the declared order.
+ */
+Coder.prototype.orderFields = function(fields) {
+    var keys = Object.keys(fields || {});
+    if(this.json.Layout === "declared") {
+        return keys;
+    }
+
+    var units = [];
+    keys.forEach(function(key) {
+        var parts = key.split('.');
+        var last = units[units.length - 1];
+        if(parts.length > 1 && last && last.group === parts[0]) {
+            last.keys.push(key);
+        }else{
+            units.push({ group : parts.length > 1 ? parts[0] : null, keys : [key], index : units.length });
+        }
+    });
+
+    units.forEach(function(unit) {
+        if(unit.group) {
+            unit.keys = sortUnits(unit.keys.map(function(key, index) {
+                return { keys : [key], index : index, hot : !!fields[key].hot, align : typeSizes[fields[key].type] || 8 };
+            }));
+        }
+        unit.hot = unit.keys.some(function(key) { return !!fields[key].hot; });
+        unit.align = Math.max.apply(null, unit.keys.map(function(key) { return typeSizes[fields[key].type] || 8; }));
+    });
+
+    function sortUnits(list) {
+        return list.sort(function(a, b) {
+            return (b.hot - a.hot) || (b.align - a.align) || (a.index - b.index);
+        }).reduce(function(ordered, unit) {
+            return ordered.concat(unit.keys);
+        }, []);
+    }
+
+    return sortUnits(units);
+}
+
+/*
+ * Computes the offsets, size and padding of a struct declared by genDecl with its fields in
+ * the given order, assuming natural alignment. Returns { size, align, padding, fields : [{ key, offset, size }] }.
+ */
+Coder.prototype.computeLayout = function(fields, keys, minAlign) {
+    var result = { size : 0, align : minAlign || 1, padding : 0, fields : [] };
+    var offset = 0;
+
+    function place(size, align) {
+        var start = Math.ceil(offset / align) * align;
+        result.padding += start - offset;
+        result.align = Math.max(result.align, align);
+        offset = start + size;
+        return start;
+    }
 
-    this.genHeader(json);
-    this.genContent(json);
-    this.genMakeFile(json, "CMakeLists.txt");
-    this.copyFiles(name);
+    for(var i = 0; i < keys.length; ) {
+        var group = keys[i].split('.').length > 1 ? keys[i].split('.')[0] : null;
+        if(group) {
+            var members = [];
+            while(i < keys.length && keys[i].split('.')[0] === group) {
+                members.push(keys[i++]);
+            }
+            /* a nested struct is laid out on its own, then placed as a whole */
+            var inner = this.computeLayout(fields, [], 1);
+            members.forEach(function(key) {
+                var size = typeSizes[fields[key].type] || 8;
+                var start = Math.ceil(inner.size / size) * size;
+                inner.padding += start - inner.size;
+                inner.align = Math.max(inner.align, size);
+                inner.fields.push({ key : key, offset : start, size : size });
+                inner.size = start + size;
+            });
+            var end = Math.ceil(inner.size / inner.align) * inner.align;
+            inner.padding += end - inner.size;
+            var base = place(end, inner.align);
+            result.padding += inner.padding;
+            inner.fields.forEach(function(field) {
+                result.fields.push({ key : field.key, offset : base + field.offset, size : field.size });
+            });
+        }else{
+            var size = typeSizes[fields[keys[i]].type] || 8;
+            result.fields.push({ key : keys[i], offset : place(size, size), size : size });
+            i++;
+        }
+    }
+
+    result.size = Math.ceil(offset / result.align) * result.align;
+    result.padding += result.size - offset;
+
+    return result;
+}
+
+/* Declares the fields of a struct, "<group>.<field>" keys are declared in a nested struct per group */
+Coder.prototype.genDecl = function(fields, keys) {
+    var str = "";
+    var group = null;
+
+    (keys || Object.keys(fields)).forEach(function(key) {
+        var info = fields[key];
+        var parts = key.split('.');
+
+        if(parts.length > 1 && group !== parts[0]) {
+            str += group ? '\t} ' + group + ';\n' : "";
+            str += '\tstruct {\n';
+            group = parts[0];
+        }else if(parts.length == 1 && group) {
+            str += '\t} ' + group + ';\n';
+            group = null;
+        }
+
+        str += (group ? '\t\t' : '\t') + info.type + ' ' + parts[parts.length - 1] + ';\n';
+    });
+    str += group ? '\t} ' + group + ';\n' : "";
+
+    return str;
+}
+
+/*
+ * Writes <name>/layout.txt: size, padding and cache lines of the model structs as laid out by
+ * orderFields, and an estimate of the cache lines a step touches (Inports, Outports, Signals
+ * and the read side of the Parameters, all fields or only the "hot" ones).
+ */
+Coder.prototype.genLayoutReport = function(json) {
+    var coder = this;
+    var name = json.name.toString();
+    var filename = name + '/layout.txt';
+    var lineSize = 64;
+    var str = 'Struct layout of ' + name + ' (natural alignment, ' + lineSize + ' byte cache lines)\n';
+    var total = { all : 0, hot : 0 };
+
+    function lines(fields) {
+        var set = {};
+        fields.forEach(function(field) {
+            for(var line = Math.floor(field.offset / lineSize); line * lineSize < field.offset + field.size; line++) {
+                set[line] = true;
+            }
+        });
+        return Object.keys(set).length;
+    }
+
+    [['Parameters', json.Parameters, lineSize], ['Inports', json.Inports, 1], ['Outports', json.Outports, 1], ['Signals', json.Signals, 1]].forEach(function(item) {
+        var fields = item[1] || {};
+        var layout = coder.computeLayout(fields, coder.orderFields(fields), item[2]);
+        var hot = layout.fields.filter(function(field) { return fields[field.key].hot; });
+        var touched = { all : Math.ceil(layout.size / lineSize), hot : lines(hot) };
+
+        total.all += touched.all;
+        total.hot += touched.hot;
+        str += '\n' + item[0] + ': size ' + layout.size + ', padding ' + layout.padding + ', cache lines '
+            + touched.all + ' (' + touched.hot + ' with hot fields)\n';
+        layout.fields.forEach(function(field) {
+            str += '\t' + ('     ' + field.offset).slice(-6) + '  ' + ('  ' + field.size).slice(-2) + '  ' + field.key + (fields[field.key].hot ? ' (hot)' : '') + '\n';
+        });
+    });
+
+    str += '\nCache lines touched per step: ' + total.all + ' (' + total.hot + ' if only hot fields are used)\n';
+
+    /* parameter and signal names: before interning one literal per distinct name and one pointer per name,
+       which a shared library relocates at load time (Elf32_Rel 8 bytes, Elf64_Rela 24 bytes) */
+    var names = coder.internNames(json);
+    var n = names.names;
+    var baseline = { 4 : names.literalSize + 4 * n + 8 * n, 8 : names.literalSize + 8 * n + 24 * n };
+    str += '\nNames of rtParamAttribs and rtSignalAttribs: ' + n + ' (' + Object.keys(names.offsets).length + ' distinct names and prefixes in rtStrings)\n';
+    str += '\tliterals and pointers ' + ('       ' + names.literalSize).slice(-8) + ' bytes + pointers ' + 4 * n + '/' + 8 * n + ' + relocations ' + 8 * n + '/' + 24 * n
+        + ' bytes (32/64 bit) = ' + baseline[4] + '/' + baseline[8] + ' bytes\n';
+    str += '\trtStrings and offsets ' + ('       ' + names.size).slice(-8) + ' bytes + offsets ' + 4 * n + ' bytes = ' + (names.size + 4 * n) + ' bytes, also the names of the metadata image\n';
+
+    fs.writeFileSync(filename, str);
+    console.log('layout report=>' + filename);
 }
 
 Coder.prototype.genMakeFile = function(json, filename) {
     var json = this.json;
     var name = json.name.toString();
     
+    var subModels = this.subModels;
+    var coder = this;
+    
     var coderMapper = {
+        "@model-sources@" : function() {
+            return [name + '.c'].concat(subModels.map(function(model) {
+                return name + '_' + model.instance + '.c';
+            }), json.Sequence ? [name + '_sequence.cpp', 'ni_sequence.cpp'] : [], (coder.genFilterStates(json, '') || coder.hasLTIBanks(json) || json.ChangeOnly) ? ['ni_filter.c'] : []).join(' ');
+        },
+        "@cxx-options@" : function() {
+            if(!json.Sequence) {
+                return "";
+            }
+            var sources = name + '_sequence.cpp ni_sequence.cpp';
+            return '\n# The sequence coroutine ("Sequence") is C++20\n'
+                + 'if(MSVC)\n\tset_source_files_properties(' + sources + ' PROPERTIES COMPILE_FLAGS /std:c++20)\n'
+                + 'else()\n\tset_source_files_properties(' + sources + ' PROPERTIES COMPILE_FLAGS -std=c++20)\nendif()\n';
+        },
         "@model-name@" : function() {
            return  name;
         }
@@ -76,25 +580,696 @@ Coder.prototype.genHeader = function(json) {
     var json = this.json;
     var name = json.name.toString();
     var filename = name+'/model.h';
-    var parameters = json.Parameters;
+    var coder = this;
 		
     var coderMapper = {
         "@MODEL_H@" : function() {
            return  name.toUpperCase() + '_H';
         },
-        "@Parameters@" : function() {
+        "@Options@" : function() {
             var str = "";
-            for(var key in parameters) {
-                var param = parameters[key];
-                str += '\t' + param.type + ' ' + key + ';\n';
+            var subsystems = coder.getSubsystems(json);
+            if(subsystems.length) {
+                str += '#define NI_SUBSYSTEM_WORKERS ' + subsystems.workers + '\n';
+            }
+            if(json.SteadyState) {
+                /* "SteadyState" : { ..., "recheck" : <skipped steps after which one step is computed anyway> } */
+                str += '#define NI_STEADY_STATE\n';
+                str += '#define NI_STEADY_RECHECK ' + Number(json.SteadyState.recheck || 100) + '\n';
+            }
+            if(json.Pure) {
+                str += '#define NI_PURE_MODEL\n';
+            }
+            if(json.ParameterQueue) {
+                /* "ParameterQueue" : <capacity of the time-tagged parameter queue>, rounded up to a power of two */
+                str += '#define NI_PARAM_QUEUE_SIZE ' + Math.pow(2, Math.ceil(Math.log(Math.max(Number(json.ParameterQueue), 2)) / Math.LN2)) + '\n';
+                str += '#define NI_PARAMETER_COUNT ' + Object.keys(json.Parameters).length + '\n';
+            }
+            if(json.Deadline) {
+                /* "Deadline" : { "budget" : <fraction of the base rate optional work must complete in> } */
+                str += '#define NI_DEADLINE_BUDGET ' + Number(json.Deadline.budget || 0.8) + '\n';
+            }
+            if(json.Sequence) {
+                /* "Sequence" : { "file" : ..., "frame" : <bytes reserved in the arena for the coroutine frame> }, see genSequence */
+                if(json.Pure) {
+                    throw new Error("Sequence: a model with a sequence is not pure");
+                }
+                if(json.SteadyState) {
+                    /* the sequence writes signals the steady-state check does not watch, a skipped step would ignore them */
+                    throw new Error("Sequence: a model with a sequence can not skip steady steps");
+                }
+                str += '#define NI_SEQUENCE_FRAME_SIZE ' + Math.ceil(Number(json.Sequence.frame || 1024) / 64) * 64 + '\n';
+            }
+            if(json.ChangeOnly) {
+                /* "ChangeOnly" : { "streams" : <number of consumers>, "keyframe" : <calls between keyframes> } */
+                str += '#define NI_CHANGE_STREAMS ' + Number(json.ChangeOnly.streams || 1) + '\n';
+                str += '#define NI_KEYFRAME_INTERVAL ' + Number(json.ChangeOnly.keyframe || 1000) + '\n';
+            }
+            if(json.SharedMemory) {
+                /* "SharedMemory" : true, or the name of the POSIX shared memory segment the signals are published to */
+                str += '#define NI_SHM_PUBLISH\n';
+                str += '#define NI_SHM_NAME "/' + (typeof json.SharedMemory === 'string' ? json.SharedMemory.replace(/^\//, '') : 'ni_' + name) + '"\n';
+            }
+            if(coder.genLTIStates(json, '\t')) {
+                /* "LTI" : { ... }, see getLTIBlocks */
+                str += '#define NI_LTI_STATES\n';
+            }
+            if(coder.genFilterStates(json, '\t')) {
+                /* "Filters" : { ... }, see getFilters */
+                str += '#define NI_FILTERS\n';
             }
             return str;
+        },
+        "@Parameters@" : function() {
+            return coder.genDecl(json.Parameters, coder.orderFields(json.Parameters));
+        },
+        "@Inports-Decl@" : function() {
+            return coder.genDecl(json.Inports, coder.orderFields(json.Inports));
+        },
+        "@Outports-Decl@" : function() {
+            return coder.genDecl(json.Outports, coder.orderFields(json.Outports));
+        },
+        "@Signals-Decl@" : function() {
+            return coder.genDecl(json.Signals, coder.orderFields(json.Signals));
+        },
+        "@LTI-Decl@" : function() {
+            var str = coder.genLTIStates(json, '\t');
+            var include = coder.hasLTIBanks(json) ? '#include "ni_filter.h"\n\n' : '';
+            return str ? '\n#ifdef NI_LTI_STATES\n' + include + '/* States of the LTI blocks */\ntypedef struct {\n' + str + '} LTIStates;\n#endif\n' : str;
+        },
+        "@Filter-Decl@" : function() {
+            var str = coder.genFilterStates(json, '\t');
+            return str ? '\n#ifdef NI_FILTERS\n#include "ni_filter.h"\n\n/* States of the filter banks */\ntypedef struct {\n' + str + '} FilterStates;\n#endif\n' : str;
+        },
+        "@Signal-Indices@" : function() {
+            /* same order as rtSignalAttribs: the signals, then the inports */
+            var signalKeys = Object.keys(json.Signals);
+            var str = "";
+            signalKeys.forEach(function(key, index) {
+                str += '\trtSignalIndex_' + key.replace(/\./g, '_') + ' = ' + index + ',\n';
+            });
+            str += '\tNI_SIGNAL_COUNT = ' + (signalKeys.length + Object.keys(json.Inports).length);
+            return str;
         }
     }
 
     this.gen("templates/model.h", filename, coderMapper);
 }
 
+/*
+ * "Subsystems" : { "<name>" : { "function" : "<fn>", "inputs" : [...], "outputs" : [...] }, ... }
+ *
+ * A subsystem is a "void fn(double timestamp)" function of the implementation. Inputs 
+ * and outputs name the signals, ports or other state it reads and writes. A subsystem
+ * depends on every earlier declared subsystem it shares state with (read after write,
+ * write after read or write after write), so the declaration order is a valid sequential
+ * order. "SubsystemWorkers" overrides the number of worker threads, which defaults to
+ * the widest level of the dependency graph minus one (the step thread works too).
+ * "pure" : true skips a subsystem while its inputs are unchanged (see genSubsystemMemo),
+ * "optional" : true sheds it when the step would miss its "Deadline".
+ */
+Coder.prototype.getSubsystems = function(json) {
+    var decl = json.Subsystems || {};
+    var list = [];
+    var width = {};
+    var maxWidth = 0;
+
+    function shares(a, b) {
+        return a.some(function(x) { return b.indexOf(x) >= 0; });
+    }
+
+    Object.keys(decl).forEach(function(name, index) {
+        var info = decl[name];
+        var inputs = info.inputs || [];
+        var outputs = info.outputs || [];
+        var sub = { name : name, fn : info["function"] || name, inputs : inputs, outputs : outputs, pure : !!info.pure, optional : !!info.optional, deps : [], level : 0 };
+
+        list.forEach(function(prev, prevIndex) {
+            if(shares(inputs, prev.outputs) || shares(outputs, prev.inputs) || shares(outputs, prev.outputs)) {
+                sub.deps.push(prevIndex);
+                sub.level = Math.max(sub.level, prev.level + 1);
+            }
+        });
+
+        width[sub.level] = (width[sub.level] || 0) + 1;
+        maxWidth = Math.max(maxWidth, width[sub.level]);
+        list.push(sub);
+    });
+
+    list.workers = json.SubsystemWorkers !== undefined ? Number(json.SubsystemWorkers) : Math.max(maxWidth - 1, 0);
+
+    return list;
+}
+
+/*
+ * Wraps the pure subsystems in a function that skips them while their inputs and the parameters
+ * are unchanged since their last run, the outputs of the last run are left in place.
+ * Sets sub.entry to the function to schedule.
+ */
+Coder.prototype.genSubsystemMemo = function(json, subsystems) {
+    var coder = this;
+    var str = "";
+
+    subsystems.forEach(function(sub) {
+        sub.entry = sub.fn;
+        if(!sub.pure) {
+            return;
+        }
+
+        var memo = sub.name + '_memo';
+        var fields = {};
+        var inputs = sub.inputs.map(function(key) {
+            var groups = [['rtSignal', json.Signals], ['rtInport', json.Inports], ['rtOutport', json.Outports]];
+            for(var i = 0; i < groups.length; i++) {
+                if(groups[i][1] && groups[i][1][key]) {
+                    fields[key.replace(/\./g, '_')] = groups[i][1][key];
+                    return { field : memo + '.' + key.replace(/\./g, '_'), value : groups[i][0] + '.' + key };
+                }
+            }
+            throw new Error("Subsystem " + sub.name + " is pure, its input " + key + " must be a signal or a port");
+        });
+
+        sub.entry = sub.name + '_Memoized';
+        str += '\n/* ' + sub.name + ' is pure: skipped while its inputs, the parameters and the watched signals are unchanged since its last run */\n';
+        str += 'static struct {\n\tint32_t valid;\n\tuint32_t paramGeneration;\n\tuint32_t probeGeneration;\n' + coder.genDecl(fields) + '} ' + memo + ';\n';
+        str += 'static void ' + sub.entry + '(double timestamp)\n{\n';
+        str += '\tif (' + [memo + '.valid', '(' + memo + '.paramGeneration == NIRT_system.paramGeneration)', '(' + memo + '.probeGeneration == NIRT_system.probeGeneration)'].concat(inputs.map(function(input) {
+            return '(memcmp(&' + input.field + ', &' + input.value + ', sizeof(' + input.field + ')) == 0)';
+        })).join('\n\t\t&& ') + ')\n\t{\n\t\treturn;\n\t}\n\n';
+        str += '\t' + memo + '.valid = 1;\n';
+        str += '\t' + memo + '.paramGeneration = NIRT_system.paramGeneration;\n';
+        str += '\t' + memo + '.probeGeneration = NIRT_system.probeGeneration;\n';
+        inputs.forEach(function(input) {
+            str += '\tmemcpy(&' + input.field + ', &' + input.value + ', sizeof(' + input.field + '));\n';
+        });
+        str += '\t' + sub.fn + '(timestamp);\n}\n';
+    });
+
+    return str;
+}
+
+/*
+ * "LTI" : { "<name>" : { "tf" : { "num" : [...], "den" : [...] }, or
+ *                        "ss" : { "A" : [[...]], "B" : [[...]], "C" : [[...]], "D" : [[...]] },
+ *                        "method" : "zoh" | "tustin", "period" : <ticks>, "count" : <bank size>,
+ *                        "states" : [ "<signal>", ... ] }, ... }
+ *
+ * A linear time-invariant block, continuous in the definition and discretized exactly at
+ * the rate it runs (every "period" base rate ticks, default 1). A coefficient is a number or
+ * a C expression over the parameters, e.g. "-1.0/tau". The discrete matrices are recomputed
+ * by NI_Discretize the first step after a parameter commit, never on other steps.
+ * The states live in the arena (rtModel.lti.<name>), or in the signals named by "states".
+ * A block with a "count" is a bank of count copies sharing the coefficients, with their
+ * inputs, outputs and states stored by element: u[j * count + k] is input j of copy k.
+ * A bank is advanced by NI_LtiBank of ni_filter.c and has at most NI_LTI_BANK_ORDER states.
+ * The implementation calls the kernel of a block every period ticks, e.g. under NI_RATE_HIT.
+ */
+Coder.prototype.getLTIBlocks = function(json) {
+    var decl = json.LTI || {};
+    var coder = this;
+
+    return Object.keys(decl).map(function(name) {
+        var info = decl[name];
+        var block = { name : name, method : String(info.method || "zoh").toLowerCase(), period : Number(info.period || 1), count : Number(info.count || 1), states : info.states || null };
+
+        function fail(msg) {
+            throw new Error("LTI " + name + ": " + msg);
+        }
+        function coefficients(values) {
+            return values.map(function(value) {
+                return coder.ltiCoefficient(json, value);
+            });
+        }
+        function matrix(rows, r, c, what) {
+            if(!rows.length || !rows.every(function(row) { return Array.isArray(row) && row.length == c; }) || rows.length != r) {
+                fail(what + " must be a " + r + "x" + c + " matrix");
+            }
+            return coefficients([].concat.apply([], rows));
+        }
+
+        if(["zoh", "tustin"].indexOf(block.method) < 0) {
+            fail("the method must be zoh or tustin");
+        }
+        if(!(block.period >= 1) || !(block.count >= 1) || (block.period % 1) || (block.count % 1)) {
+            fail("period and count must be positive integers");
+        }
+
+        if(info.tf) {
+            var num = (info.tf.num || []).slice();
+            var den = info.tf.den || [];
+            block.n = den.length - 1;
+            block.m = block.p = 1;
+            if(block.n < 1) {
+                fail("the denominator must be of order 1 or more");
+            }
+            if(!num.length || num.length > den.length) {
+                fail("the numerator must not be of higher order than the denominator");
+            }
+            while(num.length < den.length) {
+                num.unshift(0);
+            }
+            block.num = coefficients(num);
+            block.den = coefficients(den);
+            block.desc = "transfer function of order " + block.n;
+        }else if(info.ss) {
+            var ss = info.ss;
+            block.n = (ss.A || []).length;
+            block.m = ((ss.B || [])[0] || []).length;
+            block.p = (ss.C || []).length;
+            if(!block.n || !block.m || !block.p) {
+                fail("A, B and C must not be empty");
+            }
+            block.A = matrix(ss.A, block.n, block.n, "A");
+            block.B = matrix(ss.B, block.n, block.m, "B");
+            block.C = matrix(ss.C, block.p, block.n, "C");
+            block.D = ss.D ? matrix(ss.D, block.p, block.m, "D") : coefficients(new Array(block.p * block.m).fill(0));
+            block.desc = "state-space of order " + block.n + ", " + block.m + (block.m == 1 ? " input, " : " inputs, ") + block.p + (block.p == 1 ? " output" : " outputs");
+        }else{
+            fail("a block is either a tf or an ss");
+        }
+
+        if(block.count > 1 && block.n > 32) {
+            fail("a bank has at most 32 states (NI_LTI_BANK_ORDER)");
+        }
+        if(block.states) {
+            if(block.count > 1) {
+                fail("a bank keeps its states in the arena");
+            }
+            if(block.states.length != block.n) {
+                fail("states must name " + block.n + " signals");
+            }
+            block.states.forEach(function(key) {
+                if(!json.Signals[key] || (json.Signals[key].type || "double") != "double") {
+                    fail("the state " + key + " must be a double signal");
+                }
+            });
+        }
+        block.desc += ", " + block.method + " every " + (block.period == 1 ? "tick" : block.period + " ticks") + (block.count > 1 ? ", bank of " + block.count : "");
+
+        return block;
+    });
+}
+
+/*
+ * Fields of the LTIStates struct: the states of the LTI blocks that do not keep them in signals,
+ * grouped per instance in a composite model
+ */
+Coder.prototype.genLTIStates = function(json, indent) {
+    var coder = this;
+    var str = "";
+
+    if(json === this.json && this.subModels.length) {
+        this.subModels.forEach(function(model) {
+            var fields = coder.genLTIStates(model.json, indent + '\t');
+            str += fields ? indent + 'struct {\n' + fields + indent + '} ' + model.instance + ';\n' : "";
+        });
+        return str;
+    }
+
+    this.getLTIBlocks(json).forEach(function(block) {
+        if(!block.states) {
+            str += indent + 'double ' + block.name + '[' + block.n * block.count + '];\n';
+        }
+    });
+    return str;
+}
+
+/*
+ * Whether a block of the model, or of an instance in a composite model, is a bank
+ */
+Coder.prototype.hasLTIBanks = function(json) {
+    var coder = this;
+
+    if(json === this.json && this.subModels.length) {
+        return this.subModels.some(function(model) {
+            return coder.hasLTIBanks(model.json);
+        });
+    }
+    return this.getLTIBlocks(json).some(function(block) {
+        return block.count > 1;
+    });
+}
+
+/*
+ * C expression of an LTI coefficient: a number, or a C expression in which the parameters are read from readParam
+ */
+Coder.prototype.ltiCoefficient = function(json, value) {
+    if(typeof value === "number") {
+        return String(value);
+    }
+    return "(" + String(value).replace(/(\d*\.?\d+(?:[eE][-+]?\d+)?)|([A-Za-z_][\w.]*)/g, function(token, number, id) {
+        return (id && json.Parameters[id]) ? "readParam." + id : token;
+    }) + ")";
+}
+
+/*
+ * The discrete matrices of the LTI blocks, LTI_Update to recompute them after a parameter commit,
+ * and one kernel per block: "static double LTI_<name>(double u)" for a single input and output,
+ * otherwise "static void LTI_<name>(const double *u, double *y)". A kernel returns the output of
+ * the current state and input, then advances the state. The matrix products of a single block
+ * are unrolled, a bank calls NI_LtiBank with the discrete matrices of rtLTI, Ad to Dd being
+ * contiguous. The states kept in the arena are the fields of arena.
+ */
+Coder.prototype.genLTI = function(json, arena) {
+    var blocks = this.getLTIBlocks(json);
+    var str = "";
+    var work = 0;
+
+    if(!blocks.length) {
+        return str;
+    }
+
+    function init(values) {
+        return "{ " + values.join(", ") + " }";
+    }
+    function sum(terms) {
+        return terms.length ? terms.join(" + ") : "0.0";
+    }
+
+    str += "/* Discrete matrices of the LTI blocks, recomputed after every parameter commit */\n";
+    str += "static struct {\n\tint32_t valid;\n\tuint32_t paramGeneration;\n";
+    blocks.forEach(function(b) {
+        str += "\tstruct { double Ad[" + b.n * b.n + "], Bd[" + b.n * b.m + "], Cd[" + b.p * b.n + "], Dd[" + b.p * b.m + "]; } " + b.name + ";\n";
+        work = Math.max(work, b.n + b.m);
+    });
+    str += "} rtLTI;\n";
+    str += "static double rtLTIWork[NI_DISCRETIZE_WORK(" + work + ", 0)];\n\n";
+
+    str += "static void LTI_Discretize(void)\n{\n";
+    blocks.forEach(function(b, index) {
+        var M = "rtLTI." + b.name;
+        var call = "NI_Discretize(" + [b.n, b.m, b.p, "A", "B", "C", "D", (b.period == 1 ? "" : b.period + " * ") + Number(json.baserate), (b.method == "zoh" ? "NI_ZOH" : "NI_TUSTIN"),
+            M + ".Ad", M + ".Bd", M + ".Cd", M + ".Dd", "rtLTIWork"].join(", ") + ")";
+
+        str += (index ? "\n" : "") + "\t/* " + b.name + ": " + b.desc + " */\n\t{\n";
+        if(b.num) {
+            str += "\t\tdouble num[" + (b.n + 1) + "] = " + init(b.num) + ";\n";
+            str += "\t\tdouble den[" + (b.n + 1) + "] = " + init(b.den) + ";\n";
+            str += "\t\tdouble A[" + b.n * b.n + "], B[" + b.n + "], C[" + b.n + "], D[1];\n\n";
+            str += "\t\tif ((NI_TransferFunction(" + b.n + ", num, den, A, B, C, D) != NI_OK) || (" + call + " != NI_OK))\n";
+        }else{
+            str += "\t\tdouble A[" + b.n * b.n + "] = " + init(b.A) + ";\n";
+            str += "\t\tdouble B[" + b.n * b.m + "] = " + init(b.B) + ";\n";
+            str += "\t\tdouble C[" + b.p * b.n + "] = " + init(b.C) + ";\n";
+            str += "\t\tdouble D[" + b.p * b.m + "] = " + init(b.D) + ";\n\n";
+            str += "\t\tif (" + call + " != NI_OK)\n";
+        }
+        str += "\t\t{\n\t\t\tSetErrorMessage(\"LTI " + b.name + " cannot be discretized with these parameters, it keeps its last coefficients.\", 0);\n\t\t}\n\t}\n";
+    });
+    str += "\n\trtLTI.valid = 1;\n\trtLTI.paramGeneration = NIRT_system.paramGeneration;\n}\n\n";
+    str += "static void LTI_Update(void)\n{\n\tif (!rtLTI.valid || (rtLTI.paramGeneration != NIRT_system.paramGeneration))\n\t{\n\t\tLTI_Discretize();\n\t}\n}\n";
+
+    blocks.forEach(function(b) {
+        var M = "rtLTI." + b.name;
+        var n = b.n, m = b.m, p = b.p, count = b.count;
+        var siso = (m == 1) && (p == 1) && (count == 1);
+        var x = [], u = [], y = [], xs = [], i, j;
+
+        str += "\n/* " + b.name + ": " + b.desc + " */\n";
+        str += siso ? "static double LTI_" + b.name + "(double u)\n{\n" : "static void LTI_" + b.name + "(const double *u, double *y)\n{\n";
+
+        if(count == 1) {
+            for(i = 0; i < n; i++) {
+                x.push("x" + i);
+                xs.push(b.states ? "rtSignal." + b.states[i] : arena + "." + b.name + "[" + i + "]");
+            }
+            for(j = 0; j < m; j++) {
+                u.push(siso ? "u" : "u[" + j + "]");
+            }
+            for(i = 0; i < p; i++) {
+                y.push(siso ? "y" : "y[" + i + "]");
+            }
+            str += "\tdouble " + x.map(function(name, i) { return name + " = " + xs[i]; }).join(", ") + (siso ? ", y" : "") + ";\n\n";
+            str += "\tLTI_Update();\n";
+            for(i = 0; i < p; i++) {
+                str += "\t" + y[i] + " = " + sum(x.map(function(name, j) { return M + ".Cd[" + (i * n + j) + "] * " + name; }).concat(
+                    u.map(function(name, j) { return M + ".Dd[" + (i * m + j) + "] * " + name; }))) + ";\n";
+            }
+            for(i = 0; i < n; i++) {
+                str += "\t" + xs[i] + " = " + sum(x.map(function(name, j) { return M + ".Ad[" + (i * n + j) + "] * " + name; }).concat(
+                    u.map(function(name, j) { return M + ".Bd[" + (i * m + j) + "] * " + name; }))) + ";\n";
+            }
+            str += siso ? "\treturn y;\n}\n" : "}\n";
+            return;
+        }
+
+        /* a bank: the vector kernel over its copies */
+        str += "\tLTI_Update();\n";
+        str += "\tNI_LtiBank(" + [n, m, p, M + ".Ad", arena + "." + b.name, "u", "y", count].join(", ") + ");\n}\n";
+    });
+
+    return str;
+}
+
+/*
+ * "Filters" : { "<name>" : { "fir" : [ h0, h1, ... ], "channels" : <channels> },
+ *               "<name>" : { "sos" : [ [ b0, b1, b2, a0, a1, a2 ], ... ], "channels" : <channels> }, ... }
+ *
+ * A bank of FIR filters or biquad cascades (second order sections in the order they are
+ * applied) sharing the coefficients, one per channel of a vector. A coefficient is a number
+ * or a C expression over the parameters, as in the LTI blocks. The coefficients are recomputed
+ * the first step after a parameter commit. The state lives in the arena (rtModel.filters.<name>)
+ * and is filtered by the kernels of ni_filter.c, "static void FILTER_<name>(const double *u, double *y)".
+ */
+Coder.prototype.getFilters = function(json) {
+    var decl = json.Filters || {};
+    var coder = this;
+
+    return Object.keys(decl).map(function(name) {
+        var info = decl[name];
+        var filter = { name : name, channels : Number(info.channels || 1) };
+
+        function fail(msg) {
+            throw new Error("Filter " + name + ": " + msg);
+        }
+        function coefficients(values) {
+            return values.map(function(value) {
+                return coder.ltiCoefficient(json, value);
+            });
+        }
+
+        if(!(filter.channels >= 1) || (filter.channels % 1)) {
+            fail("channels must be a positive integer");
+        }
+        if(info.fir) {
+            if(!Array.isArray(info.fir) || !info.fir.length) {
+                fail("fir must list the coefficients");
+            }
+            filter.taps = info.fir.length;
+            filter.fir = coefficients(info.fir);
+            filter.desc = "FIR of " + filter.taps + " taps, " + filter.channels + " channels";
+        }else if(info.sos) {
+            if(!Array.isArray(info.sos) || !info.sos.length || !info.sos.every(function(section) { return Array.isArray(section) && section.length == 6; })) {
+                fail("sos must list sections of 6 coefficients b0, b1, b2, a0, a1, a2");
+            }
+            filter.sections = info.sos.length;
+            filter.sos = coefficients([].concat.apply([], info.sos));
+            filter.desc = filter.sections + " biquad section" + (filter.sections > 1 ? "s, " : ", ") + filter.channels + " channels";
+        }else{
+            fail("a filter is either a fir or an sos");
+        }
+
+        return filter;
+    });
+}
+
+/*
+ * Fields of the FilterStates struct, grouped per instance in a composite model
+ */
+Coder.prototype.genFilterStates = function(json, indent) {
+    var coder = this;
+    var str = "";
+
+    if(json === this.json && this.subModels.length) {
+        this.subModels.forEach(function(model) {
+            var fields = coder.genFilterStates(model.json, indent + '\t');
+            str += fields ? indent + 'struct {\n' + fields + indent + '} ' + model.instance + ';\n' : "";
+        });
+        return str;
+    }
+
+    this.getFilters(json).forEach(function(filter) {
+        if(filter.fir) {
+            str += indent + 'struct {\n' + indent + '\tint32_t pos;\n' + indent + '\tNI_CACHE_ALIGNED double history[NI_FIR_HISTORY(' + filter.taps + ', ' + filter.channels + ')];\n' + indent + '} ' + filter.name + ';\n';
+        }else{
+            str += indent + 'NI_CACHE_ALIGNED double ' + filter.name + '[NI_BIQUAD_STATE(' + filter.sections + ', ' + filter.channels + ')];\n';
+        }
+    });
+    return str;
+}
+
+/*
+ * The coefficients of the filter banks, FILTER_Update to recompute them after a parameter commit,
+ * and one kernel per bank. The states are the fields of arena.
+ */
+Coder.prototype.genFilters = function(json, arena) {
+    var filters = this.getFilters(json);
+    var str = "";
+
+    if(!filters.length) {
+        return str;
+    }
+
+    str += "/* Coefficients of the filter banks, recomputed after every parameter commit */\n";
+    str += "static struct {\n\tint32_t valid;\n\tuint32_t paramGeneration;\n";
+    filters.forEach(function(f) {
+        str += "\tdouble " + f.name + "[" + (f.fir ? f.taps : 5 * f.sections) + "];\n";
+    });
+    str += "} rtFilters;\n\n";
+
+    str += "static void FILTER_Update(void)\n{\n";
+    str += "\tif (rtFilters.valid && (rtFilters.paramGeneration == NIRT_system.paramGeneration))\n\t{\n\t\treturn;\n\t}\n\n";
+    filters.forEach(function(f) {
+        str += "\t/* " + f.name + ": " + f.desc + " */\n\t{\n";
+        if(f.fir) {
+            str += "\t\tconst double h[" + f.taps + "] = { " + f.fir.join(", ") + " };\n\n";
+            str += "\t\tmemcpy(rtFilters." + f.name + ", h, sizeof(h));\n";
+        }else{
+            str += "\t\tconst double sos[" + 6 * f.sections + "] = { " + f.sos.join(", ") + " };\n\n";
+            str += "\t\tif (NI_BiquadCoefficients(" + f.sections + ", sos, rtFilters." + f.name + ") != NI_OK)\n\t\t{\n";
+            str += "\t\t\tSetErrorMessage(\"Filter " + f.name + " has a section with a0 = 0, it keeps its last coefficients.\", 0);\n\t\t}\n";
+        }
+        str += "\t}\n\n";
+    });
+    str += "\trtFilters.valid = 1;\n\trtFilters.paramGeneration = NIRT_system.paramGeneration;\n}\n";
+
+    filters.forEach(function(f) {
+        str += "\n/* " + f.name + ": " + f.desc + " */\n";
+        str += "static void FILTER_" + f.name + "(const double *u, double *y)\n{\n\tFILTER_Update();\n";
+        if(f.fir) {
+            str += "\tNI_FirBank(" + f.taps + ", " + f.channels + ", rtFilters." + f.name + ", " + arena + "." + f.name + ".history, &" + arena + "." + f.name + ".pos, u, y);\n}\n";
+        }else{
+            str += "\tNI_BiquadBank(" + f.sections + ", " + f.channels + ", rtFilters." + f.name + ", " + arena + "." + f.name + ", u, y);\n}\n";
+        }
+    });
+
+    return str;
+}
+
+/*
+ * C string literal of the given bytes, NUL as \0 and other non-printable bytes as hex escapes
+ */
+Coder.prototype.cBytes = function(bytes) {
+    var out = '"';
+    for(var i = 0; i < bytes.length; i++) {
+        var b = bytes[i];
+        var next = i + 1 < bytes.length ? String.fromCharCode(bytes[i + 1]) : '';
+        if(b === 0x22 || b === 0x5c) {
+            out += '\\' + String.fromCharCode(b);
+        }else if(b === 0) {
+            out += '\\0' + (/[0-7]/.test(next) ? '" "' : '');
+        }else if(b < 0x20 || b > 0x7e) {
+            /* an escape swallows following digits, so the literal is split after it */
+            out += '\\x' + b.toString(16) + (/[0-9a-fA-F]/.test(next) ? '" "' : '');
+        }else{
+            out += String.fromCharCode(b);
+        }
+    }
+    return out + '"';
+}
+
+/*
+ * C string literal of the UTF-8 bytes of str followed by a NUL
+ */
+Coder.prototype.cString = function(str) {
+    return this.cBytes(Buffer.concat([Buffer.from(String(str), 'utf8'), Buffer.from([0])]));
+}
+
+/*
+ * Interns the parameter and signal names into rtStrings, see ni_modelframework.h. A name
+ * "<prefix>/<rest>" is stored as the distance back to the entry of its prefix, itself 
+ * interned, and the rest, so every distinct name and prefix is stored once.
+ * The lowercase model name and the external IO names of the metadata image are interned too.
+ * Returns the offsets of the names of the parameters, signals and external IO, the entries and the size of the table
+ */
+Coder.prototype.internNames = function(json) {
+    var name = json.name.toString();
+    var table = { offsets : {}, entries : [], size : 0, names : 0, literalSize : 0, params : [], signals : [] };
+    var literals = {};
+
+    function intern(str) {
+        if(table.offsets.hasOwnProperty(str)) {
+            return table.offsets[str];
+        }
+        var slash = str.lastIndexOf('/');
+        var prefix = slash >= 0 ? intern(str.slice(0, slash)) : -1;
+        var offset = table.size;
+        var distance = prefix >= 0 ? offset - prefix : 0;
+        var entry = { distance : [], rest : str.slice(slash + 1) };
+        do {
+            entry.distance.push((distance & 0x7f) | (distance > 0x7f ? 0x80 : 0));
+            distance = Math.floor(distance / 128);
+        } while(distance > 0);
+        table.entries.push(entry);
+        table.size += entry.distance.length + Buffer.byteLength(entry.rest, 'utf8') + 1;
+        table.offsets[str] = offset;
+        return offset;
+    }
+
+    function add(str) {
+        str = String(str);
+        table.names++;
+        if(!literals.hasOwnProperty(str)) {
+            /* identical literals are merged by the compiler */
+            literals[str] = true;
+            table.literalSize += Buffer.byteLength(str, 'utf8') + 1;
+        }
+        return intern(str);
+    }
+
+    Object.keys(json.Parameters).forEach(function(key) {
+        table.params.push(add(name + '/' + (json.Parameters[key].desc || key)));
+    });
+    /* same order as rtSignalAttribs: the signals, then the inports */
+    [json.Signals, json.Inports].forEach(function(fields) {
+        Object.keys(fields).forEach(function(key) {
+            table.signals.push({ blockname : add(name + '/' + key.replace(/\./g, '/')), signalname : add(fields[key].desc) });
+        });
+    });
+    /* only the metadata image refers to these, they are not counted as attribute table names */
+    table.modelName = intern(name.toLowerCase());
+    table.inports = Object.keys(json.Inports).filter(function(key) {
+        return json.Inports[key].external !== false;
+    }).map(function(key) {
+        return intern(key.replace(/\./g, '_'));
+    });
+    table.outports = Object.keys(json.Outports).map(function(key) {
+        return intern(key.replace(/\./g, '_'));
+    });
+    return table;
+}
+
+/*
+ * Metadata image of the model (NI_MetadataHeader), one entry per parameter, signal, 
+ * external input and external output, in the order of the attribute tables. The names
+ * are offsets in rtStrings, which NIRT_GetModelMetadata appends to the image, so the 
+ * image stores no name of its own.
+ */
+Coder.prototype.genMetadata = function(items, baserate, names) {
+    var counts = { parameter : 0, signal : 0, inport : 0, outport : 0 };
+
+    var entries = items.entries.map(function(entry, index) {
+        var descOffset = entry.descOffset !== undefined ? entry.descOffset : entry.nameOffset;
+        counts[entry.kind]++;
+        return '\t\t{ ' + entry.nameOffset + ', ' + descOffset + ', ' + entry.offset + ', ' + entry.type + ', 1, 2, ' + 2*index + ', 0 }';
+    });
+
+    var str = 'typedef struct {\n';
+    str += '\tNI_MetadataHeader header;\n';
+    str += '\tNI_MetadataEntry entries[' + (entries.length + 1) + '];\n';
+    str += '\tint32_t dims[' + (2*entries.length + 1) + '];\n';
+    str += '} NI_ModelMetadata;\n\n';
+    str += 'const NI_ModelMetadata rtMetadata DataSection(".NIVS.metadata") = {\n';
+    str += '\t{ "NIMD", NI_METADATA_VERSION, sizeof(NI_ModelMetadata) + ' + names.size + ', ' + names.modelName + ', ' + baserate + ', ';
+    str += counts.parameter + ', ' + counts.signal + ', ' + counts.inport + ', ' + counts.outport + ',\n';
+    str += '\t  offsetof(NI_ModelMetadata, entries), offsetof(NI_ModelMetadata, dims), sizeof(NI_ModelMetadata), ' + names.size + ' },\n';
+    str += '\t{\n' + entries.join(',\n') + (entries.length ? '\n' : '\t\t{ 0 }\n') + '\t},\n';
+    str += '\t{ ' + (entries.length ? entries.map(function() { return '1, 1'; }).join(', ') : '0') + ' }\n';
+    str += '};\n';
+    str += 'const NI_MetadataHeader* const rtMetadataImage = &rtMetadata.header;\n';
+    return str;
+}
+
 Coder.prototype.toTypeMacro = function(type) {
     switch(type) {
         case 'double' : {
@@ -122,6 +1297,10 @@ Coder.prototype.genContent = function() {
     var inports = json.Inports;
     var inportKeys = Object.keys(inports);
     var ninports = inportKeys.length;
+    /* inports of a composite model connected to another sub-model are not external IO */
+    var extInportKeys = inportKeys.filter(function(key) {
+        return inports[key].external !== false;
+    });
 
     var outports = json.Outports;
     var outportKeys = Object.keys(outports);
@@ -130,6 +1309,7 @@ Coder.prototype.genContent = function() {
     var signals = json.Signals;
     var signalKeys = Object.keys(signals);
     var nsignals = signalKeys.length;
+    var names = coder.internNames(json);
     
     var coderMapper = {
         "@model-name@" : function() {
@@ -141,41 +1321,21 @@ Coder.prototype.genContent = function() {
         "@baserate@" : function() {
            return  json.baserate;
         },
+        "@Strings@" : function() {
+            return names.entries.length ? names.entries.map(function(entry) {
+                return '\t"' + entry.distance.map(function(b) { return '\\x' + b.toString(16); }).join('') + '" ' + coder.cString(entry.rest);
+            }).join('\n') : '\t""';
+        },
         "@ParameterSize@" : function() {
            return nparams;
         },
-        "@Inports-Decl@" : function() {
-            var str = "";
-            inportKeys.forEach(function(key) {
-                var info = inports[key];
-                str += '\t' + info.type + ' ' + key + ';\n';
-            });
-            return str;
-        },
-        "@Outports-Decl@" : function() {
-            var str = "";
-            outportKeys.forEach(function(key) {
-                var info = outports[key];
-                str += '\t' + info.type + ' ' + key + ';\n';
-            });
-            return str;
-        },
-        "@Signals-Decl@" : function() {
-            var str = "";
-            signalKeys.forEach(function(key) {
-                var info = signals[key];
-                str += '\t' + info.type + ' ' + key + ';\n';
-            });
-            return str;
-        },
         "@rtParamAttribs@" : function() {
             var str = "";
             paramKeys.forEach(function(key, index) {
                 var param = parameters[key];
                 var type = coder.toTypeMacro(param.type);
                 var dimListOffset = 2*index;
-                var desc = param.desc || key;
-                str += '\t{ 0, "' + name+'/'+desc +'", offsetof(Parameters, '+key+'), '+type+', 1, 2, '+dimListOffset+', 0}';
+                str += '\t{ 0, ' + names.params[index] + ', offsetof(Parameters, '+key+'), '+type+', 1, 2, '+dimListOffset+', 0}';
                 str += (index+1) < paramKeys.length ? ',\n' : "";
             });
             return str;
@@ -190,10 +1350,19 @@ Coder.prototype.genContent = function() {
         },
         "@initParams@": function() {
             var str = "";
-            paramKeys.forEach(function(key, index) {
+            var group = null;
+            /* in the order of the Parameters declaration */
+            coder.orderFields(parameters).forEach(function(key, index) {
                 var param = parameters[key];
-                str += '\t'+param.value + ',/*' + key + '*/\n';
+                var parts = key.split('.');
+                if(group !== (parts.length > 1 ? parts[0] : null)) {
+                    str += group ? '\t},\n' : "";
+                    group = parts.length > 1 ? parts[0] : null;
+                    str += group ? '\t{\n' : "";
+                }
+                str += (group ? '\t\t' : '\t')+param.value + ',/*' + key + '*/\n';
             });
+            str += group ? '\t},\n' : "";
             return str;
         },
         "@Parameters_sizes@": function() {
@@ -213,14 +1382,16 @@ Coder.prototype.genContent = function() {
                 var info = signals[key];
                 var dimListOffset = 2*index;
                 var type = coder.toTypeMacro(info.type);
-                str += '\t{ 0, "'+name+'/'+key + '", 0, "' + info.desc + '", 0, 0, ' +type+', 1, 2, '+dimListOffset+', 0},\n';
+                var ids = names.signals[index];
+                str += '\t{ 0, ' + ids.blockname + ', 0, ' + ids.signalname + ', offsetof(ModelArena, signal.'+key+'), 0, ' +type+', 1, 2, '+dimListOffset+', 0},\n';
             });
             
             inportKeys.forEach(function(key, index) {
                 var info = inports[key];
                 var dimListOffset = 2*(index+nsignals);
                 var type = coder.toTypeMacro(info.type);
-                str += '\t{ 0, "'+name+'/'+key + '", 0, "' + info.desc + '", 0, 0, ' +type+', 1, 2, '+dimListOffset+', 0},\n';
+                var ids = names.signals[index+nsignals];
+                str += '\t{ 0, ' + ids.blockname + ', 0, ' + ids.signalname + ', offsetof(ModelArena, inport.'+key+'), 0, ' +type+', 1, 2, '+dimListOffset+', 0},\n';
             });
 
             return str;
@@ -236,52 +1407,175 @@ Coder.prototype.genContent = function() {
             });
             return str;
         },
+        "@Deadbands@" : function() {
+            if(!json.ChangeOnly) {
+                return "";
+            }
+            /* "deadband" of the signals and inports in rtSignalAttribs order, default 0: every change */
+            var str = "\n/* Deadbands of the signals for NIRT_ProbeSignalChanges */\n";
+            str += "const double rtSignalDeadbands[NI_SIGNAL_COUNT + 1] = {\n";
+            signalKeys.forEach(function(key) {
+                str += '\t' + Number(signals[key].deadband || 0) + ',\t/* ' + key + ' */\n';
+            });
+            inportKeys.forEach(function(key) {
+                str += '\t' + Number(inports[key].deadband || 0) + ',\t/* ' + key + ' */\n';
+            });
+            return str + '\t0\n};';
+        },
         "@ExtIOSize@" : function() {
-            return ninports + noutports;
+            return extInportKeys.length + noutports;
         },
         "@InportSize@" : function() {
-            return ninports;
+            return extInportKeys.length;
         },
         "@OutportSize@" : function() {
             return noutports;
         },
         "@rtINAttribs@" : function() {
             var str = "";
-            inportKeys.forEach(function(key, index) {
-                str += '\t{ 0, "'+key+'", '+index+', 0, 1, 1, 1},\n';
+            extInportKeys.forEach(function(key, index) {
+                str += '\t{ 0, "'+key.replace(/\./g, '_')+'", '+index+', 0, 1, 1, 1},\n';
             });
             return str;
         },
         "@rtOutAttribs@" : function() {
             var str = "";
             outportKeys.forEach(function(key, index) {
-                str += '\t{ 0, "'+key+'", '+index+', 1, 1, 1, 1},\n';
+                str += '\t{ 0, "'+key.replace(/\./g, '_')+'", '+index+', 1, 1, 1, 1},\n';
             });
             return str;
         },
-        "@USER_Initialize@": function() {
-            var str = "";
+        "@Metadata@": function() {
+            var entries = [];
+            paramKeys.forEach(function(key, index) {
+                var param = parameters[key];
+                entries.push({ kind : 'parameter', nameOffset : names.params[index], offset : 'offsetof(Parameters, ' + key + ')', type : coder.toTypeMacro(param.type) });
+            });
             signalKeys.forEach(function(key, index) {
                 var info = signals[key];
-                str +='\trtSignalAttribs['+index+'].addr = (uintptr_t)&rtSignal.'+key+';\n'
+                var ids = names.signals[index];
+                entries.push({ kind : 'signal', nameOffset : ids.blockname, descOffset : info.desc !== undefined ? ids.signalname : undefined, offset : 'offsetof(ModelArena, signal.' + key + ')', type : coder.toTypeMacro(info.type) });
             });
-            
             inportKeys.forEach(function(key, index) {
                 var info = inports[key];
-                str +='\trtSignalAttribs['+(nsignals+index)+'].addr = (uintptr_t)&rtInport.'+key+';\n'
+                var ids = names.signals[index + nsignals];
+                entries.push({ kind : 'signal', nameOffset : ids.blockname, descOffset : info.desc !== undefined ? ids.signalname : undefined, offset : 'offsetof(ModelArena, inport.' + key + ')', type : coder.toTypeMacro(info.type) });
             });
-
-           str += "\n"; 
+            extInportKeys.forEach(function(key, index) {
+                entries.push({ kind : 'inport', nameOffset : names.inports[index], offset : index, type : coder.toTypeMacro(inports[key].type) });
+            });
+            outportKeys.forEach(function(key, index) {
+                entries.push({ kind : 'outport', nameOffset : names.outports[index], offset : index, type : coder.toTypeMacro(outports[key].type) });
+            });
+            return coder.genMetadata({ entries : entries }, json.baserate, names);
+        },
+        "@USER_Initialize@": function() {
+            var str = "";
             signalKeys.forEach(function(key, index) {
                 var info = signals[key];
                 var value = info.value || "0";
                 str +='\trtSignal.'+key+'='+value+';\n'
             });
+            if(coder.genLTIStates(json, '\t')) {
+                /* the LTI blocks start at rest */
+                str += '\tmemset(&rtModel.lti, 0, sizeof(rtModel.lti));\n';
+            }
+            if(coder.genFilterStates(json, '\t')) {
+                /* the filter banks start at rest */
+                str += '\tmemset(&rtModel.filters, 0, sizeof(rtModel.filters));\n';
+            }
+            if(coder.genFilterStates(json, '\t') || coder.hasLTIBanks(json)) {
+                /* the kernels of the banks are chosen before the first step */
+                str += '\tNI_FilterKernel();\n';
+            }
+
+            return str;
+        },
+        "@LTI@" : function() {
+            return coder.genLTI(json, 'rtModel.lti');
+        },
+        "@Filters@" : function() {
+            return coder.genFilters(json, 'rtModel.filters');
+        },
+        "@Subsystems@" : function() {
+            var subsystems = coder.getSubsystems(json);
+            var deps = [];
+            var str = "";
+
+            subsystems.forEach(function(sub) {
+                str += 'void ' + sub.fn + '(double timestamp);\n';
+            });
+            str += coder.genSubsystemMemo(json, subsystems);
+            str += (str ? '\n' : '') + 'int32_t SubsystemSize = ' + subsystems.length + ';\n';
+            str += 'NI_Subsystem rtSubsystems[] = {\n';
+            subsystems.forEach(function(sub) {
+                str += '\t{ ' + sub.entry + ', "' + sub.name + '", ' + sub.deps.length + ', ' + deps.length + ', ' + (sub.optional ? 1 : 0) + ', 0, 0.0 },\n';
+                deps = deps.concat(sub.deps);
+            });
+            str += '\t{ NULL, NULL, 0, 0, 0, 0, 0.0 }\n};\n';
+            str += 'int32_t SubsystemDepList[] = {\n';
+            str += deps.length ? '\t' + deps.join(', ') + '\n' : '\t-1\n';
+            str += '};\n';
+
+            return str;
+        },
+        "@SteadyState@" : function() {
+            /*
+             * "SteadyState" : { "states" : { "<signal or outport>" : <tolerance>, ... }, "inputs" : [ "<inport>", ... ] }
+             * Inputs default to all inports.
+             */
+            var steady = json.SteadyState;
+            var str = "";
+            if(!steady) {
+                return str;
+            }
+
+            var states = steady.states || {};
+            var inputs = steady.inputs || extInportKeys;
+            str += '/* Steady-state detection: states whose convergence, with unchanged inputs and parameters, means quiescence */\n';
+            str += 'int32_t SteadyStateSize = ' + Object.keys(states).length + ';\n';
+            str += 'NI_SteadyState rtSteadyStates[] = {\n';
+            Object.keys(states).forEach(function(key) {
+                var group = signals[key] ? 'rtSignal' : 'rtOutport';
+                var info = signals[key] || outports[key];
+                if(!info) {
+                    throw new Error("SteadyState: " + key + " is neither a signal nor an outport");
+                }
+                str += '\t{ &' + group + '.' + key + ', ' + coder.toTypeMacro(info.type) + ', ' + Number(states[key]) + ', 0 },\n';
+            });
+            str += '\t{ NULL }\n};\n';
+            str += 'int32_t SteadyInputSize = ' + inputs.length + ';\n';
+            str += 'int32_t SteadyInputList[] = { ' + inputs.map(function(key) {
+                if(extInportKeys.indexOf(key) < 0) {
+                    throw new Error("SteadyState: " + key + " is not an inport");
+                }
+                return extInportKeys.indexOf(key);
+            }).concat(-1).join(', ') + ' };\n';
+            str += 'double SteadyInputs[' + (inputs.length + 1) + '];\n';
 
             return str;
         },
+        "@Memoization@" : function() {
+            /*
+             * "Pure" : true marks a model whose outputs only depend on its inputs and parameters,
+             * not on its previous steps nor on time.
+             */
+            if(!json.Pure) {
+                return "";
+            }
+
+            return '/* Output memoization: inputs the last computed step of this pure model was computed from */\n'
+                + 'double MemoInputs[' + (extInportKeys.length + 1) + '];\n';
+        },
+        "@USER_PublishOutputs@" : function() {
+            var str = "";
+            outportKeys.forEach(function(key, index) {
+                str += '\t\toutData[' + index + '] = rtOutport.' + key + ';\n';
+            });
+            return str;
+        },
         "@implementation@" : function() {
-            var str = fs.readFileSync(coder.ImplFileName, "utf-8");
+            var str = coder.implementation || fs.readFileSync(coder.ImplFileName, "utf-8");
 
             return str;
         }
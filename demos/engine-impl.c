@@ -1,37 +1,28 @@
 
-/* evaluates a transfer function with numerator [1] and denominator [1 2 3]*/
+/* evaluates the rpm LTI block of the definition, the transfer function
+   num = [c12*a21*b11] den = [1 -(a11+a22) (a11*a22-a12*a21)] discretized with zero-order hold */
 static double engine_RPM_function(double input);
 
 #define MAXIMUM( x, y) ((x)>(y)?(x):(y))
 
 static double engine_RPM_function(double input)
 {
-	double *x = &(rtSignal.state1);
-	double out, a11, a12, a21, b11, c12;
-
-	a11 = readParam.a11;
-	a12 = readParam.a12;
-	a21 = readParam.a21;
-	b11 = readParam.b11;
-	c12 = readParam.c12;
-
-	/* this is an Euler ODE solver at dt = 0.01 */
-	x[0] += 0.01 * (a11 * x[0] + a12 * x[1] + b11 * input); 
-	x[1] += 0.01 * a21 * x[0];
-
-	out = c12 * x[1];
+	double out = LTI_rpm(input);
 
 	if (!rtInport.command_EngineOn && out <= 0.0)
 	{
 		/* if engine is off and the RPM gets to zero (or less), 
 		   then zero out the states so the engine will "stop"; 
 		   otherwise, let the RPM gradually reach zero. */
-		x[0] = 0.0;
-		x[1] = 0.0;
+		rtSignal.state1 = 0.0;
+		rtSignal.state2 = 0.0;
 	}
 	
-	/* Update the engineOn signal */
-	rtSignal.engineOn = (int32_t)rtInport.command_EngineOn;
+	/* Update the engineOn test point, only while someone watches it */
+	if (IS_PROBED(engineOn))
+	{
+		rtSignal.engineOn = (int32_t)rtInport.command_EngineOn;
+	}
 
 	/* never return an rpm value less than zero */
 	rtSignal.RPM = MAXIMUM(out, 0.0);
@@ -0,0 +1,56 @@
+#define CHANNELS	32
+
+/* uniform noise in [-1, 1), a hash of the tick and the channel so the model needs no generator state */
+static double sensors_noise(uint64_t tick, int32_t channel)
+{
+	uint64_t z = tick * CHANNELS + (uint64_t)channel + 0x9E3779B97F4A7C15ULL;
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	z ^= z >> 31;
+	return (double)(z >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+}
+
+/* INPUT: *inData, pointer to inport data at the current timestamp, to be 
+  	      consumed by the function
+   OUTPUT: *outData, pointer to outport data at current time + baserate, to be
+  	       produced by the function
+   INPUT: timestamp, current simulation time */
+int32_t USER_TakeOneStep(double *inData, double *outData, double timestamp) 
+{
+	double raw[CHANNELS], filtered[CHANNELS], sum = 0.0;
+	int32_t c;
+
+	rtInport.level = inData ? inData[0] : 1.0;
+
+	/* the measured signals, one frequency per channel, with noise */
+	for (c = 0; c < CHANNELS; c++)
+	{
+		raw[c] = rtInport.level * sin(2.0 * 3.14159265358979323846 * (c + 1) * readParam.freq * timestamp) 
+			+ readParam.noise * sensors_noise(NI_TICK, c);
+	}
+
+	/* all channels at once: averaging over 8 samples, then the 4th order Butterworth low-pass */
+	FILTER_average(raw, filtered);
+	FILTER_lowpass(filtered, filtered);
+
+	for (c = 0; c < CHANNELS; c++)
+	{
+		sum += filtered[c];
+	}
+
+	rtSignal.raw0 = raw[0];
+	rtSignal.ch0 = filtered[0];
+	rtSignal.ch31 = filtered[CHANNELS - 1];
+	rtSignal.mean = sum / CHANNELS;
+	rtOutport.ch0 = rtSignal.ch0;
+	rtOutport.ch31 = rtSignal.ch31;
+
+	if (outData)
+	{
+		outData[0] = rtOutport.ch0;
+		outData[1] = rtOutport.ch31;
+	}
+
+	return NI_OK;
+}
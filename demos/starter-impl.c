@@ -0,0 +1,45 @@
+/* Engine dynamics. The switching (relay, starter, fuel) is done by the sequence in 
+   starter-sequence.cpp, which runs before each step. */
+
+/* INPUT: *inData, pointer to inport data at the current timestamp, to be 
+  	      consumed by the function
+   OUTPUT: *outData, pointer to outport data at current time + baserate, to be
+  	       produced by the function
+   INPUT: timestamp, current simulation time */
+int32_t USER_TakeOneStep(double *inData, double *outData, double timestamp) 
+{
+	double target = 0.0;
+
+	if (inData)
+	{
+		rtInport.command_Start = inData[0];
+		rtInport.command_Stop = inData[1];
+	}
+
+	/* the starter cranks the engine at about 300 rpm, combustion takes it to idle */
+	if (rtSignal.relay > 0.0)
+	{
+		if ((rtSignal.fuel > 0.0) && (rtSignal.RPM > 150.0))
+		{
+			target = readParam.idleRPM;
+		}
+		else if (rtSignal.starter > 0.0)
+		{
+			target = 300.0;
+		}
+	}
+
+	/* first order response with a time constant of 0.3 s, Euler at dt = 0.01 */
+	rtSignal.RPM += 0.01 * (target - rtSignal.RPM) / 0.3;
+
+	rtOutport.RPM = rtSignal.RPM;
+	rtOutport.phase = rtSignal.phase;
+
+	if (outData)
+	{
+		outData[0] = rtOutport.RPM;
+		outData[1] = rtOutport.phase;
+	}
+
+	return NI_OK;
+}
@@ -0,0 +1,70 @@
+/* Staged engine start: main relay, starter, then fuel and ignition once the engine turns, 
+   starter off at idle. A start that times out switches everything off and counts as a fault.
+   The sequence runs at the start of each tick: it sees the inputs and the engine speed of 
+   the previous tick, and the step of this tick sees what it switched. */
+
+enum { PHASE_OFF, PHASE_POWER, PHASE_CRANKING, PHASE_IGNITION, PHASE_RUNNING, PHASE_STOPPING, PHASE_FAULT };
+
+/* Waits until the engine speed reaches rpm, at most timeout seconds; returns whether it did */
+#define WAIT_FOR_RPM(rpm, timeout, reached) \
+	do { \
+		uint64_t deadline = NI_TICK + (uint64_t)llround((timeout) / USER_BaseRate); \
+		while ((rtSignal.RPM < (rpm)) && (NI_TICK < deadline)) \
+			co_await next_tick(); \
+		reached = (rtSignal.RPM >= (rpm)); \
+	} while (0)
+
+static void SwitchOff()
+{
+	rtSignal.fuel = 0.0;
+	rtSignal.starter = 0.0;
+	rtSignal.relay = 0.0;
+}
+
+NI_Sequence USER_Sequence()
+{
+	bool reached;
+
+	for (;;)
+	{
+		rtSignal.phase = PHASE_OFF;
+		while (rtInport.command_Start <= 0.0)
+			co_await next_tick();
+
+		/* let the supply settle before the starter draws its current */
+		rtSignal.phase = PHASE_POWER;
+		rtSignal.relay = 1.0;
+		co_await wait_for(0.2);
+
+		rtSignal.phase = PHASE_CRANKING;
+		rtSignal.starter = 1.0;
+		WAIT_FOR_RPM(readParam.crankRPM, readParam.crankTimeout, reached);
+
+		if (reached)
+		{
+			rtSignal.phase = PHASE_IGNITION;
+			rtSignal.fuel = 1.0;
+			WAIT_FOR_RPM(0.9 * readParam.idleRPM, readParam.startTimeout, reached);
+		}
+
+		if (!reached)
+		{
+			/* failed start: off, and no new attempt for a second */
+			SwitchOff();
+			rtSignal.phase = PHASE_FAULT;
+			rtSignal.faults += 1.0;
+			co_await wait_for(1.0);
+			continue;
+		}
+
+		rtSignal.phase = PHASE_RUNNING;
+		rtSignal.starter = 0.0;
+		while (rtInport.command_Stop <= 0.0)
+			co_await next_tick();
+
+		rtSignal.phase = PHASE_STOPPING;
+		SwitchOff();
+		while (rtSignal.RPM > 10.0)
+			co_await next_tick();
+	}
+}
@@ -8,9 +8,7 @@
 #define rtDBL	0
 #define rtINT	2
 
-/* Pull in the parameters structure from codegen.c */
-extern Parameters rtParameter[2];
-extern int32_t READSIDE;
+/* The parameters structure, IO and signals are declared in model.h and live in rtModel */
 
 /* !!!! IMPORTANT !!!!
    Accessing parameters values must be done through rtParameter[READSIDE]
@@ -18,24 +16,6 @@ extern int32_t READSIDE;
    !!!! IMPORTANT !!!! */
 #define readParam rtParameter[READSIDE]
 
-/* Define IO and Signals structs */
-typedef struct {
-@Inports-Decl@
-} Inports;
-
-typedef struct {
-@Outports-Decl@
-} Outports;
-
-typedef struct {
-@Signals-Decl@
-} Signals;
-
-/* Instantiate IO and Signals */
-Inports rtInport;
-Outports rtOutport;
-Signals rtSignal;
-
 
 /* INPUT: ptr, base address of where value should be set.
    INPUT: subindex, offset into ptr where value should be set.
@@ -82,12 +62,29 @@ double USER_GetValueByDataType(void* ptr, int32_t subindex, int32_t type)
   }
 }
 
+/* INPUT: type, the user defined type of a parameter or signal
+   RETURN: size of one element of the type in bytes, 0 for an unknown type */
+int32_t USER_DataTypeSize(int32_t type)
+{
+	switch (type) {
+    case rtDBL: {
+      return (int32_t)sizeof(double);
+    }
+    case rtINT: {
+      return (int32_t)sizeof(int32_t);
+    }
+    default: {
+      return 0;
+    }
+  }
+}
+
 /*
 // When a model has parameters of the form: "modelname/parameter", these model parameters are considered global parameters (target scoped) in NI VeriStand
 // When a model has parameters of the form: "modelname/block/paramter" these model parameters are NOT considered global parameters (model scoped) in NI VeriStand
 typedef struct {
   int32_t idx;			// not used
-  char* paramname;	// name of the parameter, e.g., "Amplitude"
+  uint32_t paramname;	// offset of the name of the parameter in rtStrings, e.g., "Amplitude"
   uintptr_t addr;// offset of the parameter in the Parameters struct
   int32_t datatype;		// integer describing a user defined datatype. must have a corresponding entry in GetValueByDataType and SetValueByDataType
   int32_t width;		// size of parameter
@@ -97,9 +94,14 @@ typedef struct {
 } NI_Parameter;
 
 */
+/* Interned parameter and signal names (see ni_modelframework.h), the attribute tables hold offsets */
+const char rtStrings[] DataSection(".NIVS.strings") =
+@Strings@;
+const int32_t NameLayoutVersion DataSection(".NIVS.namelayout") = NI_NAME_LAYOUT_VERSION;
+
 /* Define parameter attributes */
 int32_t ParameterSize DataSection(".NIVS.paramlistsize") = @ParameterSize@;
-NI_Parameter rtParamAttribs[] DataSection(".NIVS.paramlist") = {
+NI_Parameter rtParamAttribs[] DataSection(".NIVS.paramlist2") = {
 @rtParamAttribs@
 };
 int32_t ParamDimList[] DataSection(".NIVS.paramdimlist") =
@@ -129,10 +131,10 @@ ParamSizeWidth Parameters_sizes[] DataSection(".NIVS.defaultparamsizes") = {
 /*
 typedef struct {
   int32_t    idx;		// not used
-  char*  blockname; // name of the block where the signals originates, e.g., "sinewave/sine"
+  uint32_t blockname; // offset in rtStrings of the name of the block where the signals originates, e.g., "sinewave/sine"
   int32_t    portno;	// the port number of the block
-  char* signalname; // name of the signal, e.g., "Sinewave + In1"
-  uintptr_t addr;// address of the storage for the signal
+  uint32_t signalname; // offset in rtStrings of the name of the signal, e.g., "Sinewave + In1"
+  uintptr_t addr;// offset of the storage for the signal in rtModel
   uintptr_t baseaddr;		// not used
   int32_t	 datatype;	// integer describing a user defined datatype. must have a corresponding entry in GetValueByDataType
   int32_t width;		// size of signal
@@ -144,15 +146,16 @@ typedef struct {
 
 /* Define signal attributes */
 int32_t SignalSize DataSection(".NIVS.siglistsize") = @SignalSize@;
-/* must be careful to not get a pointer into .rela.NIVS.siglist */
-/* the addr field for these signals is populated in USER_Initialize */
-NI_Signal rtSignalAttribs[] DataSection(".NIVS.siglist") = {
+/* must be careful to not get a pointer into .rela.NIVS.siglist2: the addr field holds the 
+   offset of the signal in rtModel, so the table is constant and needs no fixing up at startup */
+const NI_Signal rtSignalAttribs[] DataSection(".NIVS.siglist2") = {
 @rtSignalAttribs@
 };
 int32_t SigDimList[] DataSection(".NIVS.sigdimlist") =
 {
 @SigDimList@
 };
+@Deadbands@
 
 /*
 typedef struct {
@@ -176,6 +179,9 @@ NI_ExternalIO rtIOAttribs[] DataSection(".NIVS.extlist") = {
 	{ -1 },
 };
 
+/* Metadata image returned by NIRT_GetModelMetadata, followed by rtStrings when copied. Offsets 
+   instead of pointers keep it relocation-free read-only data. */
+@Metadata@
 /* Model name and build information */
 const char * USER_ModelName DataSection(".NIVS.compiledmodelname") = "@model-name@";
 const char * USER_Builder DataSection(".NIVS.builder") = "@model-desc@";
@@ -193,15 +199,38 @@ typedef struct {
 */
 NI_Task rtTaskAttribs DataSection(".NIVS.tasklist") = { 0 /* must be 0 */, @baserate@ /* must be equal to baserate */, 0, 0 };
 
+/* Linear time-invariant blocks and filter banks of the model definition */
+@LTI@
+@Filters@
 /* RETURN: status, NI_ERROR on error, NI_OK otherwise */
 int32_t USER_Initialize() {
-	/*Initialize signal addresses*/
+	/*Initialize signal values*/
 @USER_Initialize@
 	return NI_OK;
 }
 
 @implementation@
 
+/* Subsystems of the step in dependency order, run by NI_RunSubsystems */
+@Subsystems@
+@SteadyState@
+@Memoization@
+/* OUTPUT: *outData, pointer to outport data, filled with the current outport values
+   RETURN: status, NI_ERROR on error, NI_OK otherwise */
+int32_t USER_PublishOutputs(double *outData) {
+	if (outData) {
+@USER_PublishOutputs@
+	}
+	return NI_OK;
+}
+
+/* RETURN: status, NI_ERROR on error, NI_OK otherwise */
+int32_t USER_PrefaultMemory() {
+	/* IO, signals and parameters live in rtModel, which the framework touches. 
+	   Touch any additional buffers of the model implementation here. */
+	return NI_OK;
+}
+
 /* RETURN: status, NI_ERROR on error, NI_OK otherwise */
 int32_t USER_Finalize() {
 	return NI_OK;
@@ -209,14 +238,9 @@ int32_t USER_Finalize() {
 
 /* Non-supported API */
 
-extern struct { 
-	int32_t stopExecutionFlag;
-	const char *errmsg;
-	void* flip;
-	uint32_t inCriticalSection;
-	int32_t SetParamTxStatus;
-	double timestamp;
-} NIRT_system;
+/* Clock tick words of the sim state: the low and high 32 bits of the tick, only the low ones for a
+   caller that asks NIRT_GetSimState for a single clock tick */
+static int32_t NI_SimStateTickWords = 2;
 
 DLL_EXPORT int32_t NIRT_GetSimState(int32_t* numContStates, char* contStatesNames, double* contStates, int32_t* numDiscStates, char* discStatesNames, double* discStates, int32_t* numClockTicks, char* clockTicksNames, int32_t* clockTicks) 
 {
@@ -224,14 +248,23 @@ DLL_EXPORT int32_t NIRT_GetSimState(int32_t* numContStates, char* contStatesName
 		if (*numContStates < 0 || *numDiscStates < 0 || *numClockTicks < 0) {
 			*numContStates = 0;
 			*numDiscStates = 0;
-			*numClockTicks = 1;
+			*numClockTicks = 2;
 			return NI_OK;
 		}
 	}
 	
-	if (clockTicks && clockTicksNames) {
-		clockTicks[0] = (int)NIRT_system.timestamp;
+	if (clockTicks && clockTicksNames && (!numClockTicks || (*numClockTicks > 0))) {
+		/* the 64 bit base rate tick as clockTick0 (low word) and clockTick1 (high word) */
+		NI_SimStateTickWords = (numClockTicks && (*numClockTicks == 1)) ? 1 : 2;
+		clockTicks[0] = (int32_t)(uint32_t)NIRT_system.tick;
 		strcpy(clockTicksNames, "clockTick0");
+		if (NI_SimStateTickWords > 1) {
+			clockTicks[1] = (int32_t)(uint32_t)(NIRT_system.tick >> 32);
+			strcpy(clockTicksNames + NI_SIMSTATE_NAME_SIZE, "clockTick1");
+		}
+		if (numClockTicks) {
+			*numClockTicks = NI_SimStateTickWords;
+		}
 	}	
 	return NI_OK;
 }
@@ -239,7 +272,17 @@ DLL_EXPORT int32_t NIRT_GetSimState(int32_t* numContStates, char* contStatesName
 DLL_EXPORT int32_t NIRT_SetSimState(double* contStates, double* discStates, int32_t* clockTicks)
 {
 	if (clockTicks) {
-		NIRT_system.timestamp = clockTicks[0];
+		/* the high word too unless the caller took a single clock tick from NIRT_GetSimState */
+		uint64_t tick = (uint64_t)(uint32_t)clockTicks[0];
+		if (NI_SimStateTickWords > 1) {
+			tick |= (uint64_t)(uint32_t)clockTicks[1] << 32;
+		}
+		if (NIRT_system.inCriticalSection > 0) {
+			/* between NIRT_Schedule and NIRT_ModelUpdate the flip semaphore is already held */
+			NI_SetModelTick(tick);
+		} else {
+			NIRT_SetModelTick(tick);
+		}
 	}	
 	return NI_OK;
 }
@@ -1,6 +1,87 @@
 #ifndef @MODEL_H@
 #define @MODEL_H@
-typedef struct {
+
+/* Model options */
+@Options@
+
+/* Each of the two parameter buffers (read side and write side) starts on its own cache line */
+typedef struct NI_CACHE_ALIGNED {
 @Parameters@
 } Parameters;
-#endif//@MODEL_H@
+
+/* Define IO and Signals structs */
+typedef struct {
+@Inports-Decl@
+} Inports;
+
+typedef struct {
+@Outports-Decl@
+} Outports;
+
+typedef struct {
+@Signals-Decl@
+} Signals;
+@LTI-Decl@@Filter-Decl@
+
+/* Index of each signal in rtSignalAttribs */
+enum {
+@Signal-Indices@
+};
+#define NI_PROBE_WORDS	((NI_SIGNAL_COUNT + 31) / 32)
+
+#ifdef NI_SEQUENCE_FRAME_SIZE
+/* The sequence coroutine of the model (ni_sequence.hpp) and its frame */
+typedef struct {
+	uint64_t wakeTick;		/* tick the sequence is resumed at */
+	void *handle;			/* address of the coroutine, NULL if none */
+	int32_t status;			/* NI_ERROR once an exception escaped the sequence */
+	uint32_t frameSize;		/* size of the frame the compiler asked for */
+	NI_CACHE_ALIGNED unsigned char frame[NI_SEQUENCE_FRAME_SIZE];
+} NI_SequenceState;
+#endif
+
+/* All per-model runtime state lives in one contiguous, cache line aligned arena.
+   The fields used on every step (framework state, read side, IO and signals) are
+   packed together at the start; the parameter buffers follow, each padded to its
+   own cache lines so the background writer and the real-time reader never share
+   a line. The metadata tables stay apart in their own .NIVS sections. */
+typedef struct {
+	NI_CACHE_ALIGNED NI_System system;
+	int32_t readSide;
+	uint32_t probed[NI_PROBE_WORDS + 1];
+	Inports inport;
+	Outports outport;
+	Signals signal;
+	Parameters parameters[2];
+#ifdef NI_SEQUENCE_FRAME_SIZE
+	NI_SequenceState sequence;
+#endif
+#ifdef NI_LTI_STATES
+	LTIStates lti;
+#endif
+#ifdef NI_FILTERS
+	FilterStates filters;
+#endif
+} ModelArena;
+
+extern ModelArena rtModel;
+
+#define NIRT_system	(rtModel.system)
+#define READSIDE	(rtModel.readSide)
+#define rtParameter	(rtModel.parameters)
+#define rtInport	(rtModel.inport)
+#define rtOutport	(rtModel.outport)
+#define rtSignal	(rtModel.signal)
+
+/* Current base rate tick. Multi-rate code runs on exact tick phases instead of comparing 
+   floating point times: a rate of every 'period' ticks, offset by 'phase' ticks, is due when
+   	if (NI_RATE_HIT(10, 3)) { ... } */
+#define NI_TICK	(NIRT_system.tick)
+#define NI_RATE_HIT(period, phase)	((NIRT_system.tick % (uint64_t)(period)) == (uint64_t)(phase))
+
+/* Nonzero while the signal is watched, i.e. in the last NIRT_ProbeSignals list or subscribed 
+   with NIRT_SubscribeSignal. Test point signals only need to be computed then:
+   	if (IS_PROBED(engineOn)) rtSignal.engineOn = ...; */
+#define NI_IS_PROBED_INDEX(idx)	((rtModel.probed[(idx) >> 5] >> ((idx) & 31)) & 1u)
+#define IS_PROBED(sig)	NI_IS_PROBED_INDEX(rtSignalIndex_##sig)
+#endif//@MODEL_H@
\ No newline at end of file
@@ -0,0 +1,599 @@
+/*========================================================================*
+ * NI VeriStand Model Framework
+ * Signal archive
+ *
+ * Abstract:
+ *      Writer and reader of the signal archive, see ni_archive.h.
+ *
+ *========================================================================*/
+
+#ifndef _FILE_OFFSET_BITS
+	#define _FILE_OFFSET_BITS	64
+#endif
+
+#include "ni_archive.h"
+#include <string.h>
+
+#if defined (_WIN32)
+	#define NI_FSEEK(f, offset)	_fseeki64((f), (__int64)(offset), SEEK_SET)
+#else
+	#define NI_FSEEK(f, offset)	fseeko((f), (off_t)(offset), SEEK_SET)
+#endif
+
+/* Worst case size of a compressed column: 64 bits for the first value, then 2 + 5 + 6 + 64
+   bits per value (a tick takes at most 4 + 64 bits) */
+#define NI_COLUMN_BOUND(samples)	(8 + ((size_t)(samples) * 77 + 7) / 8 + 8)
+
+typedef struct {
+	unsigned char *p;
+	uint64_t acc;
+	int bits;
+} NI_BitWriter;
+
+typedef struct {
+	const unsigned char *p;
+	const unsigned char *end;
+	uint64_t acc;
+	int bits;
+} NI_BitReader;
+
+static int NI_LeadingZeros(uint64_t x)
+{
+#if defined (__GNUC__)
+	return __builtin_clzll(x);
+#else
+	int n = 0;
+	while (!(x & 0x8000000000000000ULL))
+	{
+		x <<= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+static int NI_TrailingZeros(uint64_t x)
+{
+#if defined (__GNUC__)
+	return __builtin_ctzll(x);
+#else
+	int n = 0;
+	while (!(x & 1))
+	{
+		x >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+/* Appends the n (at most 32) low bits of value, most significant first */
+static void NI_PutBits32(NI_BitWriter *w, uint64_t value, int n)
+{
+	w->acc = (w->acc << n) | (value & ((1ULL << n) - 1));
+	w->bits += n;
+	while (w->bits >= 8)
+	{
+		w->bits -= 8;
+		*w->p++ = (unsigned char)(w->acc >> w->bits);
+	}
+}
+
+static void NI_PutBits(NI_BitWriter *w, uint64_t value, int n)
+{
+	if (n > 32)
+	{
+		NI_PutBits32(w, value >> 32, n - 32);
+		n = 32;
+	}
+	NI_PutBits32(w, value, n);
+}
+
+/* Pads the last byte with zeros */
+static void NI_FlushBits(NI_BitWriter *w)
+{
+	if (w->bits > 0)
+	{
+		NI_PutBits32(w, 0, 8 - w->bits);
+	}
+}
+
+/* Returns the next n (at most 32) bits; reads zeros past the end */
+static uint64_t NI_GetBits32(NI_BitReader *r, int n)
+{
+	if (r->bits < n)
+	{
+		while (r->bits <= 56)
+		{
+			r->acc = (r->acc << 8) | ((r->p < r->end) ? *r->p++ : 0);
+			r->bits += 8;
+		}
+	}
+	r->bits -= n;
+	return (r->acc >> r->bits) & ((1ULL << n) - 1);
+}
+
+static uint64_t NI_GetBits(NI_BitReader *r, int n)
+{
+	uint64_t high = 0;
+
+	if (n > 32)
+	{
+		high = NI_GetBits32(r, n - 32) << 32;
+		n = 32;
+	}
+	return high | NI_GetBits32(r, n);
+}
+
+/* Ticks: the first one, then the change of the difference to the previous tick in
+   buckets '0' (none), '10' 7 bits, '110' 9 bits, '1110' 12 bits, '1111' 64 bits */
+static unsigned char *NI_EncodeTicks(unsigned char *out, const uint64_t *ticks, uint32_t samples)
+{
+	NI_BitWriter w = { out, 0, 0 };
+	int64_t delta = 0, dod;
+	uint32_t i;
+
+	NI_PutBits(&w, ticks[0], 64);
+	for (i = 1; i < samples; i++)
+	{
+		dod = (int64_t)(ticks[i] - ticks[i - 1]) - delta;
+		delta = (int64_t)(ticks[i] - ticks[i - 1]);
+
+		if (dod == 0)
+		{
+			NI_PutBits32(&w, 0, 1);
+		}
+		else if ((dod >= -63) && (dod <= 64))
+		{
+			NI_PutBits32(&w, 2, 2);
+			NI_PutBits32(&w, (uint64_t)(dod + 63), 7);
+		}
+		else if ((dod >= -255) && (dod <= 256))
+		{
+			NI_PutBits32(&w, 6, 3);
+			NI_PutBits32(&w, (uint64_t)(dod + 255), 9);
+		}
+		else if ((dod >= -2047) && (dod <= 2048))
+		{
+			NI_PutBits32(&w, 14, 4);
+			NI_PutBits32(&w, (uint64_t)(dod + 2047), 12);
+		}
+		else
+		{
+			NI_PutBits32(&w, 15, 4);
+			NI_PutBits(&w, (uint64_t)dod, 64);
+		}
+	}
+
+	NI_FlushBits(&w);
+	return w.p;
+}
+
+static void NI_DecodeTicks(NI_BitReader *r, uint64_t *ticks, uint32_t samples)
+{
+	int64_t delta = 0;
+	uint32_t i;
+
+	ticks[0] = NI_GetBits(r, 64);
+	for (i = 1; i < samples; i++)
+	{
+		if (NI_GetBits32(r, 1) == 0)
+		{
+		}
+		else if (NI_GetBits32(r, 1) == 0)
+		{
+			delta += (int64_t)NI_GetBits32(r, 7) - 63;
+		}
+		else if (NI_GetBits32(r, 1) == 0)
+		{
+			delta += (int64_t)NI_GetBits32(r, 9) - 255;
+		}
+		else if (NI_GetBits32(r, 1) == 0)
+		{
+			delta += (int64_t)NI_GetBits32(r, 12) - 2047;
+		}
+		else
+		{
+			delta += (int64_t)NI_GetBits(r, 64);
+		}
+		ticks[i] = ticks[i - 1] + (uint64_t)delta;
+	}
+}
+
+/* Values: the first one, then the XOR with the previous value: '0' if equal, '10' and the
+   meaningful bits if they fit into the window of the previous XOR, otherwise '11', 5 bits
+   leading zeros, 6 bits length of the meaningful bits (0 for 64) and the meaningful bits */
+static unsigned char *NI_EncodeValues(unsigned char *out, const double *values, uint32_t samples)
+{
+	NI_BitWriter w = { out, 0, 0 };
+	uint64_t previous, current, x;
+	int leading = 65, trailing = 0, l, t;
+	uint32_t i;
+
+	memcpy(&previous, &values[0], sizeof(uint64_t));
+	NI_PutBits(&w, previous, 64);
+	for (i = 1; i < samples; i++)
+	{
+		memcpy(&current, &values[i], sizeof(uint64_t));
+		x = current ^ previous;
+		previous = current;
+
+		if (x == 0)
+		{
+			NI_PutBits32(&w, 0, 1);
+			continue;
+		}
+
+		l = NI_LeadingZeros(x);
+		t = NI_TrailingZeros(x);
+		l = (l > 31) ? 31 : l;
+		if ((l >= leading) && (t >= trailing))
+		{
+			NI_PutBits32(&w, 2, 2);
+			NI_PutBits(&w, x >> trailing, 64 - leading - trailing);
+		}
+		else
+		{
+			leading = l;
+			trailing = t;
+			NI_PutBits32(&w, 3, 2);
+			NI_PutBits32(&w, (uint64_t)leading, 5);
+			NI_PutBits32(&w, (uint64_t)((64 - leading - trailing) & 63), 6);
+			NI_PutBits(&w, x >> trailing, 64 - leading - trailing);
+		}
+	}
+
+	NI_FlushBits(&w);
+	return w.p;
+}
+
+/* Decodes the first samples values of a column */
+static void NI_DecodeValues(NI_BitReader *r, double *values, uint32_t samples)
+{
+	uint64_t previous;
+	int leading = 0, length = 64;
+	uint32_t i;
+
+	previous = NI_GetBits(r, 64);
+	memcpy(&values[0], &previous, sizeof(double));
+	for (i = 1; i < samples; i++)
+	{
+		if (NI_GetBits32(r, 1) != 0)
+		{
+			if (NI_GetBits32(r, 1) != 0)
+			{
+				leading = (int)NI_GetBits32(r, 5);
+				length = (int)NI_GetBits32(r, 6);
+				length = (length == 0) ? 64 : length;
+			}
+			previous ^= NI_GetBits(r, length) << (64 - leading - length);
+		}
+		memcpy(&values[i], &previous, sizeof(double));
+	}
+}
+
+ /*========================================================================*
+ * Function: NI_ArchiveWriteBlock
+ *
+ * Abstract:
+ *	Compresses the samples of the current block, writes the block and adds it to the index.
+========================================================================*/
+static int32_t NI_ArchiveWriteBlock(NI_ArchiveWriter *writer)
+{
+	uint32_t channels = writer->header.channelCount;
+	uint32_t *columns = (uint32_t *)writer->buffer;
+	unsigned char *p = writer->buffer + (channels + 2) * sizeof(uint32_t);
+	NI_ArchiveBlock *block;
+	uint32_t c;
+
+	if (writer->samples == 0)
+	{
+		return NI_OK;
+	}
+
+	if (writer->header.blockCount == writer->blockCapacity)
+	{
+		NI_ArchiveBlock *blocks = (NI_ArchiveBlock *)realloc(writer->blocks, (size_t)(writer->blockCapacity * 2 + 16) * sizeof(NI_ArchiveBlock));
+		if (blocks == NULL)
+		{
+			return NI_ERROR;
+		}
+		writer->blocks = blocks;
+		writer->blockCapacity = writer->blockCapacity * 2 + 16;
+	}
+
+	columns[0] = (uint32_t)(p - writer->buffer);
+	p = NI_EncodeTicks(p, writer->ticks, writer->samples);
+	for (c = 0; c < channels; c++)
+	{
+		columns[c + 1] = (uint32_t)(p - writer->buffer);
+		p = NI_EncodeValues(p, writer->values + (size_t)c * writer->header.blockSamples, writer->samples);
+	}
+	columns[channels + 1] = (uint32_t)(p - writer->buffer);
+
+	block = &writer->blocks[writer->header.blockCount];
+	block->firstTick = writer->ticks[0];
+	block->lastTick = writer->ticks[writer->samples - 1];
+	block->offset = writer->offset;
+	block->samples = writer->samples;
+	block->size = columns[channels + 1];
+
+	if (fwrite(writer->buffer, block->size, 1, writer->file) != 1)
+	{
+		return NI_ERROR;
+	}
+
+	writer->offset += block->size;
+	writer->header.blockCount++;
+	writer->samples = 0;
+	return NI_OK;
+}
+
+int32_t NI_ArchiveCreate(NI_ArchiveWriter *writer, const char *path, double baseRate, int32_t channelCount,
+						 const char *const *names, uint32_t blockSamples)
+{
+	int32_t i;
+
+	memset(writer, 0, sizeof(NI_ArchiveWriter));
+	if ((channelCount < 0) || (path == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	memcpy(writer->header.magic, NI_ARCHIVE_MAGIC, 4);
+	writer->header.version = NI_ARCHIVE_VERSION;
+	writer->header.baseRate = baseRate;
+	writer->header.channelCount = (uint32_t)channelCount;
+	writer->header.blockSamples = (blockSamples > 0) ? blockSamples : NI_ARCHIVE_BLOCK_SAMPLES;
+	for (i = 0; i < channelCount; i++)
+	{
+		writer->header.nameSize += (uint32_t)strlen(names[i]) + 1;
+	}
+
+	writer->ticks = (uint64_t *)malloc(writer->header.blockSamples * sizeof(uint64_t));
+	writer->values = (double *)malloc(((size_t)channelCount + 1) * writer->header.blockSamples * sizeof(double));
+	writer->bufferSize = ((size_t)channelCount + 2) * sizeof(uint32_t) + ((size_t)channelCount + 1) * NI_COLUMN_BOUND(writer->header.blockSamples);
+	writer->buffer = (unsigned char *)malloc(writer->bufferSize);
+	writer->file = fopen(path, "wb");
+	if (!writer->ticks || !writer->values || !writer->buffer || !writer->file ||
+		(fwrite(&writer->header, sizeof(NI_ArchiveHeader), 1, writer->file) != 1))
+	{
+		NI_ArchiveFinish(writer);
+		return NI_ERROR;
+	}
+
+	for (i = 0; i < channelCount; i++)
+	{
+		fwrite(names[i], strlen(names[i]) + 1, 1, writer->file);
+	}
+	writer->offset = sizeof(NI_ArchiveHeader) + writer->header.nameSize;
+	return ferror(writer->file) ? NI_ERROR : NI_OK;
+}
+
+int32_t NI_ArchiveAppend(NI_ArchiveWriter *writer, uint64_t tick, const double *values)
+{
+	uint64_t previous;
+	uint32_t c;
+
+	/* ticks must increase, also across blocks */
+	previous = (writer->samples > 0) ? writer->ticks[writer->samples - 1] :
+		(writer->header.blockCount > 0) ? writer->blocks[writer->header.blockCount - 1].lastTick : 0;
+	if ((writer->file == NULL) || ((writer->header.sampleCount > 0) && (tick <= previous)))
+	{
+		return NI_ERROR;
+	}
+
+	writer->ticks[writer->samples] = tick;
+	for (c = 0; c < writer->header.channelCount; c++)
+	{
+		writer->values[(size_t)c * writer->header.blockSamples + writer->samples] = values[c];
+	}
+	writer->samples++;
+	writer->header.sampleCount++;
+
+	return (writer->samples == writer->header.blockSamples) ? NI_ArchiveWriteBlock(writer) : NI_OK;
+}
+
+int32_t NI_ArchiveFinish(NI_ArchiveWriter *writer)
+{
+	int32_t retval = NI_ERROR;
+
+	if (writer->file != NULL)
+	{
+		retval = NI_ArchiveWriteBlock(writer);
+		writer->header.indexOffset = writer->offset;
+		if ((retval == NI_OK) && (writer->header.blockCount > 0) &&
+			(fwrite(writer->blocks, sizeof(NI_ArchiveBlock), (size_t)writer->header.blockCount, writer->file) != writer->header.blockCount))
+		{
+			retval = NI_ERROR;
+		}
+		if ((retval == NI_OK) && ((NI_FSEEK(writer->file, 0) != 0) || (fwrite(&writer->header, sizeof(NI_ArchiveHeader), 1, writer->file) != 1)))
+		{
+			retval = NI_ERROR;
+		}
+		if (fclose(writer->file) != 0)
+		{
+			retval = NI_ERROR;
+		}
+	}
+
+	free(writer->ticks);
+	free(writer->values);
+	free(writer->buffer);
+	free(writer->blocks);
+	memset(writer, 0, sizeof(NI_ArchiveWriter));
+	return retval;
+}
+
+int32_t NI_ArchiveOpen(NI_ArchiveReader *reader, const char *path)
+{
+	NI_ArchiveHeader *header = &reader->header;
+	uint32_t c;
+	char *name;
+
+	memset(reader, 0, sizeof(NI_ArchiveReader));
+	reader->file = fopen(path, "rb");
+	if ((reader->file == NULL) || (fread(header, sizeof(NI_ArchiveHeader), 1, reader->file) != 1) ||
+		(memcmp(header->magic, NI_ARCHIVE_MAGIC, 4) != 0) || (header->version != NI_ARCHIVE_VERSION) ||
+		(header->indexOffset == 0) || (header->blockSamples == 0))
+	{
+		NI_ArchiveClose(reader);
+		return NI_ERROR;
+	}
+
+	reader->names = (char *)malloc(header->nameSize + 1);
+	reader->channelNames = (const char **)calloc(header->channelCount + 1, sizeof(const char *));
+	reader->blocks = (NI_ArchiveBlock *)malloc((size_t)(header->blockCount + 1) * sizeof(NI_ArchiveBlock));
+	reader->columns = (uint32_t *)malloc((header->channelCount + 2) * sizeof(uint32_t));
+	reader->ticks = (uint64_t *)malloc(header->blockSamples * sizeof(uint64_t));
+	reader->values = (double *)malloc(header->blockSamples * sizeof(double));
+	reader->bufferSize = NI_COLUMN_BOUND(header->blockSamples);
+	reader->buffer = (unsigned char *)malloc(reader->bufferSize);
+	if (!reader->names || !reader->channelNames || !reader->blocks || !reader->columns || !reader->ticks || !reader->values || !reader->buffer ||
+		(fread(reader->names, header->nameSize, 1, reader->file) != 1 && header->nameSize > 0) ||
+		(NI_FSEEK(reader->file, header->indexOffset) != 0) ||
+		(fread(reader->blocks, sizeof(NI_ArchiveBlock), (size_t)header->blockCount, reader->file) != header->blockCount))
+	{
+		NI_ArchiveClose(reader);
+		return NI_ERROR;
+	}
+
+	reader->names[header->nameSize] = '\0';
+	for (c = 0, name = reader->names; c < header->channelCount; c++)
+	{
+		/* missing names of a corrupt file are empty */
+		reader->channelNames[c] = name;
+		name += (name < reader->names + header->nameSize) ? strlen(name) + 1 : 0;
+	}
+	return NI_OK;
+}
+
+void NI_ArchiveClose(NI_ArchiveReader *reader)
+{
+	if (reader->file != NULL)
+	{
+		fclose(reader->file);
+	}
+	free(reader->names);
+	free((void *)reader->channelNames);
+	free(reader->blocks);
+	free(reader->columns);
+	free(reader->ticks);
+	free(reader->values);
+	free(reader->buffer);
+	memset(reader, 0, sizeof(NI_ArchiveReader));
+}
+
+const char *NI_ArchiveChannelName(const NI_ArchiveReader *reader, int32_t index)
+{
+	return ((index >= 0) && ((uint32_t)index < reader->header.channelCount)) ? reader->channelNames[index] : NULL;
+}
+
+int32_t NI_ArchiveFindChannel(const NI_ArchiveReader *reader, const char *name)
+{
+	uint32_t c;
+
+	for (c = 0; c < reader->header.channelCount; c++)
+	{
+		if (strcmp(reader->channelNames[c], name) == 0)
+		{
+			return (int32_t)c;
+		}
+	}
+	return -1;
+}
+
+/* Reads the bytes of column index of a block into the buffer */
+static int32_t NI_ArchiveReadColumn(NI_ArchiveReader *reader, const NI_ArchiveBlock *block, uint32_t index, NI_BitReader *r)
+{
+	uint32_t begin = reader->columns[index];
+	uint32_t size = reader->columns[index + 1] - begin;
+
+	if ((reader->columns[index + 1] < begin) || (reader->columns[index + 1] > block->size) || (size > reader->bufferSize) ||
+		(NI_FSEEK(reader->file, block->offset + begin) != 0) || (fread(reader->buffer, size, 1, reader->file) != 1 && size > 0))
+	{
+		return NI_ERROR;
+	}
+
+	reader->bytesRead += size;
+	r->p = reader->buffer;
+	r->end = reader->buffer + size;
+	r->acc = 0;
+	r->bits = 0;
+	return NI_OK;
+}
+
+int32_t NI_ArchiveRead(NI_ArchiveReader *reader, uint64_t firstTick, uint64_t lastTick, const int32_t *channels,
+					   int32_t numChannels, uint64_t *ticks, double *values, uint64_t capacity, uint64_t *count)
+{
+	uint32_t numColumns = reader->header.channelCount + 2;
+	uint64_t lo = 0, hi = reader->header.blockCount, b;
+	uint32_t first, last, i;
+	NI_BitReader r;
+	int32_t c;
+
+	*count = 0;
+	for (c = 0; c < numChannels; c++)
+	{
+		if ((channels[c] < 0) || ((uint32_t)channels[c] >= reader->header.channelCount))
+		{
+			return NI_ERROR;
+		}
+	}
+
+	/* First block that ends at or after firstTick */
+	while (lo < hi)
+	{
+		b = lo + (hi - lo) / 2;
+		if (reader->blocks[b].lastTick < firstTick)
+		{
+			lo = b + 1;
+		}
+		else
+		{
+			hi = b;
+		}
+	}
+
+	for (b = lo; (b < reader->header.blockCount) && (reader->blocks[b].firstTick <= lastTick) && (*count < capacity); b++)
+	{
+		const NI_ArchiveBlock *block = &reader->blocks[b];
+
+		if ((block->samples == 0) || (block->samples > reader->header.blockSamples) || (NI_FSEEK(reader->file, block->offset) != 0) ||
+			(fread(reader->columns, numColumns * sizeof(uint32_t), 1, reader->file) != 1) ||
+			(NI_ArchiveReadColumn(reader, block, 0, &r) != NI_OK))
+		{
+			return NI_ERROR;
+		}
+		reader->blocksRead++;
+		NI_DecodeTicks(&r, reader->ticks, block->samples);
+
+		/* Samples of the block in the range, as many as fit */
+		for (first = 0; (first < block->samples) && (reader->ticks[first] < firstTick); first++)
+		{
+		}
+		for (last = first; (last < block->samples) && (reader->ticks[last] <= lastTick) && (*count + (last - first) < capacity); last++)
+		{
+		}
+
+		for (c = 0; (c < numChannels) && (last > first); c++)
+		{
+			double *out = values + (size_t)*count * numChannels + c;
+
+			if (NI_ArchiveReadColumn(reader, block, (uint32_t)channels[c] + 1, &r) != NI_OK)
+			{
+				return NI_ERROR;
+			}
+			NI_DecodeValues(&r, reader->values, last);
+			for (i = first; i < last; i++, out += numChannels)
+			{
+				*out = reader->values[i];
+			}
+		}
+
+		memcpy(ticks + *count, reader->ticks + first, (last - first) * sizeof(uint64_t));
+		*count += last - first;
+	}
+
+	return NI_OK;
+}
@@ -0,0 +1,196 @@
+/*========================================================================*
+ * NI VeriStand Model Framework
+ * Signal archive
+ *
+ * Abstract:
+ *      Columnar on-disk archive of signal traces. A sample is a tick and one value
+ *      per channel. Samples are grouped into blocks of a fixed number of samples,
+ *      and each column of a block is compressed on its own: the ticks with
+ *      delta-of-delta encoding, the values of a channel by XOR with the previous
+ *      value (as in the Gorilla time series database). Traces of model signals,
+ *      sampled every tick and mostly smooth or constant, shrink to a few bits per
+ *      value.
+ *
+ *      The index at the end of the file holds the tick range of every block, and
+ *      every block starts with the offsets of its columns. A query therefore reads
+ *      and decompresses only the blocks overlapping its tick range, and of those
+ *      only the tick column and the columns of its channels.
+ *
+ *      File: NI_ArchiveHeader, channel names, blocks, index (one NI_ArchiveBlock
+ *      per block). Block: channelCount + 2 uint32_t offsets of the columns in the
+ *      block (ticks, channel 0, ..., end of the block), then the columns.
+ *
+ *========================================================================*/
+
+#ifndef NI_ARCHIVE_H
+#define NI_ARCHIVE_H
+
+#include "ni_modelframework.h"
+
+#define NI_ARCHIVE_MAGIC	"NIAR"
+#define NI_ARCHIVE_VERSION	1
+
+/* Default number of samples per block */
+#define NI_ARCHIVE_BLOCK_SAMPLES	4096
+
+typedef struct {
+  char magic[4];			/* NI_ARCHIVE_MAGIC */
+  uint32_t version;			/* NI_ARCHIVE_VERSION */
+  double baseRate;			/* seconds per tick */
+  uint32_t channelCount;	/* number of channels */
+  uint32_t blockSamples;	/* samples per block, the last block may hold fewer */
+  uint32_t nameSize;		/* size of the channel names, NUL terminated, following the header */
+  uint32_t reserved;
+  uint64_t indexOffset;		/* offset of the index, 0 while the archive is written */
+  uint64_t blockCount;		/* number of blocks */
+  uint64_t sampleCount;		/* number of samples */
+} NI_ArchiveHeader;
+
+typedef struct {
+  uint64_t firstTick;		/* tick of the first sample */
+  uint64_t lastTick;		/* tick of the last sample */
+  uint64_t offset;			/* offset of the block in the file */
+  uint32_t samples;			/* number of samples */
+  uint32_t size;			/* size of the block */
+} NI_ArchiveBlock;
+
+typedef struct {
+	FILE *file;
+	NI_ArchiveHeader header;
+	uint64_t offset;			/* end of the file */
+	uint64_t *ticks;			/* samples of the current block, */
+	double *values;				/* by channel: values[channel * blockSamples + sample] */
+	uint32_t samples;
+	NI_ArchiveBlock *blocks;	/* index */
+	uint64_t blockCapacity;
+	unsigned char *buffer;		/* the encoded block */
+	size_t bufferSize;
+} NI_ArchiveWriter;
+
+typedef struct {
+	FILE *file;
+	NI_ArchiveHeader header;
+	char *names;
+	const char **channelNames;
+	NI_ArchiveBlock *blocks;
+	uint32_t *columns;			/* column offsets of the block read */
+	unsigned char *buffer;		/* a compressed column */
+	size_t bufferSize;
+	uint64_t *ticks;			/* decoded ticks of the block read */
+	double *values;				/* decoded values of a column */
+	double blocksRead;			/* number of blocks read */
+	double bytesRead;			/* number of compressed bytes read */
+} NI_ArchiveReader;
+
+ /*========================================================================*
+ * Function: NI_ArchiveCreate
+ *
+ * Abstract:
+ *	Creates an archive file for the given channels.
+ *
+ * Input Parameters:
+ *	path			: path of the file
+ *	baseRate		: seconds per tick
+ *	channelCount	: number of channels
+ *	names			: names of the channels
+ *	blockSamples	: samples per block, 0 for NI_ARCHIVE_BLOCK_SAMPLES
+ *
+ * Output Parameters:
+ *	writer			: the writer
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+int32_t NI_ArchiveCreate(NI_ArchiveWriter *writer, const char *path, double baseRate, int32_t channelCount,
+						 const char *const *names, uint32_t blockSamples);
+
+ /*========================================================================*
+ * Function: NI_ArchiveAppend
+ *
+ * Abstract:
+ *	Appends a sample. A full block is compressed and written to the file.
+ *
+ * Input Parameters:
+ *	tick	: tick of the sample, greater than the tick of the previous sample
+ *	values	: one value per channel
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the tick does not increase or writing failed
+ *========================================================================*/
+int32_t NI_ArchiveAppend(NI_ArchiveWriter *writer, uint64_t tick, const double *values);
+
+ /*========================================================================*
+ * Function: NI_ArchiveFinish
+ *
+ * Abstract:
+ *	Writes the last block and the index and closes the file. The archive is only
+ *	readable once finished.
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+int32_t NI_ArchiveFinish(NI_ArchiveWriter *writer);
+
+ /*========================================================================*
+ * Function: NI_ArchiveOpen
+ *
+ * Abstract:
+ *	Opens a finished archive and reads its index.
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the file does not exist or is not a valid archive
+ *========================================================================*/
+int32_t NI_ArchiveOpen(NI_ArchiveReader *reader, const char *path);
+
+ /*========================================================================*
+ * Function: NI_ArchiveClose
+ *
+ * Abstract:
+ *	Closes the archive.
+ *========================================================================*/
+void NI_ArchiveClose(NI_ArchiveReader *reader);
+
+ /*========================================================================*
+ * Function: NI_ArchiveChannelName
+ *
+ * Returns:
+ *	the name of a channel, NULL if the index is out of bounds
+ *========================================================================*/
+const char *NI_ArchiveChannelName(const NI_ArchiveReader *reader, int32_t index);
+
+ /*========================================================================*
+ * Function: NI_ArchiveFindChannel
+ *
+ * Returns:
+ *	the index of the channel with the given name, -1 if there is none
+ *========================================================================*/
+int32_t NI_ArchiveFindChannel(const NI_ArchiveReader *reader, const char *name);
+
+ /*========================================================================*
+ * Function: NI_ArchiveRead
+ *
+ * Abstract:
+ *	Reads the samples from firstTick to lastTick of some channels. Only the blocks
+ *	overlapping the range, and in them only the needed columns, are decompressed.
+ *	If there are more samples than capacity, the first capacity samples are returned;
+ *	read on from the tick after the last one returned.
+ *
+ * Input Parameters:
+ *	firstTick	: first tick of the range
+ *	lastTick	: last tick of the range
+ *	channels	: indices of the channels
+ *	numChannels	: length of channels
+ *	capacity	: number of samples ticks and values can hold
+ *
+ * Output Parameters:
+ *	ticks		: ticks of the samples
+ *	values		: values of the samples, numChannels per sample
+ *	count		: number of samples returned
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if a channel is out of bounds or the file is corrupt
+ *========================================================================*/
+int32_t NI_ArchiveRead(NI_ArchiveReader *reader, uint64_t firstTick, uint64_t lastTick, const int32_t *channels,
+					   int32_t numChannels, uint64_t *ticks, double *values, uint64_t capacity, uint64_t *count);
+
+#endif
@@ -0,0 +1,249 @@
+/*========================================================================*
+ * NI VeriStand Model Framework
+ * Signal archive benchmark
+ *
+ * Abstract:
+ *      Records a trace of all signals of a model (one NIRT_ProbeSignals per tick)
+ *      into a signal archive (ni_archive.h) and prints the compression ratio, the
+ *      encode and decode throughput of the full trace, and the cost of a range
+ *      query of one channel over a tenth of the trace. The decoded trace is
+ *      checked against the recorded one bit for bit.
+ *
+ *      Usage: archivebench [-n ticks] [-b samples] [-o file] model_library
+ *        -n ticks   : number of ticks to record (default: 1000000)
+ *        -b samples : samples per block (default: NI_ARCHIVE_BLOCK_SAMPLES)
+ *        -o file    : path of the archive (default: trace.niar)
+ *
+ *========================================================================*/
+
+#ifndef _GNU_SOURCE
+	#define _GNU_SOURCE
+#endif
+
+#include "ni_archive.h"
+#include <dlfcn.h>
+#include <unistd.h>
+
+#define NSEC_PER_SEC	1000000000LL
+#define MAX_SIGNALS		1024
+
+typedef int32_t (*InitializeFn)(double, double*, int32_t*, int32_t*, int32_t*);
+typedef int32_t (*ScheduleFn)(double*, double*, double*, int32_t*);
+typedef int32_t (*VoidFn)(void);
+typedef int32_t (*ProbeFn)(int32_t*, int32_t, double*, int32_t*);
+typedef int32_t (*SignalSpecFn)(int32_t*, char*, int32_t*, char*, int32_t*, int32_t*, char*, int32_t*, int32_t*, int32_t*, int32_t*);
+
+static int64_t NowNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+ /*========================================================================*
+ * Function: RecordTrace
+ *
+ * Abstract:
+ *	Loads the model library, runs it and records the values of all signals every tick.
+ *
+ * Output Parameters:
+ *	names		: names of the signals
+ *	numSignals	: number of signals
+ *	values		: ticks * numSignals values, allocated
+ *
+ * Returns:
+ *	NI_OK if no error
+ ========================================================================*/
+static int32_t RecordTrace(const char *library, int64_t ticks, double *baseRate, char names[][256], int32_t *numSignals, double **values)
+{
+	void *lib = dlopen(library, RTLD_NOW | RTLD_LOCAL);
+	InitializeFn initialize;
+	ScheduleFn schedule;
+	VoidFn start, update, finalize;
+	ProbeFn probe;
+	SignalSpecFn signalSpec;
+	double simTime, inData[MAX_SIGNALS], outData[MAX_SIGNALS], probed[MAX_SIGNALS + 2];
+	int32_t numIn, numOut, numTasks, indices[MAX_SIGNALS + 2], len, i;
+	int64_t tick;
+
+	if (lib == NULL)
+	{
+		fprintf(stderr, "%s\n", dlerror());
+		return NI_ERROR;
+	}
+
+	initialize = (InitializeFn)dlsym(lib, "NIRT_InitializeModel");
+	schedule = (ScheduleFn)dlsym(lib, "NIRT_Schedule");
+	start = (VoidFn)dlsym(lib, "NIRT_ModelStart");
+	update = (VoidFn)dlsym(lib, "NIRT_ModelUpdate");
+	finalize = (VoidFn)dlsym(lib, "NIRT_FinalizeModel");
+	probe = (ProbeFn)dlsym(lib, "NIRT_ProbeSignals");
+	signalSpec = (SignalSpecFn)dlsym(lib, "NIRT_GetSignalSpec");
+
+	if (!initialize || !schedule || !start || !update || !finalize || !probe || !signalSpec ||
+		(initialize((double)ticks, baseRate, &numIn, &numOut, &numTasks) != NI_OK) || (numIn > MAX_SIGNALS) || (numOut > MAX_SIGNALS) || (start() != NI_OK))
+	{
+		fprintf(stderr, "Cannot start the model with %s.\n", library);
+		return NI_ERROR;
+	}
+
+	/* with index -1 and no ID the call returns the number of signals */
+	i = -1;
+	*numSignals = signalSpec(&i, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+	*numSignals = (*numSignals > MAX_SIGNALS) ? MAX_SIGNALS : *numSignals;
+	for (i = 0; i < *numSignals; i++)
+	{
+		int32_t index = i, siglen = 255;
+		memset(names[i], 0, 256);
+		signalSpec(&index, NULL, NULL, NULL, NULL, NULL, names[i], &siglen, NULL, NULL, NULL);
+	}
+
+	*values = (double *)malloc((size_t)ticks * (size_t)(*numSignals + 1) * sizeof(double));
+	if (*values == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	/* list of all signals, the first entry is the bookkeeping index */
+	indices[0] = 0;
+	for (i = 0; i < *numSignals; i++)
+	{
+		indices[i + 1] = i;
+	}
+	indices[*numSignals + 1] = -1;
+	memset(inData, 0, sizeof(inData));
+
+	for (tick = 0; tick < ticks; tick++)
+	{
+		schedule(inData, outData, &simTime, NULL);
+		len = MAX_SIGNALS + 2;
+		probe(indices, *numSignals + 2, probed, &len);
+		memcpy(*values + (size_t)tick * *numSignals, probed + 2, (size_t)*numSignals * sizeof(double));
+		update();
+	}
+
+	finalize();
+	dlclose(lib);
+	return NI_OK;
+}
+
+int main(int argc, char **argv)
+{
+	static char names[MAX_SIGNALS][256];
+	const char *channelNames[MAX_SIGNALS];
+	const char *path = "trace.niar";
+	int64_t ticks = 1000000, begin, encodeNs, decodeNs, queryNs;
+	uint32_t blockSamples = 0;
+	NI_ArchiveWriter writer;
+	NI_ArchiveReader reader;
+	double baseRate, *trace = NULL, *decoded, rawBytes, fileBytes;
+	uint64_t *decodedTicks, count, tick, first, last;
+	int32_t numSignals = 0, channels[MAX_SIGNALS], i, mismatches = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:b:o:")) != -1)
+	{
+		switch (c)
+		{
+			case 'n': ticks = atoll(optarg); break;
+			case 'b': blockSamples = (uint32_t)atoi(optarg); break;
+			case 'o': path = optarg; break;
+			default:
+				fprintf(stderr, "Usage: %s [-n ticks] [-b samples] [-o file] model_library\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if ((optind + 1 > argc) || (ticks < 10))
+	{
+		fprintf(stderr, "Usage: %s [-n ticks] [-b samples] [-o file] model_library\n", argv[0]);
+		return 1;
+	}
+
+	if ((RecordTrace(argv[optind], ticks, &baseRate, names, &numSignals, &trace) != NI_OK) || (numSignals < 1))
+	{
+		return 1;
+	}
+
+	for (i = 0; i < numSignals; i++)
+	{
+		channelNames[i] = names[i];
+		channels[i] = i;
+	}
+
+	/* encode */
+	begin = NowNs();
+	if (NI_ArchiveCreate(&writer, path, baseRate, numSignals, channelNames, blockSamples) != NI_OK)
+	{
+		fprintf(stderr, "Cannot create %s.\n", path);
+		return 1;
+	}
+	for (tick = 0; tick < (uint64_t)ticks; tick++)
+	{
+		NI_ArchiveAppend(&writer, tick, trace + tick * numSignals);
+	}
+	if (NI_ArchiveFinish(&writer) != NI_OK)
+	{
+		fprintf(stderr, "Cannot write %s.\n", path);
+		return 1;
+	}
+	encodeNs = NowNs() - begin;
+
+	/* decode everything and compare */
+	decoded = (double *)malloc((size_t)ticks * (size_t)numSignals * sizeof(double));
+	decodedTicks = (uint64_t *)malloc((size_t)ticks * sizeof(uint64_t));
+	if (!decoded || !decodedTicks || (NI_ArchiveOpen(&reader, path) != NI_OK))
+	{
+		fprintf(stderr, "Cannot open %s.\n", path);
+		return 1;
+	}
+	fileBytes = (double)reader.header.indexOffset + (double)reader.header.blockCount * sizeof(NI_ArchiveBlock);
+
+	begin = NowNs();
+	if (NI_ArchiveRead(&reader, 0, (uint64_t)ticks, channels, numSignals, decodedTicks, decoded, (uint64_t)ticks, &count) != NI_OK)
+	{
+		fprintf(stderr, "Cannot read %s.\n", path);
+		return 1;
+	}
+	decodeNs = NowNs() - begin;
+
+	mismatches = (count != (uint64_t)ticks) || (memcmp(decoded, trace, (size_t)ticks * (size_t)numSignals * sizeof(double)) != 0);
+	for (tick = 0; (tick < count) && !mismatches; tick++)
+	{
+		mismatches = (decodedTicks[tick] != tick);
+	}
+
+	/* range query: the last channel over the middle tenth of the trace */
+	first = (uint64_t)(ticks / 2);
+	last = first + (uint64_t)(ticks / 10) - 1;
+	reader.blocksRead = 0;
+	reader.bytesRead = 0;
+	begin = NowNs();
+	NI_ArchiveRead(&reader, first, last, &channels[numSignals - 1], 1, decodedTicks, decoded, (uint64_t)ticks, &count);
+	queryNs = NowNs() - begin;
+	for (tick = 0; (tick < count) && !mismatches; tick++)
+	{
+		uint64_t t = first + tick;
+		mismatches = (decodedTicks[tick] != t) || (memcmp(&decoded[tick], &trace[t * numSignals + numSignals - 1], sizeof(double)) != 0);
+	}
+	mismatches |= (count != last - first + 1);
+
+	rawBytes = (double)ticks * (double)(numSignals + 1) * sizeof(double);
+	printf("\n*******************************************************************************\n");
+	printf("%d signals, %lld ticks, %u samples per block, %llu blocks\n", numSignals, (long long)ticks,
+		reader.header.blockSamples, (unsigned long long)reader.header.blockCount);
+	printf("size          : %.0f bytes raw, %.0f bytes archived, ratio %.1f, %.2f bits per value\n",
+		rawBytes, fileBytes, rawBytes / fileBytes, fileBytes * 8.0 / ((double)ticks * (double)(numSignals + 1)));
+	printf("encode        : %.1f ms, %.3f GB/s raw\n", (double)encodeNs / 1e6, rawBytes / (double)encodeNs);
+	printf("decode        : %.1f ms, %.3f GB/s raw\n", (double)decodeNs / 1e6, rawBytes / (double)decodeNs);
+	printf("range query   : %s, %llu samples, %.3f ms, %.0f blocks and %.0f bytes read\n", NI_ArchiveChannelName(&reader, numSignals - 1),
+		(unsigned long long)count, (double)queryNs / 1e6, reader.blocksRead, reader.bytesRead);
+	printf("round trip    : %s\n", mismatches ? "MISMATCH" : "bit exact");
+	printf("*******************************************************************************\n");
+
+	NI_ArchiveClose(&reader);
+	free(trace);
+	free(decoded);
+	free(decodedTicks);
+	return mismatches ? 1 : 0;
+}
@@ -0,0 +1,1365 @@
+/*========================================================================*
+ * NI VeriStand Model Framework
+ * Model server client
+ *
+ * Abstract:
+ *      Implements the NIRT_* API of a model by forwarding every call to the model
+ *      server (ni_server.c) over the shared memory rings described in ni_server.h,
+ *      so that a host loads this library in place of the model library while the
+ *      model runs in its own process.
+ *
+ *      The segment name is NI_SERVER_NAME, or the NI_SERVER_NAME environment
+ *      variable when set. The first call attaches to the server; only one client
+ *      can be attached at a time. Calls from several threads are serialized.
+ *      Arguments larger than a message (see the -k option of the server) are
+ *      truncated like the probe lists, or the call returns NI_ERROR when that
+ *      would change its meaning (vectors, batches and parameter images).
+ *
+ *========================================================================*/
+
+#include "ni_server.h"
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifndef NI_SERVER_NAME
+	#define NI_SERVER_NAME	"/ni_model_server"
+#endif
+
+static struct {
+	pthread_mutex_t lock;
+	NI_ServerHeader *header;
+	const char *errmsg;		/* error of the client itself, e.g. no server */
+	int32_t numIn;
+	int32_t numOut;
+	uint32_t spinLimit;		/* spins before yielding while waiting for a response */
+	uint32_t epoch;			/* session of this client, see NI_ServerHeader */
+	int32_t tickWords;		/* clock tick words the last NIRT_GetSimState returned */
+} NI_Client = { PTHREAD_MUTEX_INITIALIZER, NULL, NULL, 0, 0, 0, 0, 2 };
+
+ /*========================================================================*
+ * Function: NI_ClientAttach
+ *
+ * Abstract:
+ *	Maps the segment of the server, registers as its client and starts a new
+ *	session, in which the server has emptied the rings.
+ *
+ * Returns:
+ *	NI_OK if no error
+ ========================================================================*/
+static int32_t NI_ClientAttach(void)
+{
+	const char *name = getenv("NI_SERVER_NAME") ? getenv("NI_SERVER_NAME") : NI_SERVER_NAME;
+	NI_ServerHeader *header;
+	struct stat st;
+	void *segment;
+	int32_t pid;
+	uint32_t epoch;
+	int fd;
+
+	if (NI_Client.header != NULL)
+	{
+		return NI_OK;
+	}
+
+	fd = shm_open(name, O_RDWR, 0);
+	if (fd < 0)
+	{
+		NI_Client.errmsg = "The model server is not running.";
+		return NI_ERROR;
+	}
+
+	segment = ((fstat(fd, &st) == 0) && (st.st_size >= (off_t)sizeof(NI_ServerHeader))) ? mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+	close(fd);
+	if (segment == MAP_FAILED)
+	{
+		NI_Client.errmsg = "Cannot map the model server segment.";
+		return NI_ERROR;
+	}
+
+	header = (NI_ServerHeader *)segment;
+	if ((memcmp(header->magic, NI_SERVER_MAGIC, 4) != 0) || (header->version != NI_SERVER_VERSION) || (header->segmentSize > (uint32_t)st.st_size))
+	{
+		munmap(segment, (size_t)st.st_size);
+		NI_Client.errmsg = "The model server segment is not valid.";
+		return NI_ERROR;
+	}
+
+	/* a client that exited without detaching leaves its pid behind */
+	pid = header->clientPid;
+	if (((pid != 0) && (kill(pid, 0) == 0 || errno != ESRCH)) || !__sync_bool_compare_and_swap(&header->clientPid, pid, (int32_t)getpid()))
+	{
+		munmap(segment, (size_t)st.st_size);
+		NI_Client.errmsg = "Another client is attached to the model server.";
+		return NI_ERROR;
+	}
+
+	/* the rings may still hold requests and responses of that client, the server empties them before starting the session */
+	epoch = header->epoch + 1;
+	NI_AtomicStore32(&header->requestedEpoch, epoch);
+	while (NI_AtomicLoad32(&header->epoch) != epoch)
+	{
+		if ((kill(header->serverPid, 0) != 0) && (errno == ESRCH))
+		{
+			header->clientPid = 0;
+			munmap(segment, (size_t)st.st_size);
+			NI_Client.errmsg = "The model server exited.";
+			return NI_ERROR;
+		}
+		sched_yield();
+	}
+
+	NI_Client.spinLimit = (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? NI_SERVER_SPIN : 0;
+	NI_Client.numIn = header->numInports;
+	NI_Client.numOut = header->numOutports;
+	NI_Client.epoch = epoch;
+	NI_Client.header = header;
+	NI_Client.errmsg = NULL;
+	return NI_OK;
+}
+
+ /*========================================================================*
+ * Function: NI_ClientDetach
+ *
+ * Abstract:
+ *	Unregisters from the server and unmaps its segment.
+ ========================================================================*/
+static void NI_ClientDetach(void)
+{
+	if (NI_Client.header != NULL)
+	{
+		NI_Client.header->clientPid = 0;
+		munmap(NI_Client.header, NI_Client.header->segmentSize);
+		NI_Client.header = NULL;
+	}
+}
+
+ /*========================================================================*
+ * Function: NI_ClientBegin
+ *
+ * Abstract:
+ *	Locks the client and returns the request slot to fill, NULL (and unlocked) if
+ *	there is no server.
+ ========================================================================*/
+static NI_ServerMessage *NI_ClientBegin(uint32_t op)
+{
+	NI_ServerMessage *request;
+
+	pthread_mutex_lock(&NI_Client.lock);
+	if (NI_ClientAttach() != NI_OK)
+	{
+		pthread_mutex_unlock(&NI_Client.lock);
+		return NULL;
+	}
+
+	request = NI_SERVER_SLOT(NI_Client.header, NI_Client.header->requestOffset, NI_Client.header->request.head);
+	memset(request, 0, sizeof(NI_ServerMessage));
+	request->op = op;
+	return request;
+}
+
+ /*========================================================================*
+ * Function: NI_ClientCall
+ *
+ * Abstract:
+ *	Sends the request filled since NI_ClientBegin and waits for the response. The
+ *	caller reads the response and then calls NI_ClientEnd. Responses of an earlier
+ *	session are dropped.
+ *
+ * Returns:
+ *	the response, NULL (and unlocked) if the server died
+ ========================================================================*/
+static const NI_ServerMessage *NI_ClientCall(void)
+{
+	NI_ServerHeader *header = NI_Client.header;
+	const NI_ServerMessage *response;
+	uint32_t tail = header->response.tail;
+	uint32_t spins = 0;
+
+	NI_AtomicStore32(&header->request.head, header->request.head + 1);
+
+	for (;;)
+	{
+		if (NI_AtomicLoad32(&header->response.head) != tail)
+		{
+			response = NI_SERVER_SLOT(header, header->responseOffset, tail);
+			if (response->epoch == NI_Client.epoch)
+			{
+				return response;
+			}
+
+			NI_AtomicStore32(&header->response.tail, ++tail);
+			continue;
+		}
+
+		if (++spins < NI_Client.spinLimit)
+		{
+			NI_CpuRelax();
+			continue;
+		}
+
+		if (((spins & 0xFFF) == 0) && (kill(header->serverPid, 0) != 0) && (errno == ESRCH))
+		{
+			NI_Client.errmsg = "The model server exited.";
+			NI_ClientDetach();
+			pthread_mutex_unlock(&NI_Client.lock);
+			return NULL;
+		}
+		sched_yield();
+	}
+}
+
+static void NI_ClientEnd(void)
+{
+	NI_AtomicStore32(&NI_Client.header->response.tail, NI_Client.header->response.tail + 1);
+	pthread_mutex_unlock(&NI_Client.lock);
+}
+
+ /*========================================================================*
+ * Function: NI_ClientSimpleCall
+ *
+ * Abstract:
+ *	Forwards a call whose only result is its return value.
+ ========================================================================*/
+static int32_t NI_ClientSimpleCall(NI_ServerMessage *request)
+{
+	const NI_ServerMessage *response;
+	int32_t retval;
+
+	if ((request == NULL) || ((response = NI_ClientCall()) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_InitializeModel(double finaltime, double *outTimeStep, int32_t *num_in, int32_t *num_out, int32_t* num_tasks)
+{
+	NI_ServerMessage *request = NI_ClientBegin(NI_OP_INITIALIZE);
+	const NI_ServerMessage *response;
+	int32_t retval;
+
+	if ((request == NULL) || ((request->scalars[0] = finaltime), (response = NI_ClientCall()) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	if (outTimeStep) *outTimeStep = response->scalars[0];
+	if (num_in) *num_in = response->args[0];
+	if (num_out) *num_out = response->args[1];
+	if (num_tasks) *num_tasks = response->args[2];
+	NI_Client.numIn = response->args[0];
+	NI_Client.numOut = response->args[1];
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_ModelStart(void)
+{
+	return NI_ClientSimpleCall(NI_ClientBegin(NI_OP_MODELSTART));
+}
+
+DLL_EXPORT int32_t NIRT_Schedule(double *inData, double *outData, double *outTime, int32_t *dispatchtasks)
+{
+	NI_ServerMessage *request = NI_ClientBegin(NI_OP_SCHEDULE);
+	const NI_ServerMessage *response;
+	int32_t retval;
+
+	UNUSED_PARAMETER(dispatchtasks);
+	if (request == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	if (inData)
+	{
+		memcpy(NI_SERVER_PAYLOAD(request), inData, (size_t)NI_Client.numIn * sizeof(double));
+		request->count = (uint32_t)NI_Client.numIn;
+	}
+
+	if ((response = NI_ClientCall()) == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	if (outData)
+	{
+		memcpy(outData, NI_SERVER_PAYLOAD(response), response->count * sizeof(double));
+	}
+	if (outTime)
+	{
+		*outTime = response->scalars[0];
+	}
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_ModelUpdate(void)
+{
+	return NI_ClientSimpleCall(NI_ClientBegin(NI_OP_MODELUPDATE));
+}
+
+DLL_EXPORT int32_t NIRT_PostOutputs(double *outData)
+{
+	const NI_ServerMessage *response;
+	int32_t retval;
+
+	if ((NI_ClientBegin(NI_OP_POSTOUTPUTS) == NULL) || ((response = NI_ClientCall()) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	if (outData)
+	{
+		memcpy(outData, NI_SERVER_PAYLOAD(response), response->count * sizeof(double));
+	}
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_FinalizeModel(void)
+{
+	int32_t retval = NI_ClientSimpleCall(NI_ClientBegin(NI_OP_FINALIZE));
+
+	pthread_mutex_lock(&NI_Client.lock);
+	NI_ClientDetach();
+	pthread_mutex_unlock(&NI_Client.lock);
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_SetParameter(int32_t index, int32_t subindex, double val)
+{
+	NI_ServerMessage *request = NI_ClientBegin(NI_OP_SETPARAMETER);
+
+	if (request != NULL)
+	{
+		request->args[0] = index;
+		request->args[1] = subindex;
+		request->scalars[0] = val;
+	}
+	return NI_ClientSimpleCall(request);
+}
+
+DLL_EXPORT int32_t NIRT_GetParameter(int32_t index, int32_t subindex, double* val)
+{
+	NI_ServerMessage *request = NI_ClientBegin(NI_OP_GETPARAMETER);
+	const NI_ServerMessage *response;
+	int32_t retval;
+
+	if ((request == NULL) || ((request->args[0] = index), (request->args[1] = subindex), (response = NI_ClientCall()) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	if (val)
+	{
+		*val = response->scalars[0];
+	}
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_ProbeSignals(int32_t *sigindices, int32_t numsigs, double *value, int32_t* len)
+{
+	NI_ServerMessage *request = NI_ClientBegin(NI_OP_PROBESIGNALS);
+	const NI_ServerMessage *response;
+	double *indices;
+	int32_t i, retval;
+
+	if (request == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	/* lists longer than a message are truncated, as a short value buffer truncates them */
+	numsigs = (numsigs < (int32_t)NI_Client.header->capacity) ? numsigs : (int32_t)NI_Client.header->capacity;
+	indices = NI_SERVER_PAYLOAD(request);
+	for (i = 0; i < numsigs; i++)
+	{
+		indices[i] = (double)sigindices[i];
+	}
+	request->args[0] = numsigs;
+	request->args[1] = *len;
+	request->count = (uint32_t)numsigs;
+
+	if ((response = NI_ClientCall()) == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	memcpy(value, NI_SERVER_PAYLOAD(response), (size_t)response->args[0] * sizeof(double));
+	*len = response->args[0];
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_SubscribeSignal(int32_t index, int32_t subscribe)
+{
+	NI_ServerMessage *request = NI_ClientBegin(NI_OP_SUBSCRIBESIGNAL);
+
+	if (request != NULL)
+	{
+		request->args[0] = index;
+		request->args[1] = subscribe;
+	}
+	return NI_ClientSimpleCall(request);
+}
+
+DLL_EXPORT int32_t NIRT_QueueParameter(double timestamp, int32_t index, int32_t subindex, double value)
+{
+	NI_ServerMessage *request = NI_ClientBegin(NI_OP_QUEUEPARAMETER);
+
+	if (request != NULL)
+	{
+		request->scalars[0] = timestamp;
+		request->args[0] = index;
+		request->args[1] = subindex;
+		request->scalars[1] = value;
+	}
+	return NI_ClientSimpleCall(request);
+}
+
+DLL_EXPORT int32_t NIRT_ModelError(char* errmsg, int32_t* msglen)
+{
+	NI_ServerMessage *request = NI_ClientBegin(NI_OP_MODELERROR);
+	const NI_ServerMessage *response;
+	int32_t retval;
+
+	if ((request == NULL) || ((request->args[0] = *msglen), (response = NI_ClientCall()) == NULL))
+	{
+		/* the error of the client itself */
+		const char *msg = NI_Client.errmsg ? NI_Client.errmsg : "The model server is not running.";
+
+		if (*msglen > (int32_t)strlen(msg))
+		{
+			*msglen = (int32_t)strlen(msg);
+		}
+		strncpy(errmsg, msg, (size_t)*msglen);
+		return NI_ERROR;
+	}
+
+	*msglen = response->args[0];
+	memcpy(errmsg, NI_SERVER_PAYLOAD(response), (size_t)(*msglen > 0 ? *msglen : 0));
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_GetModelTick(uint64_t* tick)
+{
+	const NI_ServerMessage *response;
+	int32_t retval;
+
+	if ((NI_ClientBegin(NI_OP_GETMODELTICK) == NULL) || ((response = NI_ClientCall()) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	if (tick)
+	{
+		*tick = response->tick;
+	}
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_SetModelTick(uint64_t tick)
+{
+	NI_ServerMessage *request = NI_ClientBegin(NI_OP_SETMODELTICK);
+
+	if (request != NULL)
+	{
+		request->tick = tick;
+	}
+	return NI_ClientSimpleCall(request);
+}
+
+ /*========================================================================*
+ * Function: NI_ClientPayloadSize
+ *
+ * Abstract:
+ *	Returns the number of payload bytes of a message, call it between
+ *	NI_ClientBegin and NI_ClientEnd.
+ ========================================================================*/
+static int32_t NI_ClientPayloadSize(void)
+{
+	return (int32_t)(NI_Client.header->capacity * sizeof(double));
+}
+
+DLL_EXPORT int32_t NIRT_GetModelFrameworkVersion(uint32_t* major, uint32_t* minor, uint32_t* fix, uint32_t* build)
+{
+	const NI_ServerMessage *response;
+	int32_t retval;
+
+	if ((NI_ClientBegin(NI_OP_GETFRAMEWORKVERSION) == NULL) || ((response = NI_ClientCall()) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	if (major) *major = (uint32_t)response->args[0];
+	if (minor) *minor = (uint32_t)response->args[1];
+	if (fix) *fix = (uint32_t)response->args[2];
+	if (build) *build = (uint32_t)response->args[3];
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_PrefaultMemory(void)
+{
+	return NI_ClientSimpleCall(NI_ClientBegin(NI_OP_PREFAULTMEMORY));
+}
+
+DLL_EXPORT int32_t NIRT_ScheduleN(const double *inData, double *outData, int32_t numTicks, double *outTime)
+{
+	NI_ServerMessage *request;
+	const NI_ServerMessage *response;
+	int32_t retval, done = 0, run, width;
+
+	/* the ticks are sent in runs that fit into a message, parameter commits may take place between two runs */
+	do
+	{
+		if ((request = NI_ClientBegin(NI_OP_SCHEDULEN)) == NULL)
+		{
+			return NI_ERROR;
+		}
+
+		width = (NI_Client.numIn > NI_Client.numOut) ? NI_Client.numIn : NI_Client.numOut;
+		run = (width > 0 && numTicks - done > (int32_t)NI_Client.header->capacity / width) ? (int32_t)NI_Client.header->capacity / width : numTicks - done;
+		if (inData && run > 0)
+		{
+			memcpy(NI_SERVER_PAYLOAD(request), inData + (size_t)done * NI_Client.numIn, (size_t)run * NI_Client.numIn * sizeof(double));
+		}
+		request->args[0] = run;
+		request->args[1] = (inData != NULL);
+
+		if ((response = NI_ClientCall()) == NULL)
+		{
+			return NI_ERROR;
+		}
+
+		run = response->args[0];
+		if (outData && run > 0)
+		{
+			memcpy(outData + (size_t)done * NI_Client.numOut, NI_SERVER_PAYLOAD(response), (size_t)run * NI_Client.numOut * sizeof(double));
+		}
+		if (outTime)
+		{
+			*outTime = response->scalars[0];
+		}
+		retval = response->retval;
+		done += run;
+		NI_ClientEnd();
+	} while ((retval == NI_OK) && (run > 0) && (done < numTicks));
+
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_GetModelMetadata(void* image, uint32_t* size)
+{
+	NI_ServerMessage *request;
+	const NI_ServerMessage *response;
+	uint32_t offset = 0, total, count;
+	int32_t retval;
+
+	if (size == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	/* the image is sent in parts that fit into a message */
+	do
+	{
+		if (((request = NI_ClientBegin(NI_OP_GETMODELMETADATA)) == NULL) || ((request->args[0] = (int32_t)offset), (response = NI_ClientCall()) == NULL))
+		{
+			return NI_ERROR;
+		}
+
+		total = (uint32_t)response->args[0];
+		count = response->count;
+		retval = response->retval;
+		if ((retval != NI_OK) || (image == NULL) || (*size < total))
+		{
+			NI_ClientEnd();
+			*size = total;
+			return (image == NULL) ? retval : NI_ERROR;
+		}
+
+		memcpy((unsigned char *)image + offset, NI_SERVER_PAYLOAD(response), count);
+		offset += count;
+		NI_ClientEnd();
+	} while ((offset < total) && (count > 0));
+
+	*size = total;
+	return (offset == total) ? NI_OK : NI_ERROR;
+}
+
+DLL_EXPORT int32_t NIRT_TaskTakeOneStep(int32_t taskid)
+{
+	NI_ServerMessage *request = NI_ClientBegin(NI_OP_TASKTAKEONESTEP);
+
+	if (request != NULL)
+	{
+		request->args[0] = taskid;
+	}
+	return NI_ClientSimpleCall(request);
+}
+
+DLL_EXPORT int32_t NIRT_GetSteadyStateInfo(int32_t* steady, double* skippedSteps)
+{
+	const NI_ServerMessage *response;
+	int32_t retval;
+
+	if ((NI_ClientBegin(NI_OP_GETSTEADYSTATEINFO) == NULL) || ((response = NI_ClientCall()) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	if (steady) *steady = response->args[0];
+	if (skippedSteps) *skippedSteps = response->scalars[0];
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_GetSheddingInfo(double* shedSteps, double* shedCount, double* stepCost)
+{
+	const NI_ServerMessage *response;
+	int32_t retval;
+
+	if ((NI_ClientBegin(NI_OP_GETSHEDDINGINFO) == NULL) || ((response = NI_ClientCall()) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	if (shedSteps) *shedSteps = response->scalars[0];
+	if (shedCount) *shedCount = response->scalars[1];
+	if (stepCost) *stepCost = response->scalars[2];
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_GetMemoizationInfo(double* reusedSteps)
+{
+	const NI_ServerMessage *response;
+	int32_t retval;
+
+	if ((NI_ClientBegin(NI_OP_GETMEMOIZATIONINFO) == NULL) || ((response = NI_ClientCall()) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	if (reusedSteps) *reusedSteps = response->scalars[0];
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_ProbeSignalChanges(int32_t stream, const int32_t* sigindices, int32_t numsigs, int32_t* indices, double* values, int32_t* num, int32_t* keyframe)
+{
+	NI_ServerMessage *request;
+	const NI_ServerMessage *response;
+	int32_t count, retval;
+
+	if ((num == NULL) || ((request = NI_ClientBegin(NI_OP_PROBESIGNALCHANGES)) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	/* lists longer than a message are truncated, as in NIRT_ProbeSignals */
+	if (sigindices)
+	{
+		count = (numsigs < NI_ClientPayloadSize() / (int32_t)sizeof(int32_t)) ? numsigs : NI_ClientPayloadSize() / (int32_t)sizeof(int32_t);
+		memcpy(NI_SERVER_PAYLOAD(request), sigindices, (size_t)(count > 0 ? count : 0) * sizeof(int32_t));
+	}
+	request->args[0] = stream;
+	request->args[1] = numsigs;
+	request->args[2] = *num;
+	request->args[3] = (sigindices != NULL);
+
+	if ((response = NI_ClientCall()) == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	/* the values are followed by the indices */
+	count = response->args[0];
+	if (count > 0)
+	{
+		memcpy(values, NI_SERVER_PAYLOAD(response), (size_t)count * sizeof(double));
+		memcpy(indices, NI_SERVER_PAYLOAD(response) + count, (size_t)count * sizeof(int32_t));
+	}
+	*num = count;
+	if (keyframe)
+	{
+		*keyframe = response->args[1];
+	}
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_ResyncSignalChanges(int32_t stream)
+{
+	NI_ServerMessage *request = NI_ClientBegin(NI_OP_RESYNCSIGNALCHANGES);
+
+	if (request != NULL)
+	{
+		request->args[0] = stream;
+	}
+	return NI_ClientSimpleCall(request);
+}
+
+DLL_EXPORT int32_t NIRT_SetSignalDeadband(int32_t index, double deadband)
+{
+	NI_ServerMessage *request = NI_ClientBegin(NI_OP_SETSIGNALDEADBAND);
+
+	if (request != NULL)
+	{
+		request->args[0] = index;
+		request->scalars[0] = deadband;
+	}
+	return NI_ClientSimpleCall(request);
+}
+
+DLL_EXPORT int32_t NIRT_SetScalarParameterInline(uint32_t index, uint32_t subindex, double paramvalue)
+{
+	NI_ServerMessage *request = NI_ClientBegin(NI_OP_SETSCALARPARAMETERINLINE);
+
+	if (request != NULL)
+	{
+		request->args[0] = (int32_t)index;
+		request->args[1] = (int32_t)subindex;
+		request->scalars[0] = paramvalue;
+	}
+	return NI_ClientSimpleCall(request);
+}
+
+DLL_EXPORT int32_t NIRT_SetVectorParameter(uint32_t index, const double* paramvalues, uint32_t paramlength)
+{
+	NI_ServerMessage *request;
+
+	if ((paramvalues == NULL) || ((request = NI_ClientBegin(NI_OP_SETVECTORPARAMETER)) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	/* the server refuses vectors longer than a message */
+	memcpy(NI_SERVER_PAYLOAD(request), paramvalues, (size_t)((paramlength < NI_Client.header->capacity) ? paramlength : NI_Client.header->capacity) * sizeof(double));
+	request->args[0] = (int32_t)index;
+	request->args[1] = (int32_t)paramlength;
+	return NI_ClientSimpleCall(request);
+}
+
+DLL_EXPORT int32_t NIRT_GetVectorParameter(uint32_t index, double* paramValues, uint32_t paramLength)
+{
+	NI_ServerMessage *request;
+	const NI_ServerMessage *response;
+	int32_t retval;
+
+	if ((paramValues == NULL) || ((request = NI_ClientBegin(NI_OP_GETVECTORPARAMETER)) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	request->args[0] = (int32_t)index;
+	request->args[1] = (int32_t)paramLength;
+	if ((response = NI_ClientCall()) == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	retval = response->retval;
+	if (retval == NI_OK)
+	{
+		memcpy(paramValues, NI_SERVER_PAYLOAD(response), (size_t)paramLength * sizeof(double));
+	}
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_SetParameterBatch(const int32_t* indices, const int32_t* subindices, const double* values, int32_t count, int32_t* errors)
+{
+	NI_ServerMessage *request;
+	const NI_ServerMessage *response;
+	double *payload;
+	int32_t retval;
+
+	if ((indices == NULL) || (values == NULL) || ((request = NI_ClientBegin(NI_OP_SETPARAMETERBATCH)) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	/* the values, then the indices and subindices; the server refuses batches longer than a message */
+	payload = NI_SERVER_PAYLOAD(request);
+	if ((count > 0) && (count <= NI_ClientPayloadSize() / 16))
+	{
+		memcpy(payload, values, (size_t)count * sizeof(double));
+		memcpy((int32_t *)(payload + count), indices, (size_t)count * sizeof(int32_t));
+		if (subindices)
+		{
+			memcpy((int32_t *)(payload + count) + count, subindices, (size_t)count * sizeof(int32_t));
+		}
+	}
+	request->args[0] = count;
+	request->args[1] = (subindices != NULL);
+
+	if ((response = NI_ClientCall()) == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	if (errors && (count > 0) && (count <= NI_ClientPayloadSize() / 16))
+	{
+		memcpy(errors, NI_SERVER_PAYLOAD(response), (size_t)count * sizeof(int32_t));
+	}
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_SetParameterImage(const void* image, uint32_t size)
+{
+	NI_ServerMessage *request;
+
+	if ((image == NULL) || ((request = NI_ClientBegin(NI_OP_SETPARAMETERIMAGE)) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	/* the server refuses images larger than a message */
+	memcpy(NI_SERVER_PAYLOAD(request), image, (size <= (uint32_t)NI_ClientPayloadSize()) ? size : 0);
+	request->args[0] = (size <= (uint32_t)NI_ClientPayloadSize()) ? (int32_t)size : NI_ClientPayloadSize() + 1;
+	return NI_ClientSimpleCall(request);
+}
+
+DLL_EXPORT int32_t NIRT_GetParameterImage(void* image, uint32_t* size)
+{
+	NI_ServerMessage *request;
+	const NI_ServerMessage *response;
+	int32_t retval;
+
+	if ((size == NULL) || ((request = NI_ClientBegin(NI_OP_GETPARAMETERIMAGE)) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	request->args[0] = (image == NULL) ? -1 : (int32_t)((*size < (uint32_t)NI_ClientPayloadSize()) ? *size : (uint32_t)NI_ClientPayloadSize());
+	if ((response = NI_ClientCall()) == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	*size = (uint32_t)response->args[0];
+	retval = response->retval;
+	if (image && (retval == NI_OK))
+	{
+		memcpy(image, NI_SERVER_PAYLOAD(response), *size);
+	}
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_LoadParameterSet(const char* path, int32_t* unmatched)
+{
+	NI_ServerMessage *request;
+	const NI_ServerMessage *response;
+	int32_t retval;
+
+	if ((path == NULL) || ((request = NI_ClientBegin(NI_OP_LOADPARAMETERSET)) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	/* the path is opened by the server */
+	strncpy((char *)NI_SERVER_PAYLOAD(request), path, (size_t)NI_ClientPayloadSize() - 1);
+	if ((response = NI_ClientCall()) == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	if (unmatched)
+	{
+		*unmatched = response->args[0];
+	}
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_SaveParameterSet(const char* path)
+{
+	NI_ServerMessage *request;
+
+	if ((path == NULL) || ((request = NI_ClientBegin(NI_OP_SAVEPARAMETERSET)) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	/* the path is opened by the server */
+	strncpy((char *)NI_SERVER_PAYLOAD(request), path, (size_t)NI_ClientPayloadSize() - 1);
+	return NI_ClientSimpleCall(request);
+}
+
+DLL_EXPORT int32_t NIRT_GetErrorMessageLength(void)
+{
+	NI_ServerMessage *request = NI_ClientBegin(NI_OP_GETERRORMESSAGELENGTH);
+	const NI_ServerMessage *response;
+	int32_t retval;
+
+	if ((request == NULL) || ((response = NI_ClientCall()) == NULL))
+	{
+		/* the error of the client itself */
+		return (int32_t)strlen(NI_Client.errmsg ? NI_Client.errmsg : "The model server is not running.");
+	}
+
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_TaskRunTimeInfo(int32_t halt, int32_t* overruns, int32_t *numtasks)
+{
+	NI_ServerMessage *request = NI_ClientBegin(NI_OP_TASKRUNTIMEINFO);
+	const NI_ServerMessage *response;
+	int32_t length = (numtasks != NULL) ? *numtasks : 0;
+	int32_t retval;
+
+	if ((request == NULL) || ((request->args[0] = halt), (request->args[1] = length), (response = NI_ClientCall()) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	if (overruns && (length > 0))
+	{
+		memcpy(overruns, NI_SERVER_PAYLOAD(response), (size_t)((length < response->args[0]) ? length : response->args[0]) * sizeof(int32_t));
+	}
+	if (numtasks)
+	{
+		*numtasks = response->args[0];
+	}
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+ /*========================================================================*
+ * Function: NI_ClientCopyField
+ *
+ * Abstract:
+ *	Copies count values of size bytes from a field of a response, at most the
+ *	size of the field.
+ ========================================================================*/
+static void NI_ClientCopyField(void *dst, const NI_ServerMessage *response, int32_t field, int32_t count, size_t size)
+{
+	size_t bytes = (count > 0) ? (size_t)count * size : 0;
+
+	if (dst != NULL)
+	{
+		memcpy(dst, NI_SERVER_FIELD(NI_Client.header, response, field), (bytes < NI_SERVER_FIELD_SIZE(NI_Client.header)) ? bytes : NI_SERVER_FIELD_SIZE(NI_Client.header));
+	}
+}
+
+DLL_EXPORT int32_t NIRT_GetSimState(int32_t* numContStates, char* contStatesNames, double* contStates, int32_t* numDiscStates, 
+								char* discStatesNames, double* discStates, int32_t* numClockTicks, char* clockTicksNames, int32_t* clockTicks)
+{
+	NI_ServerMessage *request = NI_ClientBegin(NI_OP_GETSIMSTATE);
+	const NI_ServerMessage *response;
+	char *names[3];
+	int32_t counts = (numContStates && numDiscStates && numClockTicks);
+	int32_t i, retval;
+
+	if (request == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	/* names and states of the continuous states, discrete states and clock ticks in fields 0 to 5 */
+	request->args[0] = counts ? *numContStates : 0;
+	request->args[1] = counts ? *numDiscStates : 0;
+	request->args[2] = counts ? *numClockTicks : 0;
+	request->args[7] = (counts ? NI_SERVER_MASK(0) : 0) | (contStatesNames ? NI_SERVER_MASK(1) : 0) | (contStates ? NI_SERVER_MASK(2) : 0) | (discStatesNames ? NI_SERVER_MASK(3) : 0) | 
+						(discStates ? NI_SERVER_MASK(4) : 0) | (clockTicksNames ? NI_SERVER_MASK(5) : 0) | (clockTicks ? NI_SERVER_MASK(6) : 0);
+	if ((response = NI_ClientCall()) == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	names[0] = contStatesNames;
+	names[1] = discStatesNames;
+	names[2] = clockTicksNames;
+	for (i = 0; i < 3; i++)
+	{
+		/* without counts the clock ticks are the two words of the tick */
+		int32_t j, n = counts ? response->args[i] : ((i == 2) ? 2 : 0);
+		
+		for (j = 0; names[i] && (j < n) && ((j + 1) * NI_SIMSTATE_NAME_SIZE <= (int32_t)NI_SERVER_FIELD_SIZE(NI_Client.header)); j++)
+		{
+			const char *name = NI_SERVER_FIELD(NI_Client.header, response, 2 * i) + j * NI_SIMSTATE_NAME_SIZE;
+			if (name[0] != 0)
+			{
+				strcpy(names[i] + j * NI_SIMSTATE_NAME_SIZE, name);
+			}
+		}
+	}
+
+	if (counts && (request->args[0] >= 0) && (request->args[1] >= 0) && (request->args[2] >= 0))
+	{
+		NI_ClientCopyField(contStates, response, 1, response->args[0], sizeof(double));
+		NI_ClientCopyField(discStates, response, 3, response->args[1], sizeof(double));
+		NI_ClientCopyField(clockTicks, response, 5, response->args[2], sizeof(int32_t));
+		if (clockTicks && (response->args[2] > 0))
+		{
+			NI_Client.tickWords = response->args[2];
+		}
+	}
+	if (counts)
+	{
+		*numContStates = response->args[0];
+		*numDiscStates = response->args[1];
+		*numClockTicks = response->args[2];
+	}
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_SetSimState(double* contStates, double* discStates, int32_t* clockTicks)
+{
+	NI_ServerMessage *request;
+	int32_t numContStates = -1, numDiscStates = -1, numClockTicks = -1;
+	size_t fieldSize;
+
+	/* the number of states tells how many values to send */
+	if ((NIRT_GetSimState(&numContStates, NULL, NULL, &numDiscStates, NULL, NULL, &numClockTicks, NULL, NULL) != NI_OK) || ((request = NI_ClientBegin(NI_OP_SETSIMSTATE)) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	fieldSize = NI_SERVER_FIELD_SIZE(NI_Client.header);
+	numClockTicks = (numClockTicks < NI_Client.tickWords) ? numClockTicks : NI_Client.tickWords;
+	if (contStates)
+	{
+		memcpy(NI_SERVER_FIELD(NI_Client.header, request, 0), contStates, ((size_t)numContStates * sizeof(double) < fieldSize) ? (size_t)numContStates * sizeof(double) : fieldSize);
+	}
+	if (discStates)
+	{
+		memcpy(NI_SERVER_FIELD(NI_Client.header, request, 1), discStates, ((size_t)numDiscStates * sizeof(double) < fieldSize) ? (size_t)numDiscStates * sizeof(double) : fieldSize);
+	}
+	if (clockTicks)
+	{
+		memcpy(NI_SERVER_FIELD(NI_Client.header, request, 2), clockTicks, ((size_t)numClockTicks * sizeof(int32_t) < fieldSize) ? (size_t)numClockTicks * sizeof(int32_t) : fieldSize);
+	}
+	request->args[7] = (contStates ? NI_SERVER_MASK(0) : 0) | (discStates ? NI_SERVER_MASK(1) : 0) | (clockTicks ? NI_SERVER_MASK(2) : 0);
+	return NI_ClientSimpleCall(request);
+}
+
+DLL_EXPORT int32_t NIRT_GetBuildInfo(char* detail, int32_t* len)
+{
+	NI_ServerMessage *request;
+	const NI_ServerMessage *response;
+	int32_t length, retval;
+
+	if ((len == NULL) || ((request = NI_ClientBegin(NI_OP_GETBUILDINFO)) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	length = *len;
+	if ((request->args[0] = length), (response = NI_ClientCall()) == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	*len = response->args[0];
+	if (detail && (length != -1))
+	{
+		memcpy(detail, NI_SERVER_PAYLOAD(response), (size_t)(*len > 0 ? *len : 0));
+	}
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_GetModelSpec(char* name, int32_t *namelen, double *baseTimeStep, int32_t *outNumInports, 
+										int32_t *outNumOutports, int32_t *numtasks)
+{
+	NI_ServerMessage *request = NI_ClientBegin(NI_OP_GETMODELSPEC);
+	const NI_ServerMessage *response;
+	int32_t length = (namelen != NULL) ? *namelen : 0;
+	int32_t retval;
+
+	if (request == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	request->args[0] = length;
+	request->args[7] = (name ? NI_SERVER_MASK(0) : 0) | (namelen ? NI_SERVER_MASK(1) : 0);
+	if ((response = NI_ClientCall()) == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	if (namelen)
+	{
+		*namelen = response->args[0];
+		if (name && (length != -1))
+		{
+			memcpy(name, NI_SERVER_PAYLOAD(response), (size_t)(*namelen > 0 ? *namelen : 0));
+		}
+	}
+	if (baseTimeStep) *baseTimeStep = response->scalars[0];
+	if (outNumInports) *outNumInports = response->args[1];
+	if (outNumOutports) *outNumOutports = response->args[2];
+	if (numtasks) *numtasks = response->args[3];
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_GetParameterIndices(int32_t* indices, int32_t* len)
+{
+	NI_ServerMessage *request;
+	const NI_ServerMessage *response;
+	int32_t length, retval;
+
+	if ((indices == NULL) || (len == NULL) || ((request = NI_ClientBegin(NI_OP_GETPARAMETERINDICES)) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	length = *len;
+	if ((request->args[0] = length), (response = NI_ClientCall()) == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	*len = response->args[0];
+	if (length != -1)
+	{
+		memcpy(indices, NI_SERVER_PAYLOAD(response), (size_t)(*len > 0 ? *len : 0) * sizeof(int32_t));
+	}
+	retval = response->retval;
+	NI_ClientEnd();
+	return retval;
+}
+
+ /*========================================================================*
+ * Function: NI_ClientLookupID
+ *
+ * Abstract:
+ *	Copies the ID a Get*Spec call looks up, NUL terminated, to field 0 of the
+ *	request.
+ ========================================================================*/
+static void NI_ClientLookupID(NI_ServerMessage *request, const char *ID, const int32_t *ID_len)
+{
+	char *field = NI_SERVER_FIELD(NI_Client.header, request, 0);
+	size_t length = 0;
+
+	if (ID && ID_len && (*ID_len > 0))
+	{
+		length = strlen(ID);
+		length = (length < (size_t)*ID_len) ? length : (size_t)*ID_len;
+		length = (length < NI_SERVER_FIELD_SIZE(NI_Client.header) - 1) ? length : NI_SERVER_FIELD_SIZE(NI_Client.header) - 1;
+		memcpy(field, ID, length);
+	}
+	field[length] = 0;
+}
+
+DLL_EXPORT int32_t NIRT_GetParameterSpec(int32_t* paramidx, char* ID, int32_t* ID_len, char* paramname, int32_t *pnlen, 
+										int32_t *datatype, int32_t* dims, int32_t* numdim)
+{
+	NI_ServerMessage *request;
+	const NI_ServerMessage *response;
+	int32_t dimlen = (numdim != NULL) ? *numdim : 0;
+	int32_t retval;
+
+	if ((paramidx == NULL) || ((request = NI_ClientBegin(NI_OP_GETPARAMETERSPEC)) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	/* ID in field 0, paramname in field 1, dims in field 2 */
+	NI_ClientLookupID(request, ID, ID_len);
+	request->args[0] = *paramidx;
+	request->args[1] = ID_len ? *ID_len : 0;
+	request->args[2] = pnlen ? *pnlen : 0;
+	request->args[3] = dimlen;
+	request->args[7] = ((ID && ID_len) ? NI_SERVER_MASK(0) : 0) | ((paramname && pnlen) ? NI_SERVER_MASK(1) : 0) | (dims ? NI_SERVER_MASK(2) : 0);
+	if ((response = NI_ClientCall()) == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	retval = response->retval;
+	if (retval == NI_OK)
+	{
+		*paramidx = response->args[0];
+		if (ID && ID_len)
+		{
+			*ID_len = response->args[1];
+			NI_ClientCopyField(ID, response, 0, *ID_len, 1);
+		}
+		if (paramname && pnlen)
+		{
+			*pnlen = response->args[2];
+			NI_ClientCopyField(paramname, response, 1, *pnlen, 1);
+		}
+		if (numdim)
+		{
+			*numdim = response->args[3];
+			if (dimlen != -1)
+			{
+				NI_ClientCopyField(dims, response, 2, *numdim, sizeof(int32_t));
+			}
+		}
+		if (datatype) *datatype = response->args[4];
+	}
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_GetSignalSpec(int32_t* sigidx, char* ID, int32_t* ID_len, char* blkname, int32_t* bnlen, int32_t *portnum, 
+										char* signame, int32_t* snlen, int32_t *datatype, int32_t* dims, int32_t* numdim)
+{
+	NI_ServerMessage *request;
+	const NI_ServerMessage *response;
+	int32_t dimlen = (numdim != NULL) ? *numdim : 0;
+	int32_t retval;
+
+	if ((sigidx == NULL) || ((request = NI_ClientBegin(NI_OP_GETSIGNALSPEC)) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	/* ID in field 0, blkname in field 1, signame in field 2, dims in field 3 */
+	NI_ClientLookupID(request, ID, ID_len);
+	request->args[0] = *sigidx;
+	request->args[1] = ID_len ? *ID_len : 0;
+	request->args[2] = bnlen ? *bnlen : 0;
+	request->args[3] = snlen ? *snlen : 0;
+	request->args[4] = dimlen;
+	request->args[7] = ((ID && ID_len) ? NI_SERVER_MASK(0) : 0) | ((blkname && bnlen) ? NI_SERVER_MASK(1) : 0) | ((signame && snlen) ? NI_SERVER_MASK(2) : 0) | (dims ? NI_SERVER_MASK(3) : 0);
+	if ((response = NI_ClientCall()) == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	retval = response->retval;
+	if (retval == NI_OK)
+	{
+		*sigidx = response->args[0];
+		if (ID && ID_len)
+		{
+			*ID_len = response->args[1];
+			NI_ClientCopyField(ID, response, 0, *ID_len, 1);
+		}
+		if (blkname && bnlen)
+		{
+			*bnlen = response->args[2];
+			NI_ClientCopyField(blkname, response, 1, *bnlen, 1);
+		}
+		if (signame && snlen)
+		{
+			*snlen = response->args[3];
+			NI_ClientCopyField(signame, response, 2, *snlen, 1);
+		}
+		if (numdim)
+		{
+			*numdim = response->args[4];
+			if (dimlen != -1)
+			{
+				NI_ClientCopyField(dims, response, 3, *numdim, sizeof(int32_t));
+			}
+		}
+		if (portnum) *portnum = response->args[5];
+		if (datatype) *datatype = response->args[6];
+	}
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_GetTaskSpec(int32_t index, int32_t* tid, double *tstep, double *offset)
+{
+	NI_ServerMessage *request = NI_ClientBegin(NI_OP_GETTASKSPEC);
+	const NI_ServerMessage *response;
+	int32_t retval;
+
+	if ((request == NULL) || ((request->args[0] = index), (response = NI_ClientCall()) == NULL))
+	{
+		return NI_ERROR;
+	}
+
+	retval = response->retval;
+	if ((retval == NI_OK) && (index != -1))
+	{
+		if (tid) *tid = response->args[0];
+		if (tstep) *tstep = response->scalars[0];
+		if (offset) *offset = response->scalars[1];
+	}
+	NI_ClientEnd();
+	return retval;
+}
+
+DLL_EXPORT int32_t NIRT_GetExtIOSpec(int32_t index, int32_t *idx, char* name, int32_t* tid, int32_t *type, int32_t *dims, int32_t* numdims)
+{
+	NI_ServerMessage *request = NI_ClientBegin(NI_OP_GETEXTIOSPEC);
+	const NI_ServerMessage *response;
+	int32_t size = (name != NULL) ? (int32_t)strlen(name) : 0;
+	int32_t dimlen = (numdims != NULL) ? *numdims : 0;
+	int32_t retval;
+
+	if (request == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	/* NIRT_GetExtIOSpec takes the length of the string in name as the size of the buffer */
+	request->args[0] = index;
+	request->args[1] = size;
+	request->args[2] = dimlen;
+	if ((response = NI_ClientCall()) == NULL)
+	{
+		return NI_ERROR;
+	}
+
+	retval = response->retval;
+	if ((retval == NI_OK) && (index != -1))
+	{
+		if (idx) *idx = response->args[0];
+		if (tid) *tid = response->args[1];
+		if (type) *type = response->args[2];
+		if (size > 0)
+		{
+			NI_ClientCopyField(name, response, 0, size, 1);
+			name[size - 1] = 0;
+		}
+		if (numdims)
+		{
+			/* the dimensions of a port are its rows and columns */
+			*numdims = response->args[3];
+			if (dimlen != -1)
+			{
+				NI_ClientCopyField(dims, response, 1, 2, sizeof(int32_t));
+			}
+		}
+	}
+	NI_ClientEnd();
+	return retval;
+}
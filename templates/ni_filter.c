@@ -0,0 +1,590 @@
+/*========================================================================*
+ * NI VeriStand Model Framework
+ * Filter banks
+ *
+ * Abstract:
+ *      FIR and biquad cascade kernels of the filter banks, the LTI bank
+ *      kernel and the change detection, see ni_filter.h. A vector kernel processes the channels in
+ *      groups of NI_FILTER_LANES, the scalar kernel the remaining channels.
+ *
+ *========================================================================*/
+
+#include "ni_filter.h"
+#include <string.h>
+#include <stddef.h>
+
+#if defined (NI_FILTER_NO_SIMD)
+	/* scalar kernels only */
+#elif defined (__aarch64__) || defined (_M_ARM64)
+	#include <arm_neon.h>
+	#define NI_FILTER_HAS_NEON
+#elif (defined (__x86_64__) || defined (__i386__)) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)) || defined (__clang__))
+	#include <immintrin.h>
+	#define NI_FILTER_HAS_AVX2
+	/* compiled for AVX2 whatever the flags of the library, only called if the processor has it */
+	#define NI_TARGET_AVX2	__attribute__ ((target("avx2,fma")))
+#elif (defined (_M_X64) || defined (_M_IX86)) && (_MSC_VER >= 1800)
+	#include <immintrin.h>
+	#include <intrin.h>
+	#define NI_FILTER_HAS_AVX2
+	#define NI_TARGET_AVX2
+#endif
+
+static int32_t NI_FilterSet = -1;
+
+ /*========================================================================*
+ * Function: NI_FilterKernel
+ *
+ * Abstract:
+ *	Detects the instruction set of the kernels on the first call.
+ *
+ * Returns:
+ *	NI_FILTER_SCALAR, NI_FILTER_AVX2 or NI_FILTER_NEON
+========================================================================*/
+int32_t NI_FilterKernel(void)
+{
+	if (NI_FilterSet >= 0)
+	{
+		return NI_FilterSet;
+	}
+
+#if defined (NI_FILTER_HAS_NEON)
+	NI_FilterSet = NI_FILTER_NEON;
+#elif defined (NI_FILTER_HAS_AVX2) && defined (_MSC_VER)
+	{
+		int info[4];
+
+		/* FMA, AVX and OSXSAVE in leaf 1, the OS saves the YMM registers, AVX2 in leaf 7 */
+		NI_FilterSet = NI_FILTER_SCALAR;
+		__cpuid(info, 0);
+		if (info[0] >= 7)
+		{
+			__cpuid(info, 1);
+			if (((info[2] & (1 << 12)) != 0) && ((info[2] & (1 << 27)) != 0) && ((info[2] & (1 << 28)) != 0) && ((_xgetbv(0) & 6) == 6))
+			{
+				__cpuidex(info, 7, 0);
+				NI_FilterSet = ((info[1] & (1 << 5)) != 0) ? NI_FILTER_AVX2 : NI_FILTER_SCALAR;
+			}
+		}
+	}
+#elif defined (NI_FILTER_HAS_AVX2)
+	__builtin_cpu_init();
+	NI_FilterSet = (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ? NI_FILTER_AVX2 : NI_FILTER_SCALAR;
+#else
+	NI_FilterSet = NI_FILTER_SCALAR;
+#endif
+
+	return NI_FilterSet;
+}
+
+/* FIR of the channels c0 to c1, newest points to the current sample of channel 0 */
+static void NI_FirScalar(int32_t taps, ptrdiff_t stride, const double *h, const double *newest, int32_t c0, int32_t c1, double *y)
+{
+	int32_t c, i;
+
+	for (c = c0; c < c1; c++)
+	{
+		const double *x = newest + c;
+		double acc = 0.0;
+
+		for (i = 0; i < taps; i++, x -= stride)
+		{
+			acc += h[i] * x[0];
+		}
+		y[c] = acc;
+	}
+}
+
+/* Biquad cascade of the channels c0 to c1 */
+static void NI_BiquadScalar(int32_t sections, ptrdiff_t stride, const double *sos, double *state, int32_t c0, int32_t c1, const double *u, double *y)
+{
+	int32_t c, s;
+
+	for (c = c0; c < c1; c++)
+	{
+		double x = u[c];
+
+		for (s = 0; s < sections; s++)
+		{
+			const double *k = sos + 5 * s;
+			double *z = state + 2 * s * stride + c;
+			double out = k[0] * x + z[0];
+
+			z[0] = k[1] * x - k[3] * out + z[stride];
+			z[stride] = k[2] * x - k[4] * out;
+			x = out;
+		}
+		y[c] = x;
+	}
+}
+
+/* Copies c0 to count of an LTI bank */
+static void NI_LtiScalar(int32_t n, int32_t m, int32_t p, const double *coeffs, double *x, const double *u, double *y, int32_t c0, int32_t count)
+{
+	const double *A = coeffs, *B = A + n * n, *C = B + n * m, *D = C + p * n;
+	double old[NI_LTI_BANK_ORDER];
+	int32_t c, i, j;
+
+	for (c = c0; c < count; c++)
+	{
+		for (i = 0; i < n; i++)
+		{
+			old[i] = x[i * count + c];
+		}
+		for (i = 0; i < p; i++)
+		{
+			double acc = 0.0;
+
+			for (j = 0; j < n; j++)
+			{
+				acc += C[i * n + j] * old[j];
+			}
+			for (j = 0; j < m; j++)
+			{
+				acc += D[i * m + j] * u[j * count + c];
+			}
+			y[i * count + c] = acc;
+		}
+		for (i = 0; i < n; i++)
+		{
+			double acc = 0.0;
+
+			for (j = 0; j < n; j++)
+			{
+				acc += A[i * n + j] * old[j];
+			}
+			for (j = 0; j < m; j++)
+			{
+				acc += B[i * m + j] * u[j * count + c];
+			}
+			x[i * count + c] = acc;
+		}
+	}
+}
+
+/* Changes of the values c0 to c1, returns their number */
+static int32_t NI_DetectScalar(int32_t c0, int32_t c1, const double *current, const double *sent, const double *band, unsigned char *changed)
+{
+	int32_t c, found = 0;
+
+	for (c = c0; c < c1; c++)
+	{
+		double delta = current[c] - sent[c];
+
+		changed[c] = (unsigned char)((delta > band[c]) || (-delta > band[c]) || ((current[c] != current[c]) != (sent[c] != sent[c])));
+		found += changed[c];
+	}
+	return found;
+}
+
+#if defined (NI_FILTER_HAS_AVX2)
+/* Bytes of the changed flags of a movemask of 4 comparisons */
+static const uint32_t NI_ChangedBytes[16] = {
+	0x00000000, 0x00000001, 0x00000100, 0x00000101, 0x00010000, 0x00010001, 0x00010100, 0x00010101,
+	0x01000000, 0x01000001, 0x01000100, 0x01000101, 0x01010000, 0x01010001, 0x01010100, 0x01010101
+};
+
+/* Returns the number of values compared, a multiple of NI_FILTER_LANES; found counts the changes */
+NI_TARGET_AVX2 static int32_t NI_DetectAvx2(int32_t values, const double *current, const double *sent, const double *band, unsigned char *changed, int32_t *found)
+{
+	const __m256d magnitude = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+	int32_t c = 0, n = 0;
+
+	for (; c + NI_FILTER_LANES <= values; c += NI_FILTER_LANES)
+	{
+		__m256d x = _mm256_loadu_pd(current + c), s = _mm256_loadu_pd(sent + c);
+		/* |x - s| > band is false for a NaN difference, the NaN state is compared apart */
+		__m256d moved = _mm256_cmp_pd(_mm256_and_pd(_mm256_sub_pd(x, s), magnitude), _mm256_loadu_pd(band + c), _CMP_GT_OQ);
+		__m256d nan = _mm256_xor_pd(_mm256_cmp_pd(x, x, _CMP_UNORD_Q), _mm256_cmp_pd(s, s, _CMP_UNORD_Q));
+		uint32_t bytes = NI_ChangedBytes[_mm256_movemask_pd(_mm256_or_pd(moved, nan))];
+
+		/* the sum of the bytes ends up in the top byte */
+		memcpy(changed + c, &bytes, sizeof(bytes));
+		n += (int32_t)((bytes * 0x01010101u) >> 24);
+	}
+	*found = n;
+	return c;
+}
+
+/* Row F x + G u of the copies c to c + 3, old holds their states */
+NI_TARGET_AVX2 static __m256d NI_LtiRowAvx2(int32_t n, int32_t m, const double *F, const double *G, const __m256d *old, const double *u, int32_t count, int32_t c)
+{
+	__m256d acc = _mm256_setzero_pd();
+	int32_t j;
+
+	for (j = 0; j < n; j++)
+	{
+		acc = _mm256_fmadd_pd(_mm256_broadcast_sd(&F[j]), old[j], acc);
+	}
+	for (j = 0; j < m; j++)
+	{
+		acc = _mm256_fmadd_pd(_mm256_broadcast_sd(&G[j]), _mm256_loadu_pd(u + j * count + c), acc);
+	}
+	return acc;
+}
+
+/* Returns the number of copies advanced, a multiple of NI_FILTER_LANES */
+NI_TARGET_AVX2 static int32_t NI_LtiAvx2(int32_t n, int32_t m, int32_t p, const double *coeffs, double *x, const double *u, double *y, int32_t count)
+{
+	const double *A = coeffs, *B = A + n * n, *C = B + n * m, *D = C + p * n;
+	__m256d old[NI_LTI_BANK_ORDER];
+	int32_t c = 0, i;
+
+	for (; c + NI_FILTER_LANES <= count; c += NI_FILTER_LANES)
+	{
+		for (i = 0; i < n; i++)
+		{
+			old[i] = _mm256_loadu_pd(x + i * count + c);
+		}
+		for (i = 0; i < p; i++)
+		{
+			_mm256_storeu_pd(y + i * count + c, NI_LtiRowAvx2(n, m, C + i * n, D + i * m, old, u, count, c));
+		}
+		for (i = 0; i < n; i++)
+		{
+			_mm256_storeu_pd(x + i * count + c, NI_LtiRowAvx2(n, m, A + i * n, B + i * m, old, u, count, c));
+		}
+	}
+	return c;
+}
+
+/* Returns the number of channels filtered, a multiple of NI_FILTER_LANES */
+NI_TARGET_AVX2 static int32_t NI_FirAvx2(int32_t taps, ptrdiff_t stride, const double *h, const double *newest, int32_t channels, double *y)
+{
+	int32_t c = 0, i;
+
+	/* two accumulators per iteration hide the latency of the FMA */
+	for (; c + 2 * NI_FILTER_LANES <= channels; c += 2 * NI_FILTER_LANES)
+	{
+		const double *x = newest + c;
+		__m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+
+		for (i = 0; i < taps; i++, x -= stride)
+		{
+			__m256d k = _mm256_broadcast_sd(&h[i]);
+			acc0 = _mm256_fmadd_pd(k, _mm256_loadu_pd(x), acc0);
+			acc1 = _mm256_fmadd_pd(k, _mm256_loadu_pd(x + 4), acc1);
+		}
+		_mm256_storeu_pd(y + c, acc0);
+		_mm256_storeu_pd(y + c + 4, acc1);
+	}
+	for (; c + NI_FILTER_LANES <= channels; c += NI_FILTER_LANES)
+	{
+		const double *x = newest + c;
+		__m256d acc = _mm256_setzero_pd();
+
+		for (i = 0; i < taps; i++, x -= stride)
+		{
+			acc = _mm256_fmadd_pd(_mm256_broadcast_sd(&h[i]), _mm256_loadu_pd(x), acc);
+		}
+		_mm256_storeu_pd(y + c, acc);
+	}
+	return c;
+}
+
+NI_TARGET_AVX2 static int32_t NI_BiquadAvx2(int32_t sections, ptrdiff_t stride, const double *sos, double *state, int32_t channels, const double *u, double *y)
+{
+	int32_t c = 0, s;
+
+	for (; c + NI_FILTER_LANES <= channels; c += NI_FILTER_LANES)
+	{
+		__m256d x = _mm256_loadu_pd(u + c);
+
+		for (s = 0; s < sections; s++)
+		{
+			const double *k = sos + 5 * s;
+			double *z = state + 2 * s * stride + c;
+			__m256d z1 = _mm256_loadu_pd(z), z2 = _mm256_loadu_pd(z + stride);
+			__m256d out = _mm256_fmadd_pd(_mm256_broadcast_sd(&k[0]), x, z1);
+
+			z1 = _mm256_fnmadd_pd(_mm256_broadcast_sd(&k[3]), out, _mm256_fmadd_pd(_mm256_broadcast_sd(&k[1]), x, z2));
+			z2 = _mm256_fnmadd_pd(_mm256_broadcast_sd(&k[4]), out, _mm256_mul_pd(_mm256_broadcast_sd(&k[2]), x));
+			_mm256_storeu_pd(z, z1);
+			_mm256_storeu_pd(z + stride, z2);
+			x = out;
+		}
+		_mm256_storeu_pd(y + c, x);
+	}
+	return c;
+}
+#endif
+
+#if defined (NI_FILTER_HAS_NEON)
+/* Returns the number of values compared, a multiple of NI_FILTER_LANES; found counts the changes */
+static int32_t NI_DetectNeon(int32_t values, const double *current, const double *sent, const double *band, unsigned char *changed, int32_t *found)
+{
+	int32_t c = 0, n = 0, half;
+
+	for (; c + NI_FILTER_LANES <= values; c += NI_FILTER_LANES)
+	{
+		for (half = 0; half < 4; half += 2)
+		{
+			float64x2_t x = vld1q_f64(current + c + half), s = vld1q_f64(sent + c + half);
+			/* |x - s| > band is false for a NaN difference, the NaN state is compared apart */
+			uint64x2_t moved = vcgtq_f64(vabdq_f64(x, s), vld1q_f64(band + c + half));
+			uint64x2_t changes = vorrq_u64(moved, veorq_u64(vceqq_f64(x, x), vceqq_f64(s, s)));
+
+			changed[c + half] = (unsigned char)(vgetq_lane_u64(changes, 0) & 1);
+			changed[c + half + 1] = (unsigned char)(vgetq_lane_u64(changes, 1) & 1);
+			n += changed[c + half] + changed[c + half + 1];
+		}
+	}
+	*found = n;
+	return c;
+}
+
+/* Row F x + G u of the copies c to c + 1, old holds their states */
+static float64x2_t NI_LtiRowNeon(int32_t n, int32_t m, const double *F, const double *G, const float64x2_t *old, const double *u, int32_t count, int32_t c)
+{
+	float64x2_t acc = vdupq_n_f64(0.0);
+	int32_t j;
+
+	for (j = 0; j < n; j++)
+	{
+		acc = vfmaq_f64(acc, vdupq_n_f64(F[j]), old[j]);
+	}
+	for (j = 0; j < m; j++)
+	{
+		acc = vfmaq_f64(acc, vdupq_n_f64(G[j]), vld1q_f64(u + j * count + c));
+	}
+	return acc;
+}
+
+/* Returns the number of copies advanced, a multiple of NI_FILTER_LANES */
+static int32_t NI_LtiNeon(int32_t n, int32_t m, int32_t p, const double *coeffs, double *x, const double *u, double *y, int32_t count)
+{
+	const double *A = coeffs, *B = A + n * n, *C = B + n * m, *D = C + p * n;
+	float64x2_t old[NI_LTI_BANK_ORDER];
+	int32_t c = 0, i, half;
+
+	for (; c + NI_FILTER_LANES <= count; c += NI_FILTER_LANES)
+	{
+		for (half = c; half < c + NI_FILTER_LANES; half += 2)
+		{
+			for (i = 0; i < n; i++)
+			{
+				old[i] = vld1q_f64(x + i * count + half);
+			}
+			for (i = 0; i < p; i++)
+			{
+				vst1q_f64(y + i * count + half, NI_LtiRowNeon(n, m, C + i * n, D + i * m, old, u, count, half));
+			}
+			for (i = 0; i < n; i++)
+			{
+				vst1q_f64(x + i * count + half, NI_LtiRowNeon(n, m, A + i * n, B + i * m, old, u, count, half));
+			}
+		}
+	}
+	return c;
+}
+
+/* Returns the number of channels filtered, a multiple of NI_FILTER_LANES */
+static int32_t NI_FirNeon(int32_t taps, ptrdiff_t stride, const double *h, const double *newest, int32_t channels, double *y)
+{
+	int32_t c = 0, i;
+
+	for (; c + NI_FILTER_LANES <= channels; c += NI_FILTER_LANES)
+	{
+		const double *x = newest + c;
+		float64x2_t acc0 = vdupq_n_f64(0.0), acc1 = vdupq_n_f64(0.0);
+
+		for (i = 0; i < taps; i++, x -= stride)
+		{
+			float64x2_t k = vdupq_n_f64(h[i]);
+			acc0 = vfmaq_f64(acc0, k, vld1q_f64(x));
+			acc1 = vfmaq_f64(acc1, k, vld1q_f64(x + 2));
+		}
+		vst1q_f64(y + c, acc0);
+		vst1q_f64(y + c + 2, acc1);
+	}
+	return c;
+}
+
+static int32_t NI_BiquadNeon(int32_t sections, ptrdiff_t stride, const double *sos, double *state, int32_t channels, const double *u, double *y)
+{
+	int32_t c = 0, s, half;
+
+	for (; c + NI_FILTER_LANES <= channels; c += NI_FILTER_LANES)
+	{
+		float64x2_t x[2];
+
+		x[0] = vld1q_f64(u + c);
+		x[1] = vld1q_f64(u + c + 2);
+		for (s = 0; s < sections; s++)
+		{
+			const double *k = sos + 5 * s;
+
+			for (half = 0; half < 2; half++)
+			{
+				double *z = state + 2 * s * stride + c + 2 * half;
+				float64x2_t out = vfmaq_f64(vld1q_f64(z), vdupq_n_f64(k[0]), x[half]);
+
+				vst1q_f64(z, vfmsq_f64(vfmaq_f64(vld1q_f64(z + stride), vdupq_n_f64(k[1]), x[half]), vdupq_n_f64(k[3]), out));
+				vst1q_f64(z + stride, vfmsq_f64(vmulq_f64(vdupq_n_f64(k[2]), x[half]), vdupq_n_f64(k[4]), out));
+				x[half] = out;
+			}
+		}
+		vst1q_f64(y + c, x[0]);
+		vst1q_f64(y + c + 2, x[1]);
+	}
+	return c;
+}
+#endif
+
+ /*========================================================================*
+ * Function: NI_FirBank
+ *
+ * Abstract:
+ *	Filters one sample of every channel with a FIR filter.
+========================================================================*/
+void NI_FirBank(int32_t taps, int32_t channels, const double *h, double *history, int32_t *pos, const double *u, double *y)
+{
+	ptrdiff_t stride = NI_FILTER_STRIDE(channels);
+	int32_t p = *pos, c = 0;
+	double *newest = history + (p + taps) * stride;
+
+	/* the sample goes to both copies of the delay line, rows p + 1 to p + taps then hold the last taps samples */
+	memcpy(history + p * stride, u, (size_t)channels * sizeof(double));
+	memcpy(newest, u, (size_t)channels * sizeof(double));
+
+	switch (NI_FilterKernel())
+	{
+#if defined (NI_FILTER_HAS_AVX2)
+		case NI_FILTER_AVX2:
+			c = NI_FirAvx2(taps, stride, h, newest, channels, y);
+			break;
+#endif
+#if defined (NI_FILTER_HAS_NEON)
+		case NI_FILTER_NEON:
+			c = NI_FirNeon(taps, stride, h, newest, channels, y);
+			break;
+#endif
+		default:
+			break;
+	}
+	NI_FirScalar(taps, stride, h, newest, c, channels, y);
+
+	*pos = (p + 1 < taps) ? p + 1 : 0;
+}
+
+ /*========================================================================*
+ * Function: NI_BiquadBank
+ *
+ * Abstract:
+ *	Filters one sample of every channel with a biquad cascade.
+========================================================================*/
+void NI_BiquadBank(int32_t sections, int32_t channels, const double *sos, double *state, const double *u, double *y)
+{
+	ptrdiff_t stride = NI_FILTER_STRIDE(channels);
+	int32_t c = 0;
+
+	switch (NI_FilterKernel())
+	{
+#if defined (NI_FILTER_HAS_AVX2)
+		case NI_FILTER_AVX2:
+			c = NI_BiquadAvx2(sections, stride, sos, state, channels, u, y);
+			break;
+#endif
+#if defined (NI_FILTER_HAS_NEON)
+		case NI_FILTER_NEON:
+			c = NI_BiquadNeon(sections, stride, sos, state, channels, u, y);
+			break;
+#endif
+		default:
+			break;
+	}
+	NI_BiquadScalar(sections, stride, sos, state, c, channels, u, y);
+}
+
+ /*========================================================================*
+ * Function: NI_LtiBank
+ *
+ * Abstract:
+ *	Advances count copies of a discrete state-space system sharing the matrices.
+========================================================================*/
+void NI_LtiBank(int32_t n, int32_t m, int32_t p, const double *coeffs, double *x, const double *u, double *y, int32_t count)
+{
+	int32_t c = 0;
+
+	switch (NI_FilterKernel())
+	{
+#if defined (NI_FILTER_HAS_AVX2)
+		case NI_FILTER_AVX2:
+			c = NI_LtiAvx2(n, m, p, coeffs, x, u, y, count);
+			break;
+#endif
+#if defined (NI_FILTER_HAS_NEON)
+		case NI_FILTER_NEON:
+			c = NI_LtiNeon(n, m, p, coeffs, x, u, y, count);
+			break;
+#endif
+		default:
+			break;
+	}
+	NI_LtiScalar(n, m, p, coeffs, x, u, y, c, count);
+}
+
+ /*========================================================================*
+ * Function: NI_DetectChanges
+ *
+ * Abstract:
+ *	Compares values with the values last sent.
+ *
+ * Returns:
+ *	the number of changed values
+========================================================================*/
+int32_t NI_DetectChanges(int32_t values, const double *current, const double *sent, const double *band, unsigned char *changed)
+{
+	int32_t c = 0, found = 0;
+
+	switch (NI_FilterKernel())
+	{
+#if defined (NI_FILTER_HAS_AVX2)
+		case NI_FILTER_AVX2:
+			c = NI_DetectAvx2(values, current, sent, band, changed, &found);
+			break;
+#endif
+#if defined (NI_FILTER_HAS_NEON)
+		case NI_FILTER_NEON:
+			c = NI_DetectNeon(values, current, sent, band, changed, &found);
+			break;
+#endif
+		default:
+			break;
+	}
+	return found + NI_DetectScalar(c, values, current, sent, band, changed);
+}
+
+ /*========================================================================*
+ * Function: NI_BiquadCoefficients
+ *
+ * Abstract:
+ *	Normalizes second order sections { b0, b1, b2, a0, a1, a2 } by a0.
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if an a0 is 0
+========================================================================*/
+int32_t NI_BiquadCoefficients(int32_t sections, const double *coefficients, double *sos)
+{
+	int32_t s;
+
+	for (s = 0; s < sections; s++)
+	{
+		if (coefficients[6 * s + 3] == 0.0)
+		{
+			return NI_ERROR;
+		}
+	}
+
+	for (s = 0; s < sections; s++)
+	{
+		const double *k = coefficients + 6 * s;
+
+		sos[5 * s] = k[0] / k[3];
+		sos[5 * s + 1] = k[1] / k[3];
+		sos[5 * s + 2] = k[2] / k[3];
+		sos[5 * s + 3] = k[4] / k[3];
+		sos[5 * s + 4] = k[5] / k[3];
+	}
+	return NI_OK;
+}
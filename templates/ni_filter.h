@@ -0,0 +1,157 @@
+/*========================================================================*
+ * NI VeriStand Model Framework
+ * Filter banks
+ *
+ * Abstract:
+ *      FIR filters and biquad cascades applied to many channels at once, for the
+ *      "Filters" blocks of the model definition, the banks of LTI blocks and the
+ *      change detection of NIRT_ProbeSignalChanges. All channels of a bank share the
+ *      coefficients. The state is stored by element (structure of arrays): the
+ *      values of one tap or section for all channels are contiguous, padded to
+ *      NI_FILTER_STRIDE(channels), so one vector instruction filters
+ *      NI_FILTER_LANES channels.
+ *
+ *      The kernels use AVX2 and FMA on x86 processors supporting them, NEON on
+ *      64 bit ARM, and scalar code otherwise or when NI_FILTER_NO_SIMD is
+ *      defined. The instruction set is chosen at run time, so the model library
+ *      needs no special compiler flags and still runs on older processors.
+ *
+ *========================================================================*/
+
+#ifndef NI_FILTER_H
+#define NI_FILTER_H
+
+#include "ni_modelframework.h"
+
+/* Channels filtered by one vector kernel iteration, the state of a bank is padded to a multiple of it */
+#define NI_FILTER_LANES	4
+#define NI_FILTER_STRIDE(channels)	((((channels) + NI_FILTER_LANES - 1) / NI_FILTER_LANES) * NI_FILTER_LANES)
+
+/* Number of doubles of the state of a bank */
+#define NI_FIR_HISTORY(taps, channels)		(2 * (taps) * NI_FILTER_STRIDE(channels))
+#define NI_BIQUAD_STATE(sections, channels)	(2 * (sections) * NI_FILTER_STRIDE(channels))
+
+/* Largest number of states of an LTI bank, NI_LtiBank keeps them in registers or on the stack */
+#define NI_LTI_BANK_ORDER	32
+
+/* Instruction sets of the kernels, see NI_FilterKernel */
+#define NI_FILTER_SCALAR	0
+#define NI_FILTER_AVX2		1
+#define NI_FILTER_NEON		2
+
+ /*========================================================================*
+ * Function: NI_FilterKernel
+ *
+ * Abstract:
+ *	Detects the instruction set of the kernels on the first call. Call it once
+ *	before the first step so that the detection does not run in real time.
+ *
+ * Returns:
+ *	NI_FILTER_SCALAR, NI_FILTER_AVX2 or NI_FILTER_NEON
+ *========================================================================*/
+int32_t NI_FilterKernel(void);
+
+ /*========================================================================*
+ * Function: NI_FirBank
+ *
+ * Abstract:
+ *	Filters one sample of every channel: y[c] = h[0] u[c] + h[1] u[c](n-1) + ...
+ *	The delay line holds every sample twice, so the last taps samples are
+ *	always contiguous.
+ *
+ * Input Parameters:
+ *	taps		: number of coefficients
+ *	channels	: number of channels
+ *	h			: coefficients, h[0] applies to the current sample
+ *	u			: one sample per channel
+ *
+ * Input/Output Parameters:
+ *	history		: delay line, NI_FIR_HISTORY(taps, channels) doubles, zero at rest
+ *	pos			: position in the delay line, 0 at rest
+ *
+ * Output Parameters:
+ *	y			: one output per channel, may be u
+ *========================================================================*/
+void NI_FirBank(int32_t taps, int32_t channels, const double *h, double *history, int32_t *pos, const double *u, double *y);
+
+ /*========================================================================*
+ * Function: NI_BiquadBank
+ *
+ * Abstract:
+ *	Filters one sample of every channel through a cascade of biquad sections
+ *	in transposed direct form II.
+ *
+ * Input Parameters:
+ *	sections	: number of sections
+ *	channels	: number of channels
+ *	sos			: normalized coefficients of NI_BiquadCoefficients, 5 per section
+ *	u			: one sample per channel
+ *
+ * Input/Output Parameters:
+ *	state		: NI_BIQUAD_STATE(sections, channels) doubles, zero at rest
+ *
+ * Output Parameters:
+ *	y			: one output per channel, may be u
+ *========================================================================*/
+void NI_BiquadBank(int32_t sections, int32_t channels, const double *sos, double *state, const double *u, double *y);
+
+ /*========================================================================*
+ * Function: NI_BiquadCoefficients
+ *
+ * Abstract:
+ *	Normalizes second order sections { b0, b1, b2, a0, a1, a2 } to the
+ *	{ b0, b1, b2, a1, a2 } / a0 of NI_BiquadBank.
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if an a0 is 0, sos is then left unchanged
+ *========================================================================*/
+int32_t NI_BiquadCoefficients(int32_t sections, const double *coefficients, double *sos);
+
+ /*========================================================================*
+ * Function: NI_LtiBank
+ *
+ * Abstract:
+ *	Advances count copies of a discrete state-space system sharing the matrices:
+ *	y = Cd x + Dd u, then x = Ad x + Bd u. The inputs, outputs and states are
+ *	stored by element, u[j * count + k] is input j of copy k, so one vector
+ *	instruction advances NI_FILTER_LANES copies.
+ *
+ * Input Parameters:
+ *	n			: number of states, at most NI_LTI_BANK_ORDER
+ *	m			: number of inputs
+ *	p			: number of outputs
+ *	coeffs		: Ad, Bd, Cd and Dd one after the other, row-major
+ *	u			: m * count inputs
+ *	count		: number of copies
+ *
+ * Input/Output Parameters:
+ *	x			: n * count states
+ *
+ * Output Parameters:
+ *	y			: p * count outputs, must not overlap u
+ *========================================================================*/
+void NI_LtiBank(int32_t n, int32_t m, int32_t p, const double *coeffs, double *x, const double *u, double *y, int32_t count);
+
+ /*========================================================================*
+ * Function: NI_DetectChanges
+ *
+ * Abstract:
+ *	Compares values with the values last sent: a value changed if it moved more
+ *	than its band, or between NaN and a number. A negative band marks every
+ *	value unless the difference is NaN (both NaN, or the same infinity).
+ *
+ * Input Parameters:
+ *	values		: number of values
+ *	current		: the values, e.g. read from the published frame
+ *	sent		: the values last sent
+ *	band		: the deadband of each value
+ *
+ * Output Parameters:
+ *	changed		: 1 where the value changed, 0 otherwise
+ *
+ * Returns:
+ *	the number of changed values
+ *========================================================================*/
+int32_t NI_DetectChanges(int32_t values, const double *current, const double *sent, const double *band, unsigned char *changed);
+
+#endif
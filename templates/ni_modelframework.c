@@ -16,11 +16,21 @@
  *
  *========================================================================*/
  
+#if defined (kNIOSLinux) && !defined (_GNU_SOURCE)
+	/* CPU affinity of the subsystem workers */
+	#define _GNU_SOURCE
+#endif
+
  /* Model Framework API */
 #include "ni_modelframework.h"
 
 /* model.h is user generated and declares the Parameters type  */
 #include "model.h"
+#include <stddef.h>
+#include <math.h>
+#ifdef NI_CHANGE_STREAMS
+	#include "ni_filter.h"
+#endif
 
 /*
  * NI VeriStand Model Framework API version
@@ -122,20 +132,45 @@ NI_Version NIVS_APIversion DataSection(".NIVS.APIVersion") = {NIMF_VER_MAJOR, NI
 #define EXT_IN		0
 #define EXT_OUT		1
 
-Parameters rtParameter[2];
-int32_t READSIDE = 0;
+/* Number of threads, besides the step thread, that run the model's subsystems (see model.h) */
+#if !defined (NI_SUBSYSTEM_WORKERS) || defined (VXWORKS)
+	#undef NI_SUBSYSTEM_WORKERS
+	#define NI_SUBSYSTEM_WORKERS 0
+#endif
+
+/* Number of spins after which a waiting thread yields the CPU */
+#define NI_SPIN_YIELD	4096
+
+#ifdef kNIOSLinux
+	# include <sched.h>
+	# include <unistd.h>
+	# include <fcntl.h>
+	# include <sys/mman.h>
+	# include <sys/stat.h>
+	# include <errno.h>
+	# include <signal.h>
+#endif
+
+/* NI_THREAD_LOCAL
+ * Gives each thread its own instance of a static variable */
+#ifdef _MSC_VER
+	#define NI_THREAD_LOCAL __declspec(thread)
+#else
+	#define NI_THREAD_LOCAL __thread
+#endif
+
+#if NI_SUBSYSTEM_WORKERS > 0 && defined (kNIOSLinux)
+	# include <pthread.h>
+	# define NI_THREAD pthread_t
+#elif NI_SUBSYSTEM_WORKERS > 0
+	# define NI_THREAD HANDLE
+#endif
+
+/* Per-model runtime state: parameter buffers, IO, signals and NIRT_system (see model.h) */
+ModelArena rtModel;
 unsigned char ReadSideDirtyFlag = 0, WriteSideDirtyFlag = 0;
 int32_t NumTasks DataSection(".NIVS.numtasks") = 1;
 
-struct { 
-	int32_t stopExecutionFlag;
-	const char *errmsg;
-	HANDLE flip;
-	uint32_t inCriticalSection;
-	int32_t SetParamTxStatus;
-	double timestamp;
-} NIRT_system;
-
  /*========================================================================*
  * Model specifications
  * Defined externally by the user's model source.
@@ -151,9 +186,189 @@ extern int32_t OutportSize;
 extern NI_ExternalIO rtIOAttribs[];
 extern NI_Parameter rtParamAttribs[];
 extern int32_t ParamDimList[];
-extern NI_Signal rtSignalAttribs[];
+extern const NI_Signal rtSignalAttribs[];
+extern const char rtStrings[];
+extern const NI_MetadataHeader* const rtMetadataImage;
 extern int32_t SigDimList[];
+#ifdef NI_CHANGE_STREAMS
+extern const double rtSignalDeadbands[];
+#endif
 extern Parameters initParams;
+extern ParamSizeWidth Parameters_sizes[];
+#ifdef NI_STEADY_STATE
+extern int32_t SteadyStateSize;
+extern NI_SteadyState rtSteadyStates[];
+extern int32_t SteadyInputSize;
+extern int32_t SteadyInputList[];
+extern double SteadyInputs[];
+#endif
+#ifdef NI_PURE_MODEL
+extern double MemoInputs[];
+#endif
+extern int32_t SubsystemSize;
+extern int32_t SubsystemDepList[];
+extern NI_Subsystem rtSubsystems[];
+
+/* Steady-state detection: whether the last computed step converged, and what it was computed from */
+static struct {
+	int32_t steady;
+	int32_t nullInputs;
+	uint32_t paramGeneration;
+	uint32_t probeGeneration;
+	uint32_t skippedInRow;		/* steps skipped since the last computed one */
+	uint32_t quietSteps;		/* computed steps since the anchors were set */
+	double skippedSteps;
+} NI_SteadyStateInfo;
+
+/* Deadline-aware shedding of optional work: the deadline of the current step and how
+   often optional work was shed. stepShed is counted by the workers running the step. */
+static struct {
+	double deadline;
+	volatile int32_t shedding;
+	volatile int32_t stepShed;
+	double stepCost;
+	double shedSteps;
+	double shedCount;
+} NI_DeadlineInfo;
+
+/* Staging copy of the write side for NIRT_SetParameterBatch */
+static Parameters NI_ParamStaging;
+
+#ifdef NI_PARAM_QUEUE_SIZE
+/* Ticks covered by one turn of the timing wheel of the queued parameter changes, a power of two */
+#ifndef NI_PARAM_WHEEL_SIZE
+	#define NI_PARAM_WHEEL_SIZE	1024
+#endif
+
+/* Time-tagged parameter changes. Producers claim slots of a bounded ring with a CAS on tail;
+   a slot's sequence tells whose turn it is (pos: free for producer pos, pos + 1: filled for
+   the step, see NIRT_QueueParameter). The step moves filled slots to the bucket of their 
+   tick in a timing wheel, a list in queue order, and applies the entries of the bucket of
+   the current tick that are due. */
+typedef struct {
+	volatile int64_t sequence;
+	uint64_t tick;		/* tick of the step the change takes effect at */
+	int32_t index;
+	int32_t subindex;
+	double value;
+} NI_QueuedParameter;
+
+typedef struct {
+	uint64_t tick;
+	int32_t next;		/* next entry of the bucket or of the free list, -1 at the end */
+	int32_t index;
+	int32_t subindex;
+	double value;
+} NI_PendingParameter;
+
+static struct {
+	NI_CACHE_ALIGNED volatile int64_t tail;
+	NI_CACHE_ALIGNED int64_t head;
+	uint64_t nextTick;		/* first tick whose bucket has not been applied */
+	int32_t free;			/* first free pending entry, -1 if none */
+	uint32_t touched[(NI_PARAMETER_COUNT + 31) / 32 + 1];	/* parameters changed on the read side since the last commit */
+	int32_t first[NI_PARAM_WHEEL_SIZE];	/* first and last pending entry of the bucket of a tick, -1 if empty */
+	int32_t last[NI_PARAM_WHEEL_SIZE];
+	NI_QueuedParameter slots[NI_PARAM_QUEUE_SIZE];
+	NI_PendingParameter pending[NI_PARAM_QUEUE_SIZE];
+} NI_ParamQueue;
+#endif
+
+/* Watched signals: the last NIRT_ProbeSignals list and the NIRT_SubscribeSignal subscriptions,
+   rtModel.probed is their union */
+static uint32_t NI_ProbeList[NI_PROBE_WORDS + 1];
+static uint32_t NI_Subscribed[NI_PROBE_WORDS + 1];
+
+/* Each thread has its own NI_ThreadTag, the scheduling calls record the address of the one 
+   of the thread running the model: its probes read the live signals */
+static NI_THREAD_LOCAL char NI_ThreadTag;
+static const char* volatile NI_ModelThread;
+
+#ifdef NI_CHANGE_STREAMS
+#ifndef NI_KEYFRAME_INTERVAL
+	#define NI_KEYFRAME_INTERVAL	1000
+#endif
+
+/* Change-only probing: per stream the list of signals of the last call, the values sent for
+   them, their deadbands and when the next keyframe is due. The arrays are indexed by the
+   position in the list. The list is split into runs: double signals adjacent in the arena,
+   compared where they are, and the other signals, converted into current first. */
+typedef struct {
+	int32_t list[NI_SIGNAL_COUNT + 1];
+	int32_t run[NI_SIGNAL_COUNT + 2];		/* first position of each run, run[runs] = count */
+	ptrdiff_t source[NI_SIGNAL_COUNT + 1];	/* per run: offset of its doubles in ModelArena, -1 for current */
+	double current[NI_SIGNAL_COUNT + 1];
+	double sent[NI_SIGNAL_COUNT + 1];
+	double band[NI_SIGNAL_COUNT + 1];		/* deadbands of list, refreshed when the list or a deadband changes */
+	unsigned char changed[NI_SIGNAL_COUNT + 1];
+	int32_t count;						/* length of list */
+	int32_t runs;						/* number of runs */
+	int32_t calls;						/* calls since the last keyframe */
+	int32_t resync;						/* next call sends a keyframe */
+	uint32_t bandGeneration;			/* NI_DeadbandGeneration of band */
+} NI_ChangeStream;
+
+static NI_ChangeStream NI_ChangeStreams[NI_CHANGE_STREAMS];
+static double NI_Deadbands[NI_SIGNAL_COUNT + 1];
+static uint32_t NI_DeadbandGeneration;	/* advanced by NIRT_SetSignalDeadband */
+#endif
+
+/* Published outputs: NIRT_PostOutputs copies the IO and signals of the step (rtModel from the 
+   cache line holding inport up to the parameters) into the back frame and makes it the front 
+   frame. Host threads probe the front frame while the next step computes. The sequence of a 
+   frame is odd while it is written; a reader that raced a flip sees it change and retries. */
+#define NI_PUBLISHED_BEGIN	(offsetof(ModelArena, inport) & ~(size_t)(NI_CACHE_LINE_SIZE - 1))
+#define NI_PUBLISHED_SIZE	(offsetof(ModelArena, parameters) - NI_PUBLISHED_BEGIN)
+
+typedef struct {
+	volatile uint32_t sequence;
+	double timestamp;
+	NI_CACHE_ALIGNED unsigned char data[NI_PUBLISHED_SIZE];
+} NI_PublishedFrame;
+
+/* The probe list of the host threads is handed over the same way: requestSequence is odd 
+   while a host thread writes request, NIRT_PostOutputs takes a list of a new sequence and
+   retries at the next step if it raced a writer. */
+static struct {
+	NI_PublishedFrame frame[2];
+	volatile int32_t front;					/* -1 until the first NIRT_PostOutputs */
+	volatile int64_t requestSequence;		/* advanced by 2 for every new probe list */
+	int64_t requestTaken;					/* sequence of the list NIRT_PostOutputs took last */
+	uint32_t request[NI_PROBE_WORDS + 1];	/* signals probed from the front frame, watched from the next NIRT_PostOutputs */
+} NI_Published;
+
+#if defined (NI_SHM_PUBLISH) && defined (kNIOSLinux)
+/* Shared-memory segment the step publishes its IO and signals to (see NI_ShmHeader) */
+static struct {
+	NI_ShmHeader *header;
+	unsigned char *data;	/* IO and signals, laid out as the published frames */
+	double *outports;		/* outport values, as in outData */
+} NI_Shm;
+#endif
+
+/* Output memoization of a pure model: whether the last step was computed, and what it was computed from */
+static struct {
+	int32_t valid;
+	int32_t nullInputs;
+	uint32_t paramGeneration;
+	uint32_t probeGeneration;
+	double reusedSteps;
+} NI_MemoInfo;
+
+/* Worker pool running the subsystems of a step.
+   claim holds the step generation in the upper 32 bits and the index of the next
+   subsystem to run in the lower 32 bits; subsystems are claimed in topological 
+   order, so a claimed subsystem only ever waits on subsystems already running. */
+static struct {
+	NI_CACHE_ALIGNED volatile int64_t claim;
+	NI_CACHE_ALIGNED volatile int32_t remaining;
+	volatile int32_t stop;
+	int32_t running;
+	double timestamp;
+#if NI_SUBSYSTEM_WORKERS > 0
+	NI_THREAD threads[NI_SUBSYSTEM_WORKERS];
+#endif
+} NI_SubsystemPool;
 
  /*========================================================================*
  * Function: SetErrorMessage
@@ -199,837 +414,3417 @@ void SetErrorMessage(char *ErrMsg, int32_t isError)
 }
 
  /*========================================================================*
- * Function: NIRT_GetModelFrameworkVersion
+ * Function: NI_StringEntry
  *
  * Abstract:
- *	Returns the version of the NI VeriStand Model Framework
+ *	Decodes the entry of an interned name in rtStrings: the distance back to the
+ *	entry of its prefix as a varint (0 if it has none), then the part after the prefix
+ *	and its '/'.
  *
- * Output Parameters
- *	major : major version number
- *	minor : minor version number
- *	fix   : fix version number
- *	build : build version number
+ * Parameters:
+ *	offset : offset of the name in rtStrings
+ *	prefix : offset of the prefix of the name, NI_NO_PREFIX if it has none (out)
  *
  * Returns:
- *	NI_OK if no error
- *========================================================================*/
-DLL_EXPORT int32_t NIRT_GetModelFrameworkVersion(uint32_t* major, uint32_t* minor, uint32_t* fix, uint32_t* build)
+ *	the part of the name after the prefix
+========================================================================*/
+#define NI_NO_PREFIX	0xFFFFFFFFu
+
+static const char* NI_StringEntry(uint32_t offset, uint32_t *prefix)
 {
-	*major = NIVS_APIversion.major;
-	*minor = NIVS_APIversion.minor;
-	*fix = NIVS_APIversion.fix;
-	*build = NIVS_APIversion.build;
+	const unsigned char *p = (const unsigned char *)rtStrings + offset;
+	uint32_t distance = 0, shift = 0;
 	
-	return NI_OK;
+	do
+	{
+		distance |= (uint32_t)(*p & 0x7f) << shift;
+		shift += 7;
+	} while (*p++ & 0x80);
+	
+	*prefix = (distance != 0) ? offset - distance : NI_NO_PREFIX;
+	return (const char *)p;
 }
 
  /*========================================================================*
- * Function: NIRT_ModelStart
- *
- * Abstract:
- *	Executes before the first time step and only once within a model's execution.
+ * Function: NI_StringLength
  *
  * Returns:
- *	NI_OK if no error
- *========================================================================*/
-DLL_EXPORT int32_t NIRT_ModelStart(void)
+ *	the length of an interned name
+========================================================================*/
+static uint32_t NI_StringLength(uint32_t offset)
 {
-	return USER_ModelStart();
+	uint32_t prefix;
+	const char *leaf = NI_StringEntry(offset, &prefix);
+	
+	return ((prefix != NI_NO_PREFIX) ? NI_StringLength(prefix) + 1 : 0) + (uint32_t)strlen(leaf);
 }
 
  /*========================================================================*
- * Function: NIRT_ModelError
+ * Function: NI_CopyString
  *
  * Abstract:
- *	Check for any simulation errors. 
- * 
- * Input/Output Parameters:
- *	msglen	: (in) length of input string (out) length of output string 
- * 
- * Output Parameters: 
- *	errmsg	: string containing error message (if any occurred). 
+ *	Copies the first size characters of an interned name, as strncpy does from a longer
+ *	string: the copy is not NUL terminated.
  *
  * Returns:
- *	NI_OK if no error
- *========================================================================*/
-DLL_EXPORT int32_t NIRT_ModelError(char* Errmsg, int32_t* msglen)
+ *	the number of characters copied
+========================================================================*/
+static uint32_t NI_CopyString(uint32_t offset, char *buffer, uint32_t size)
 {
-	int32_t retVal = NI_OK;
-	const char *simStoppedMsg = "The model simulation was stopped, but no reason was specified. This may be expected behavior.";
+	uint32_t prefix, n = 0;
+	const char *leaf = NI_StringEntry(offset, &prefix);
 	
-	if (NIRT_system.errmsg != NULL)
-	{
-		/* Set error condition */
-		retVal = NI_ERROR;
-		
-		if (*msglen > 0) 
-		{
-			if (*msglen > (int32_t)strlen(NIRT_system.errmsg)) 
-			{
-				/* Get error message */
-				*msglen = strlen(NIRT_system.errmsg);
-			}
-			
-			/* Return error message */
-			strncpy(Errmsg, NIRT_system.errmsg, *msglen);
-		}
-	}
-	else if(NIRT_system.stopExecutionFlag == 1)
+	if (prefix != NI_NO_PREFIX)
 	{
-		/* No error */
-		retVal = NI_OK; 
-		
-		/* Execution stopped, but without a message. Return generic message. */
-		if (*msglen > 0) 
+		n = NI_CopyString(prefix, buffer, size);
+		if (n < size)
 		{
-			if (*msglen > (int32_t)strlen(simStoppedMsg)) 
-			{
-				/* Get error message */
-				*msglen = strlen(simStoppedMsg);
-			}
-			
-			/* Return error message */
-			strncpy(Errmsg, simStoppedMsg, *msglen);
+			buffer[n++] = '/';
 		}
 	}
-	else
+	
+	while ((n < size) && (*leaf != '\0'))
 	{
-		/* No error */
-		retVal = NI_OK; 
-		*msglen = 0;
+		buffer[n++] = *leaf++;
 	}
 	
-	return retVal;	
+	return n;
 }
 
  /*========================================================================*
- * Function: NIRT_InitializeModel
- *
- * Abstract:
- *	Initializes internal structures and prepares model for execution. 
- * 
- * Input Parameters:
- *	finaltime	: the final time until which the model should run.
- * 
- * Output Parameters:
- *	outTimeStep	: the base time step of the model scheduler.
- *	num_in		: number of external inputs
- *	num_out		: number of external outputs
- *	num_tasks	: number of Tasks (for multirate models only). 
+ * Function: NI_MatchString
  *
  * Returns:
- *	NI_OK if no error
- *========================================================================*/
-DLL_EXPORT int32_t NIRT_InitializeModel(double finaltime, double *outTimeStep, int32_t *num_in, int32_t *num_out, int32_t* num_tasks) 
-{		
-	NIRT_system.SetParamTxStatus = NI_OK;
-	NIRT_system.timestamp = 0.0;
-	
-	/* Initialize parameter buffers */
-	memcpy(&rtParameter[0], &initParams, sizeof(Parameters));
-	memcpy(&rtParameter[1], &initParams, sizeof(Parameters));
+ *	the rest of str after an interned name, NULL if str does not start with it
+========================================================================*/
+static const char* NI_MatchString(uint32_t offset, const char *str)
+{
+	uint32_t prefix;
+	const char *leaf = NI_StringEntry(offset, &prefix);
+	size_t len = strlen(leaf);
 	
-	NIRT_system.flip = CreateSemaphore(NULL, 1, 1, NULL);
-	if (NIRT_system.flip == NULL)
+	if (prefix != NI_NO_PREFIX)
 	{
-		SetErrorMessage("Failed to create semaphore.", 1);
+		str = NI_MatchString(prefix, str);
+		if ((str == NULL) || (*str++ != '/'))
+		{
+			return NULL;
+		}
 	}
 	
-	/* Return model specification */
-	NIRT_GetModelSpec(NULL, 0, outTimeStep, num_in, num_out, num_tasks);
+	return (strncmp(str, leaf, len) == 0) ? str + len : NULL;
+}
+
+static int32_t NI_StringEquals(uint32_t offset, const char *str)
+{
+	const char *rest = NI_MatchString(offset, str);
 	
-	/* Call custom initialization */
-	return USER_Initialize();
+	return (rest != NULL) && (*rest == '\0');
 }
 
  /*========================================================================*
- * Function: NI_ProbeOneSignal
- *
- * Abstract:
- *	Returns the value to a model's signal during it's execution.
- *
- * Parameters:
- *	idx : the signal's index to probe
- *	value : the buffer into where the signal's value is written
- *	len  : the signal's length in the "value" parameter.
- *	count : the number of elements to probe in a multidimensional signal
+ * Function: NI_HashString
  *
  * Returns:
- *	the total number of probed signal elements
+ *	the FNV-1a hash continued with the characters of an interned name
 ========================================================================*/
-int32_t NI_ProbeOneSignal(int32_t idx, double *value, int32_t len, int32_t *count)
+static uint32_t NI_HashString(uint32_t hash, uint32_t offset)
 {
-	int32_t subindex = 0;
-  	int32_t sublength = 0;
+	uint32_t prefix;
+	const unsigned char *p = (const unsigned char *)NI_StringEntry(offset, &prefix);
 	
-	/*verify that index is within bounds*/
-  	if (idx > SignalSize) 
+	if (prefix != NI_NO_PREFIX)
 	{
-		SetErrorMessage("Signal index is out of bounds.", 1);
-	    return NI_ERROR;
-    }
+		hash = (NI_HashString(hash, prefix) ^ '/') * 16777619u;
+	}
 	
-	sublength = rtSignalAttribs[idx].width;
-  	while ((subindex < sublength) && (*count < len))
+	for (; *p; p++)
 	{
-		/* Convert the signal's internal datatype to double and return its value */
-    	value[(*count)++] = USER_GetValueByDataType((uintptr_t *)rtSignalAttribs[idx].addr, subindex++, rtSignalAttribs[idx].datatype);
+		hash = (hash ^ *p) * 16777619u;
 	}
 	
-  	return *count;
+	return hash;
 }
 
  /*========================================================================*
- * Function: NIRT_ProbeSignals
+ * Function: NI_SpinWait
  *
  * Abstract:
- *	returns the latest signal values. 
+ *	Pauses a spinning thread, yielding the CPU every NI_SPIN_YIELD spins so a spinning 
+ *	thread can not starve a thread of the same priority on the same CPU.
  *
- * Input Parameters: 
- *	sigindices	: list of signal indices to be probed.
- *	numsigs		: length of sigindices array.
- * 	
- *		NOTE: (Implementation detail) the sigindices array that is passed in is delimited by a value of -1. 
- *		Thus the # of valid indices in the sigindices table is min(numsigs, index of value -1) - 1. 
- *		Reason for subtracting 1, the first index in the array is used for bookkeeping and should be copied
- *		into the 0th index in the signal values buffer. 
- *		Also, the 1st index in the signal values buffer should contain the current timestamp. Hence valid 
- *		signal data should be filled in starting from index 2. Any non-scalar signals should be added to the 
- *		buffer in row-order. 
- * 	  
- * Input/Output Parameters
- *	num			: (in) length of sigvalues buffer (out) number of values returned in the buffer
- * 	  
- * Output Parameters: 
- *	value		: array of signal values
+ * Parameters:
+ *	spins : spin counter of the caller, set to 0 before the wait
  *
  * Returns:
- *	NI_OK if no error
- *========================================================================*/
-DLL_EXPORT int32_t NIRT_ProbeSignals(int32_t *sigindices, int32_t numsigs, double *value, int32_t* len)
+ *	(void)
+========================================================================*/
+static void NI_SpinWait(int32_t *spins)
 {
-	int32_t i = 0;
-	int32_t count = 0;
-	int32_t idx = 0;
+	NI_CpuRelax();
 	
-	if (!NIRT_system.inCriticalSection)
+	if (++(*spins) >= NI_SPIN_YIELD)
 	{
-    	SetErrorMessage("SignalProbe should only be called between ScheduleTasks and PostOutputs", 1);
+		*spins = 0;
+#if defined (VXWORKS)
+		taskDelay(0);
+#elif defined (kNIOSLinux)
+		sched_yield();
+#else
+		SwitchToThread();
+#endif
 	}
-	
-	/* Get the index to the first signal */
-  	if ((*len > 1)  && (numsigs > 0)) 
-	{
-	    value[count++] = sigindices[0];
-	    value[count++] = 0;
-  	}
+}
 
-	/* Get the second and other signals */
-  	for (i = 1; (i < numsigs) && (count < *len); i++)
+ /*========================================================================*
+ * Function: NI_WorkSubsystems
+ *
+ * Abstract:
+ *	Claims and runs subsystems of the current step generation until all of them
+ *	have been claimed. Called by the step thread and by the workers.
+ *
+ * Returns:
+ *	(void)
+========================================================================*/
+static void NI_WorkSubsystems(void)
+{
+	int64_t claim, generation;
+	int32_t idx, i, spins;
+	
+	for (;;)
 	{
-	    idx = sigindices[i];
+		claim = NI_AtomicLoad64(&NI_SubsystemPool.claim);
+		generation = claim >> 32;
+		idx = (int32_t)(claim & 0xFFFFFFFF);
 		
-	    if (idx < 0)
+		if (idx >= SubsystemSize)
 		{
-    	  	break;
+			return;
 		}
 		
-    	if (idx < SignalSize)
+		if (!NI_AtomicCAS64(&NI_SubsystemPool.claim, claim, claim + 1))
 		{
-      		NI_ProbeOneSignal(idx, value, *len, &count);
+			/* Another thread claimed it first */
+			continue;
 		}
-  	}
-
-  	*len = count;
-	return count;	
+		
+		/* Wait for the subsystems this one depends on to complete in this generation */
+		for (i = 0; i < rtSubsystems[idx].numDeps; i++)
+		{
+			spins = 0;
+			while (NI_AtomicLoad64(&rtSubsystems[SubsystemDepList[rtSubsystems[idx].depListOffset + i]].done) != generation)
+			{
+				NI_SpinWait(&spins);
+			}
+		}
+		
+		if (rtSubsystems[idx].optional)
+		{
+			NI_RunOptionalSubsystem(rtSubsystems[idx].fn, &rtSubsystems[idx].cost, NI_SubsystemPool.timestamp);
+		}
+		else
+		{
+			rtSubsystems[idx].fn(NI_SubsystemPool.timestamp);
+		}
+		
+		NI_AtomicStore64(&rtSubsystems[idx].done, generation);
+		NI_AtomicAdd32(&NI_SubsystemPool.remaining, -1);
+	}
 }
 
+#if NI_SUBSYSTEM_WORKERS > 0
  /*========================================================================*
- * Function: NIRT_GetSignalSpec
+ * Function: NI_SubsystemWorker
  *
  * Abstract:
- *	If index == -1, lookup parameter by the ID.
- *	If ID_len == 0 or if ID == null, return number of parameters in model.
- *	Otherwise, lookup parameter by index, and return the information. 
- *
- * Input/Output Parameters:
- *	index		: index of the signal (in/out) 
- *	ID			: ID of signal to be looked up (in), ID of signal at index (out)
- *	ID_len		: length of input ID(in), length of ID (out)
- *	bnlen		: length of buffer blkname (in), length of output blkname (out)
- *	snlen		: length of buffer signame (in), length of output signame (out)
- *
- * Output Parameters:  
- *	blkname		: Name of the source block for the signal
- *	portnum		: port number of the block that is the source of the signal (0 indexed)
- *	signame		: Name of the signal
- *	datatype	: same as with parameters. Currently assuming all data to be double. 
- *	dims		: The port's dimension of length 'numdims'. 
- *	numdims		: the port's number of dimensions. If a value of "-1" is specified, the minimum buffer size of "dims" is returned as its value. 
- *		
+ *	Persistent worker thread. Spin-waits for a step to publish work, so no thread
+ *	is created or woken up per step.
+========================================================================*/
+#ifdef kNIOSLinux
+static void* NI_SubsystemWorker(void* arg)
+#else
+static DWORD WINAPI NI_SubsystemWorker(LPVOID arg)
+#endif
+{
+	int32_t spins = 0;
+	UNUSED_PARAMETER(arg);
+	
+	while (!NI_AtomicLoad32(&NI_SubsystemPool.stop))
+	{
+		if ((int32_t)(NI_AtomicLoad64(&NI_SubsystemPool.claim) & 0xFFFFFFFF) < SubsystemSize)
+		{
+			NI_WorkSubsystems();
+			spins = 0;
+		}
+		else
+		{
+			NI_SpinWait(&spins);
+		}
+	}
+	
+	return 0;
+}
+#endif
+
+ /*========================================================================*
+ * Function: NI_StartSubsystemPool
+ *
+ * Abstract:
+ *	Starts the subsystem workers. When the calling (step) thread is pinned to a single
+ *	CPU, worker i is pinned to the (i+1)th CPU after it.
+ *
  * Returns:
- *	NI_OK if no error(if sigidx == -1, number of signals)
- *========================================================================*/
-DLL_EXPORT int32_t NIRT_GetSignalSpec(int32_t* sidx, char* ID, int32_t* ID_len, char* blkname, int32_t* bnlen, int32_t *portnum, char* signame, int32_t* snlen, int32_t *dattype, int32_t* dims, int32_t* numdim)
+ *	NI_OK if no error
+========================================================================*/
+static int32_t NI_StartSubsystemPool(void)
 {
-	  int32_t sigidx = *sidx;
-	  int32_t i = 0;
-	  char *addr = NULL;
-	  char *IDblk = 0;
-	  int32_t IDport = 0;
-	  
-	if (sigidx < 0) 
+#if NI_SUBSYSTEM_WORKERS > 0
+	int32_t i;
+#ifdef kNIOSLinux
+	cpu_set_t set;
+	int32_t cpu = -1;
+	int32_t ncpus = (int32_t)sysconf(_SC_NPROCESSORS_ONLN);
+	
+	if ((sched_getaffinity(0, sizeof(set), &set) == 0) && (CPU_COUNT(&set) == 1))
 	{
-		/* check if ID has been specified. */
-		if ((ID != NULL) && (ID_len != NULL) &&  (*ID_len > 0)) 
+		cpu = sched_getcpu();
+	}
+#endif
+
+	if (NI_SubsystemPool.running || (SubsystemSize == 0))
+	{
+		return NI_OK;
+	}
+	
+	/* Nothing to claim until the first step */
+	NI_SubsystemPool.claim = SubsystemSize;
+	NI_SubsystemPool.stop = 0;
+	
+	for (i = 0; i < NI_SUBSYSTEM_WORKERS; i++)
+	{
+#ifdef kNIOSLinux
+		if (pthread_create(&NI_SubsystemPool.threads[i], NULL, NI_SubsystemWorker, NULL) != 0)
 		{
-			/* parse ID into blkname and port */
-			addr = strrchr(ID, ':');
-			if (addr == NULL)
+			break;
+		}
+		
+		if (cpu >= 0)
+		{
+			CPU_ZERO(&set);
+			CPU_SET((cpu + 1 + i) % ncpus, &set);
+			pthread_setaffinity_np(NI_SubsystemPool.threads[i], sizeof(set), &set);
+		}
+#else
+		NI_SubsystemPool.threads[i] = CreateThread(NULL, 0, NI_SubsystemWorker, NULL, 0, NULL);
+		if (NI_SubsystemPool.threads[i] == NULL)
+		{
+			break;
+		}
+#endif
+		NI_SubsystemPool.running++;
+	}
+	
+	if (NI_SubsystemPool.running < NI_SUBSYSTEM_WORKERS)
+	{
+		SetErrorMessage("Failed to start all subsystem workers, subsystems run with fewer threads.", 0);
+	}
+#endif
+	return NI_OK;
+}
+
+ /*========================================================================*
+ * Function: NI_StopSubsystemPool
+ *
+ * Abstract:
+ *	Stops and joins the subsystem workers.
+========================================================================*/
+static void NI_StopSubsystemPool(void)
+{
+#if NI_SUBSYSTEM_WORKERS > 0
+	int32_t i;
+	
+	NI_AtomicStore32(&NI_SubsystemPool.stop, 1);
+	
+	for (i = 0; i < NI_SubsystemPool.running; i++)
+	{
+#ifdef kNIOSLinux
+		pthread_join(NI_SubsystemPool.threads[i], NULL);
+#else
+		WaitForSingleObject(NI_SubsystemPool.threads[i], INFINITE);
+		CloseHandle(NI_SubsystemPool.threads[i]);
+#endif
+	}
+	
+	NI_SubsystemPool.running = 0;
+#endif
+}
+
+ /*========================================================================*
+ * Function: NI_RunSubsystems
+ *
+ * Abstract:
+ *	Runs all subsystems of the model for the current step and returns once all of them
+ *	have completed. The step thread works on the subsystems too; without running 
+ *	workers the subsystems simply run in order on the step thread.
+ *
+ * Parameters:
+ *	timestamp : current simulation time, passed to each subsystem
+ *
+ * Returns:
+ *	NI_OK if no error
+========================================================================*/
+int32_t NI_RunSubsystems(double timestamp)
+{
+	int64_t generation = (NI_SubsystemPool.claim >> 32) + 1;
+	int32_t spins = 0;
+	int32_t i;
+	
+	if (!NI_SubsystemPool.running)
+	{
+		for (i = 0; i < SubsystemSize; i++)
+		{
+			if (rtSubsystems[i].optional)
 			{
-				return SignalSize;
+				NI_RunOptionalSubsystem(rtSubsystems[i].fn, &rtSubsystems[i].cost, timestamp);
 			}
-			
-			/* Calculate the char offset into the string after the port */
-			i = addr - ID;
-	  
-			/* malformed ID */
-			if (i <= 0)
+			else
 			{
-				return SignalSize;
+				rtSubsystems[i].fn(timestamp);
 			}
+		}
+		return NI_OK;
+	}
+	
+	/* Publish the step: the previous generation is complete, so nothing else writes claim or remaining */
+	NI_SubsystemPool.timestamp = timestamp;
+	NI_AtomicStore32(&NI_SubsystemPool.remaining, SubsystemSize);
+	NI_AtomicStore64(&NI_SubsystemPool.claim, generation << 32);
+	
+	NI_WorkSubsystems();
+	
+	while (NI_AtomicLoad32(&NI_SubsystemPool.remaining) > 0)
+	{
+		NI_SpinWait(&spins);
+	}
+	
+	return NI_OK;
+}
 
-			ID[i] = 0;
-			IDblk = ID;
-			IDport = atoi(ID+i+1);
+ /*========================================================================*
+ * Function: NI_Now
+ *
+ * Abstract:
+ *	Returns a monotonic time in seconds.
+========================================================================*/
+double NI_Now(void)
+{
+#if defined (VXWORKS) || defined (kNIOSLinux)
+	struct timespec ts;
+	
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#else
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	
+	if (frequency.QuadPart == 0)
+	{
+		QueryPerformanceFrequency(&frequency);
+	}
+	QueryPerformanceCounter(&counter);
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+#endif
+}
 
-			/* lookup the table for matching ID */
-			for (i = 0; i < SignalSize; i++) 
+ /*========================================================================*
+ * Function: NI_RunOptional
+ *
+ * Abstract:
+ *	Checks if optional work expected to take cost seconds still completes before the
+ *	deadline of the step (NI_DEADLINE_BUDGET of the base rate after the step started).
+ *	Once optional work is shed, the rest of the optional work of the step is shed too, 
+ *	so a step under pressure does not keep sampling the clock.
+ *
+ * Returns:
+ *	1 if the work should run, 0 if it is shed
+========================================================================*/
+int32_t NI_RunOptional(double cost)
+{
+#ifdef NI_DEADLINE_BUDGET
+	if (!NI_AtomicLoad32(&NI_DeadlineInfo.shedding) && (NI_Now() + cost <= NI_DeadlineInfo.deadline))
+	{
+		return 1;
+	}
+	
+	NI_AtomicStore32(&NI_DeadlineInfo.shedding, 1);
+	NI_AtomicAdd32(&NI_DeadlineInfo.stepShed, 1);
+	return 0;
+#else
+	UNUSED_PARAMETER(cost);
+	
+	return 1;
+#endif
+}
+
+ /*========================================================================*
+ * Function: NI_RunOptionalSubsystem
+ *
+ * Abstract:
+ *	Runs an optional function of the step unless NI_RunOptional sheds it, and updates 
+ *	its running cost estimate (an exponential moving average of its execution times).
+ *	The estimate decays while the function is shed, so one slow run (a page fault, a
+ *	preemption) does not shed it for good: it runs again once the estimate fits and
+ *	is then measured anew.
+ *
+ * Returns:
+ *	1 if the function ran, 0 if it was shed
+========================================================================*/
+int32_t NI_RunOptionalSubsystem(void (*fn)(double timestamp), double* cost, double timestamp)
+{
+#ifdef NI_DEADLINE_BUDGET
+	double start;
+	
+	if (!NI_RunOptional(*cost))
+	{
+		*cost *= 0.875;
+		return 0;
+	}
+	
+	start = NI_Now();
+	fn(timestamp);
+	*cost += (NI_Now() - start - *cost) * 0.125;
+#else
+	UNUSED_PARAMETER(cost);
+	fn(timestamp);
+#endif
+	
+	return 1;
+}
+
+ /*========================================================================*
+ * Function: NIRT_GetModelFrameworkVersion
+ *
+ * Abstract:
+ *	Returns the version of the NI VeriStand Model Framework
+ *
+ * Output Parameters
+ *	major : major version number
+ *	minor : minor version number
+ *	fix   : fix version number
+ *	build : build version number
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_GetModelFrameworkVersion(uint32_t* major, uint32_t* minor, uint32_t* fix, uint32_t* build)
+{
+	*major = NIVS_APIversion.major;
+	*minor = NIVS_APIversion.minor;
+	*fix = NIVS_APIversion.fix;
+	*build = NIVS_APIversion.build;
+	
+	return NI_OK;
+}
+
+ /*========================================================================*
+ * Function: NIRT_ModelStart
+ *
+ * Abstract:
+ *	Executes before the first time step and only once within a model's execution.
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_ModelStart(void)
+{
+	/* Workers are started here, so they are created by (and inherit the profile of) the step thread */
+	NI_StartSubsystemPool();
+	
+	return USER_ModelStart();
+}
+
+ /*========================================================================*
+ * Function: NI_TouchMemory
+ *
+ * Abstract:
+ *	Reads and writes back one byte per page of a buffer, so every page is mapped
+ *	(and locked when the process runs under mlockall). Must not be called while 
+ *	the model is executing.
+ *
+ * Parameters:
+ *	ptr : base address of the buffer
+ *	size : size of the buffer in bytes
+ *
+ * Returns:
+ *	(void)
+========================================================================*/
+void NI_TouchMemory(void* ptr, size_t size)
+{
+	volatile unsigned char *p = (volatile unsigned char *)ptr;
+	size_t i = 0;
+	
+	if ((p == NULL) || (size == 0))
+	{
+		return;
+	}
+	
+	for (i = 0; i < size; i += 4096)
+	{
+		p[i] = p[i];
+	}
+	
+	/* The last page may not be reached by the stride */
+	p[size - 1] = p[size - 1];
+}
+
+ /*========================================================================*
+ * Function: NI_Solve
+ *
+ * Abstract:
+ *	Solves L X = R by Gaussian elimination with partial pivoting. L is n x n and
+ *	destroyed, R is n x k and receives X. Matrices are row major.
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if L is singular
+========================================================================*/
+static int32_t NI_Solve(int32_t n, int32_t k, double *L, double *R)
+{
+	int32_t i, j, c, pivot;
+	double scale, t;
+	
+	for (c = 0; c < n; c++)
+	{
+		pivot = c;
+		for (i = c + 1; i < n; i++)
+		{
+			if (fabs(L[i * n + c]) > fabs(L[pivot * n + c]))
 			{
-				if (!strcmp(IDblk,rtSignalAttribs[i].blockname) && IDport==(rtSignalAttribs[i]. portno+1))
-				{
-					break;
-				}
+				pivot = i;
 			}
-
-			if (i < SignalSize)
+		}
+		
+		if (L[pivot * n + c] == 0.0)
+		{
+			return NI_ERROR;
+		}
+		
+		if (pivot != c)
+		{
+			for (j = c; j < n; j++)
 			{
-				sigidx = *sidx = i;
+				t = L[c * n + j]; L[c * n + j] = L[pivot * n + j]; L[pivot * n + j] = t;
 			}
-			else
+			for (j = 0; j < k; j++)
 			{
-				return SignalSize;
+				t = R[c * k + j]; R[c * k + j] = R[pivot * k + j]; R[pivot * k + j] = t;
 			}
-		} 
-		else 
-		{		
-			/* no index or ID specified. */
-			return SignalSize;
+		}
+		
+		for (i = c + 1; i < n; i++)
+		{
+			scale = L[i * n + c] / L[c * n + c];
+			for (j = c; j < n; j++)
+			{
+				L[i * n + j] -= scale * L[c * n + j];
+			}
+			for (j = 0; j < k; j++)
+			{
+				R[i * k + j] -= scale * R[c * k + j];
+			}
+		}
+	}
+	
+	for (i = n - 1; i >= 0; i--)
+	{
+		for (j = 0; j < k; j++)
+		{
+			t = R[i * k + j];
+			for (c = i + 1; c < n; c++)
+			{
+				t -= L[i * n + c] * R[c * k + j];
+			}
+			R[i * k + j] = t / L[i * n + i];
+		}
+	}
+	
+	return NI_OK;
+}
+
+/* C = A B, A is n x k, B is k x m */
+static void NI_MatMul(int32_t n, int32_t k, int32_t m, const double *A, const double *B, double *C)
+{
+	int32_t i, j, l;
+	
+	for (i = 0; i < n; i++)
+	{
+		for (j = 0; j < m; j++)
+		{
+			double sum = 0.0;
+			for (l = 0; l < k; l++)
+			{
+				sum += A[i * k + l] * B[l * m + j];
+			}
+			C[i * m + j] = sum;
+		}
+	}
+}
+
+ /*========================================================================*
+ * Function: NI_Expm
+ *
+ * Abstract:
+ *	Matrix exponential of an n x n matrix, by scaling and squaring with a (6,6) Pade 
+ *	approximant (Moler and Van Loan). The scaled matrix has a norm of at most 1/2,
+ *	for which the approximant is accurate to about 3e-16.
+ *
+ * Parameters:
+ *	M : the matrix
+ *	E : receives e^M
+ *	work : 4 n x n matrices
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if M is not finite
+========================================================================*/
+static int32_t NI_Expm(int32_t n, const double *M, double *E, double *work)
+{
+	double *X = work, *N = X + n * n, *D = N + n * n, *T = D + n * n;
+	double norm = 0.0, c = 1.0, scale;
+	int32_t i, j, k, squarings = 0;
+	
+	for (i = 0; i < n; i++)
+	{
+		double sum = 0.0;
+		for (j = 0; j < n; j++)
+		{
+			sum += fabs(M[i * n + j]);
+		}
+		norm = (sum > norm) ? sum : norm;
+	}
+	
+	if (!(norm < 1e300))
+	{
+		return NI_ERROR;
+	}
+	
+	while (norm > 0.5)
+	{
+		norm *= 0.5;
+		squarings++;
+	}
+	scale = ldexp(1.0, -squarings);
+	
+	/* E holds the scaled matrix, X its powers; N = sum c_k X^k, D = sum (-1)^k c_k X^k */
+	for (i = 0; i < n * n; i++)
+	{
+		E[i] = M[i] * scale;
+		X[i] = E[i];
+		N[i] = ((i % (n + 1)) == 0) ? 1.0 : 0.0;
+		D[i] = N[i];
+	}
+	
+	for (k = 1; k <= 6; k++)
+	{
+		c *= (double)(6 - k + 1) / (double)(k * (2 * 6 - k + 1));
+		if (k > 1)
+		{
+			NI_MatMul(n, n, n, X, E, T);
+			memcpy(X, T, (size_t)(n * n) * sizeof(double));
+		}
+		for (i = 0; i < n * n; i++)
+		{
+			N[i] += c * X[i];
+			D[i] += ((k & 1) ? -c : c) * X[i];
+		}
+	}
+	
+	if (NI_Solve(n, n, D, N) != NI_OK)
+	{
+		return NI_ERROR;
+	}
+	
+	for (k = 0; k < squarings; k++)
+	{
+		NI_MatMul(n, n, n, N, N, T);
+		memcpy(N, T, (size_t)(n * n) * sizeof(double));
+	}
+	
+	memcpy(E, N, (size_t)(n * n) * sizeof(double));
+	return NI_OK;
+}
+
+ /*========================================================================*
+ * Function: NI_TransferFunction
+ *
+ * Abstract:
+ *	State-space realization (controllable canonical form) of the proper transfer 
+ *	function num(s) / den(s) of order n. Coefficients are in descending powers of s.
+ *
+ * Parameters:
+ *	n : order, den has n + 1 coefficients
+ *	num : n + 1 coefficients, leading zeros for a lower degree
+ *	den : n + 1 coefficients, den[0] != 0
+ *	A, B, C, D : receive the n x n, n x 1, 1 x n and 1 x 1 matrices
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if den[0] is 0
+========================================================================*/
+int32_t NI_TransferFunction(int32_t n, const double *num, const double *den, double *A, double *B, double *C, double *D)
+{
+	int32_t i;
+	
+	if (den[0] == 0.0)
+	{
+		return NI_ERROR;
+	}
+	
+	memset(A, 0, (size_t)(n * n) * sizeof(double));
+	memset(B, 0, (size_t)n * sizeof(double));
+	D[0] = num[0] / den[0];
+	for (i = 0; i < n; i++)
+	{
+		A[i] = -den[i + 1] / den[0];
+		C[i] = num[i + 1] / den[0] - D[0] * den[i + 1] / den[0];
+		if (i > 0)
+		{
+			A[i * n + i - 1] = 1.0;
+		}
+	}
+	B[0] = 1.0;
+	
+	return NI_OK;
+}
+
+ /*========================================================================*
+ * Function: NI_Discretize
+ *
+ * Abstract:
+ *	Discretizes the continuous system x' = A x + B u, y = C x + D u at the sample 
+ *	time T, into x[k+1] = Ad x[k] + Bd u[k], y[k] = Cd x[k] + Dd u[k]. 
+ *	NI_ZOH is exact for inputs held over the sample: the exponential of the block 
+ *	matrix [A B; 0 0] T is [Ad Bd; 0 I]. NI_TUSTIN is the bilinear transform: with
+ *	W = (I - A T/2)^-1, Ad = W (I + A T/2), Bd = W B T, Cd = C W, Dd = D + C Bd / 2.
+ *	The outputs are only written on success.
+ *
+ * Parameters:
+ *	n, m, p : number of states, inputs and outputs
+ *	A, B, C, D : continuous matrices, row major
+ *	T : sample time
+ *	method : NI_ZOH or NI_TUSTIN
+ *	Ad, Bd, Cd, Dd : receive the discrete matrices
+ *	work : NI_DISCRETIZE_WORK(n, m) doubles
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the system cannot be discretized
+========================================================================*/
+int32_t NI_Discretize(int32_t n, int32_t m, int32_t p, const double *A, const double *B, const double *C, const double *D,
+					  double T, int32_t method, double *Ad, double *Bd, double *Cd, double *Dd, double *work)
+{
+	int32_t s = n + m, i, j;
+	
+	if (method == NI_ZOH)
+	{
+		double *M = work, *E = M + s * s;
+		
+		memset(M, 0, (size_t)(s * s) * sizeof(double));
+		for (i = 0; i < n; i++)
+		{
+			for (j = 0; j < n; j++)
+			{
+				M[i * s + j] = A[i * n + j] * T;
+			}
+			for (j = 0; j < m; j++)
+			{
+				M[i * s + n + j] = B[i * m + j] * T;
+			}
+		}
+		
+		if (NI_Expm(s, M, E, E + s * s) != NI_OK)
+		{
+			return NI_ERROR;
+		}
+		
+		for (i = 0; i < n; i++)
+		{
+			memcpy(Ad + i * n, E + i * s, (size_t)n * sizeof(double));
+			memcpy(Bd + i * m, E + i * s + n, (size_t)m * sizeof(double));
+		}
+		memcpy(Cd, C, (size_t)(p * n) * sizeof(double));
+		memcpy(Dd, D, (size_t)(p * m) * sizeof(double));
+		return NI_OK;
+	}
+	else if (method == NI_TUSTIN)
+	{
+		/* L = I - A T/2, R = [I + A T/2, B T, I] becomes [Ad, Bd, W] */
+		int32_t k = 2 * n + m;
+		double *L = work, *R = L + n * n;
+		
+		for (i = 0; i < n; i++)
+		{
+			for (j = 0; j < n; j++)
+			{
+				L[i * n + j] = ((i == j) ? 1.0 : 0.0) - 0.5 * T * A[i * n + j];
+				R[i * k + j] = ((i == j) ? 1.0 : 0.0) + 0.5 * T * A[i * n + j];
+				R[i * k + n + m + j] = (i == j) ? 1.0 : 0.0;
+			}
+			for (j = 0; j < m; j++)
+			{
+				R[i * k + n + j] = B[i * m + j] * T;
+			}
+		}
+		
+		if (NI_Solve(n, k, L, R) != NI_OK)
+		{
+			return NI_ERROR;
+		}
+		
+		for (i = 0; i < n; i++)
+		{
+			memcpy(Ad + i * n, R + i * k, (size_t)n * sizeof(double));
+			memcpy(Bd + i * m, R + i * k + n, (size_t)m * sizeof(double));
+		}
+		for (i = 0; i < p; i++)
+		{
+			for (j = 0; j < n; j++)
+			{
+				int32_t l;
+				double sum = 0.0;
+				for (l = 0; l < n; l++)
+				{
+					sum += C[i * n + l] * R[l * k + n + m + j];
+				}
+				Cd[i * n + j] = sum;
+			}
+			for (j = 0; j < m; j++)
+			{
+				int32_t l;
+				double sum = D[i * m + j];
+				for (l = 0; l < n; l++)
+				{
+					sum += 0.5 * C[i * n + l] * Bd[l * m + j];
+				}
+				Dd[i * m + j] = sum;
+			}
+		}
+		return NI_OK;
+	}
+	
+	return NI_ERROR;
+}
+
+ /*========================================================================*
+ * Function: NIRT_PrefaultMemory
+ *
+ * Abstract:
+ *	Touches every page of the model arena (parameter buffers, IO, signals and framework
+ *	state) and of any additional user buffers. Called by a real-time host after mlockall and before 
+ *	NIRT_ModelStart, so no page faults occur while the model is executing.
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_PrefaultMemory(void)
+{
+	NI_TouchMemory(&rtModel, sizeof(rtModel));
+	
+	return USER_PrefaultMemory();
+}
+
+ /*========================================================================*
+ * Function: NIRT_ModelError
+ *
+ * Abstract:
+ *	Check for any simulation errors. 
+ * 
+ * Input/Output Parameters:
+ *	msglen	: (in) length of input string (out) length of output string 
+ * 
+ * Output Parameters: 
+ *	errmsg	: string containing error message (if any occurred). 
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_ModelError(char* Errmsg, int32_t* msglen)
+{
+	int32_t retVal = NI_OK;
+	const char *simStoppedMsg = "The model simulation was stopped, but no reason was specified. This may be expected behavior.";
+	
+	if (NIRT_system.errmsg != NULL)
+	{
+		/* Set error condition */
+		retVal = NI_ERROR;
+		
+		if (*msglen > 0) 
+		{
+			if (*msglen > (int32_t)strlen(NIRT_system.errmsg)) 
+			{
+				/* Get error message */
+				*msglen = strlen(NIRT_system.errmsg);
+			}
+			
+			/* Return error message */
+			strncpy(Errmsg, NIRT_system.errmsg, *msglen);
+		}
+	}
+	else if(NIRT_system.stopExecutionFlag == 1)
+	{
+		/* No error */
+		retVal = NI_OK; 
+		
+		/* Execution stopped, but without a message. Return generic message. */
+		if (*msglen > 0) 
+		{
+			if (*msglen > (int32_t)strlen(simStoppedMsg)) 
+			{
+				/* Get error message */
+				*msglen = strlen(simStoppedMsg);
+			}
+			
+			/* Return error message */
+			strncpy(Errmsg, simStoppedMsg, *msglen);
+		}
+	}
+	else
+	{
+		/* No error */
+		retVal = NI_OK; 
+		*msglen = 0;
+	}
+	
+	return retVal;	
+}
+
+#if defined (NI_SHM_PUBLISH) && defined (kNIOSLinux)
+ /*========================================================================*
+ * Function: NI_ShmOwnerAlive
+ *
+ * Abstract:
+ *	Checks if the existing segment NI_SHM_NAME belongs to a running process, another
+ *	instance of the model still publishing to it.
+ *
+ * Returns:
+ *	1 if its owner is running, 0 if the segment was left behind or is not valid
+========================================================================*/
+static int32_t NI_ShmOwnerAlive(void)
+{
+	NI_ShmHeader header;
+	int32_t alive = 0;
+	int fd = shm_open(NI_SHM_NAME, O_RDONLY, 0);
+	
+	if (fd < 0)
+	{
+		return 0;
+	}
+	
+	if ((read(fd, &header, sizeof(header)) == (ssize_t)sizeof(header)) && (memcmp(header.magic, NI_SHM_MAGIC, 4) == 0) &&
+		(header.version == NI_SHM_VERSION) && (header.owner > 0))
+	{
+		alive = (kill((pid_t)header.owner, 0) == 0) || (errno == EPERM);
+	}
+	
+	close(fd);
+	return alive;
+}
+
+ /*========================================================================*
+ * Function: NI_ShmCreate
+ *
+ * Abstract:
+ *	Creates the shared-memory segment NI_SHM_NAME and writes its header and 
+ *	directory. A segment of a running process is left alone, one left behind by a
+ *	process that died is replaced. Failures are reported as warnings; the model 
+ *	runs unpublished.
+========================================================================*/
+static void NI_ShmCreate(void)
+{
+	NI_ShmHeader header;
+	NI_ShmSignal *entries;
+	char *names;
+	uint32_t nameSize = 0, outportOffset;
+	int32_t i, fd;
+	void *segment;
+	
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, NI_SHM_MAGIC, 4);
+	header.version = NI_SHM_VERSION;
+	header.owner = (int32_t)getpid();
+	header.count = (uint32_t)(SignalSize + OutportSize);
+	header.directoryOffset = NI_CACHE_LINE_SIZE;
+	for (i = 0; i < SignalSize; i++)
+	{
+		nameSize += NI_StringLength(rtSignalAttribs[i].blockname) + 1;
+	}
+	for (i = 0; i < OutportSize; i++)
+	{
+		nameSize += (uint32_t)strlen(rtIOAttribs[InportSize + i].name) + 1;
+	}
+	
+	header.dataOffset = header.directoryOffset + header.count * sizeof(NI_ShmSignal) + nameSize;
+	header.dataOffset = (header.dataOffset + NI_CACHE_LINE_SIZE - 1) & ~(uint32_t)(NI_CACHE_LINE_SIZE - 1);
+	outportOffset = ((uint32_t)NI_PUBLISHED_SIZE + 7) & ~(uint32_t)7;
+	header.dataSize = outportOffset + (uint32_t)OutportSize * sizeof(double);
+	header.segmentSize = header.dataOffset + header.dataSize;
+	
+	fd = shm_open(NI_SHM_NAME, O_CREAT | O_EXCL | O_RDWR, 0644);
+	if ((fd < 0) && (errno == EEXIST))
+	{
+		if (NI_ShmOwnerAlive())
+		{
+			SetErrorMessage("The shared memory segment " NI_SHM_NAME " is used by another running model.", 0);
+			return;
+		}
+		
+		shm_unlink(NI_SHM_NAME);
+		fd = shm_open(NI_SHM_NAME, O_CREAT | O_EXCL | O_RDWR, 0644);
+	}
+	
+	if (fd < 0)
+	{
+		SetErrorMessage("Cannot create the shared memory segment " NI_SHM_NAME ".", 0);
+		return;
+	}
+	
+	segment = (ftruncate(fd, header.segmentSize) == 0) ? mmap(NULL, header.segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+	close(fd);
+	if (segment == MAP_FAILED)
+	{
+		shm_unlink(NI_SHM_NAME);
+		SetErrorMessage("Cannot map the shared memory segment " NI_SHM_NAME ".", 0);
+		return;
+	}
+	
+	/* Touches every page, nothing faults in on the first publish */
+	memset(segment, 0, header.segmentSize);
+	memcpy(segment, &header, sizeof(header));
+	NI_Shm.header = (NI_ShmHeader *)segment;
+	NI_Shm.data = (unsigned char *)segment + header.dataOffset;
+	NI_Shm.outports = (double *)(NI_Shm.data + outportOffset);
+	
+	entries = (NI_ShmSignal *)((unsigned char *)segment + header.directoryOffset);
+	names = (char *)(entries + header.count);
+	for (i = 0; i < SignalSize + OutportSize; i++)
+	{
+		entries[i].nameOffset = (uint32_t)(names - (char *)segment);
+		if (i < SignalSize)
+		{
+			entries[i].offset = (uint32_t)(rtSignalAttribs[i].addr - NI_PUBLISHED_BEGIN);
+			entries[i].datatype = rtSignalAttribs[i].datatype;
+			entries[i].width = rtSignalAttribs[i].width;
+			entries[i].size = USER_DataTypeSize(rtSignalAttribs[i].datatype);
+			names += NI_CopyString(rtSignalAttribs[i].blockname, names, NI_StringLength(rtSignalAttribs[i].blockname));
+		}
+		else
+		{
+			entries[i].offset = outportOffset + (uint32_t)(i - SignalSize) * sizeof(double);
+			entries[i].datatype = 0;
+			entries[i].width = 1;
+			entries[i].size = (int32_t)sizeof(double);
+			strcpy(names, rtIOAttribs[InportSize + i - SignalSize].name);
+			names += strlen(names);
+		}
+		*names++ = '\0';
+	}
+}
+
+ /*========================================================================*
+ * Function: NI_ShmPublish
+ *
+ * Abstract:
+ *	Writes the IO and signals of the step to the shared-memory segment. The writer
+ *	never waits: readers retry when the sequence changed while they read.
+========================================================================*/
+static void NI_ShmPublish(void)
+{
+	NI_ShmHeader *header = NI_Shm.header;
+	
+	if (header == NULL)
+	{
+		return;
+	}
+	
+	NI_AtomicStore32(&header->sequence, header->sequence + 1);
+	NI_MemoryFence();
+	header->tick = NIRT_system.tick;
+	header->timestamp = NIRT_system.timestamp;
+	memcpy(NI_Shm.data, (unsigned char *)&rtModel + NI_PUBLISHED_BEGIN, NI_PUBLISHED_SIZE);
+	USER_PublishOutputs(NI_Shm.outports);
+	NI_AtomicStore32(&header->sequence, header->sequence + 1);
+}
+
+ /*========================================================================*
+ * Function: NI_ShmDestroy
+ *
+ * Abstract:
+ *	Unmaps and removes the shared-memory segment. Readers keep their mapping.
+========================================================================*/
+static void NI_ShmDestroy(void)
+{
+	if (NI_Shm.header != NULL)
+	{
+		munmap(NI_Shm.header, NI_Shm.header->segmentSize);
+		shm_unlink(NI_SHM_NAME);
+		NI_Shm.header = NULL;
+	}
+}
+
+#endif
+ /*========================================================================*
+ * Function: NIRT_InitializeModel
+ *
+ * Abstract:
+ *	Initializes internal structures and prepares model for execution. 
+ * 
+ * Input Parameters:
+ *	finaltime	: the final time until which the model should run.
+ * 
+ * Output Parameters:
+ *	outTimeStep	: the base time step of the model scheduler.
+ *	num_in		: number of external inputs
+ *	num_out		: number of external outputs
+ *	num_tasks	: number of Tasks (for multirate models only). 
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_InitializeModel(double finaltime, double *outTimeStep, int32_t *num_in, int32_t *num_out, int32_t* num_tasks) 
+{		
+#if defined (NI_PARAM_QUEUE_SIZE) || defined (NI_CHANGE_STREAMS) || defined (NI_STEADY_STATE)
+	int32_t i;
+	
+#endif
+	NIRT_system.SetParamTxStatus = NI_OK;
+	/* a model server initializes the model again for every client, without the errors of the last one */
+	NIRT_system.stopExecutionFlag = 0;
+	NIRT_system.errmsg = NULL;
+	NIRT_system.tick = 0;
+	NIRT_system.timestamp = 0.0;
+	memset(&NI_SteadyStateInfo, 0, sizeof(NI_SteadyStateInfo));
+#ifdef NI_STEADY_STATE
+	/* no anchor yet, the first computed step sets them */
+	for (i = 0; i < SteadyStateSize; i++)
+	{
+		rtSteadyStates[i].anchor = NAN;
+	}
+#endif
+	memset(&NI_MemoInfo, 0, sizeof(NI_MemoInfo));
+	memset(&NI_DeadlineInfo, 0, sizeof(NI_DeadlineInfo));
+	memset(&NI_Published, 0, sizeof(NI_Published));
+	NI_Published.front = -1;
+#ifdef NI_PARAM_QUEUE_SIZE
+	memset(&NI_ParamQueue, 0, sizeof(NI_ParamQueue));
+	for (i = 0; i < NI_PARAM_QUEUE_SIZE; i++)
+	{
+		NI_ParamQueue.slots[i].sequence = i;
+		NI_ParamQueue.pending[i].next = (i + 1 < NI_PARAM_QUEUE_SIZE) ? i + 1 : -1;
+	}
+	for (i = 0; i < NI_PARAM_WHEEL_SIZE; i++)
+	{
+		NI_ParamQueue.first[i] = -1;
+		NI_ParamQueue.last[i] = -1;
+	}
+#endif
+	memset(NI_ProbeList, 0, sizeof(NI_ProbeList));
+	memset(NI_Subscribed, 0, sizeof(NI_Subscribed));
+#ifdef NI_CHANGE_STREAMS
+	memset(NI_ChangeStreams, 0, sizeof(NI_ChangeStreams));
+	for (i = 0; i < NI_CHANGE_STREAMS; i++)
+	{
+		NI_ChangeStreams[i].resync = 1;
+	}
+	memcpy(NI_Deadbands, rtSignalDeadbands, sizeof(NI_Deadbands));
+	/* the kernel of the change detection is chosen before the first probe */
+	NI_FilterKernel();
+#endif
+	memset(rtModel.probed, 0, sizeof(rtModel.probed));
+	
+	/* Initialize parameter buffers */
+	memcpy(&rtParameter[0], &initParams, sizeof(Parameters));
+	memcpy(&rtParameter[1], &initParams, sizeof(Parameters));
+	/* whatever was derived from the parameters of the last run is stale */
+	NIRT_system.paramGeneration++;
+	
+	NIRT_system.flip = CreateSemaphore(NULL, 1, 1, NULL);
+	if (NIRT_system.flip == NULL)
+	{
+		SetErrorMessage("Failed to create semaphore.", 1);
+	}
+	
+	/* Return model specification */
+	NIRT_GetModelSpec(NULL, 0, outTimeStep, num_in, num_out, num_tasks);
+	
+#if defined (NI_SHM_PUBLISH) && defined (kNIOSLinux)
+	/* the segment directory comes from the constant signal table */
+	NI_ShmDestroy();
+	NI_ShmCreate();
+	if (NI_Shm.header != NULL)
+	{
+		/* the segment publishes every signal, so every signal is computed (see NI_UpdateProbed) */
+		memset(rtModel.probed, 0xFF, sizeof(rtModel.probed));
+	}
+#endif
+	
+	/* Call custom initialization */
+#ifdef NI_SEQUENCE_FRAME_SIZE
+	if (USER_Initialize() != NI_OK)
+	{
+		return NI_ERROR;
+	}
+	
+	/* the sequence starts over with the model */
+	return NI_StartSequence();
+#else
+	return USER_Initialize();
+#endif
+}
+
+ /*========================================================================*
+ * Function: NI_ProbeOneSignal
+ *
+ * Abstract:
+ *	Returns the value to a model's signal during it's execution.
+ *
+ * Parameters:
+ *	idx : the signal's index to probe
+ *	value : the buffer into where the signal's value is written
+ *	len  : the signal's length in the "value" parameter.
+ *	count : the number of elements to probe in a multidimensional signal
+ *	frame : published frame to read the value from, NULL for the live value
+ *
+ * Returns:
+ *	the total number of probed signal elements
+========================================================================*/
+int32_t NI_ProbeOneSignal(int32_t idx, double *value, int32_t len, int32_t *count, const unsigned char *frame)
+{
+	int32_t subindex = 0;
+  	int32_t sublength = 0;
+	uintptr_t addr;
+	
+	/*verify that index is within bounds*/
+  	if (idx > SignalSize) 
+	{
+		SetErrorMessage("Signal index is out of bounds.", 1);
+	    return NI_ERROR;
+    }
+	
+	sublength = rtSignalAttribs[idx].width;
+	addr = (frame != NULL) ? (uintptr_t)frame - NI_PUBLISHED_BEGIN : (uintptr_t)&rtModel;
+	addr += rtSignalAttribs[idx].addr;
+	
+  	while ((subindex < sublength) && (*count < len))
+	{
+		/* Convert the signal's internal datatype to double and return its value */
+    	value[(*count)++] = USER_GetValueByDataType((uintptr_t *)addr, subindex++, rtSignalAttribs[idx].datatype);
+	}
+	
+  	return *count;
+}
+
+ /*========================================================================*
+ * Function: NI_UpdateProbed
+ *
+ * Abstract:
+ *	Recomputes the watched signals. A change bumps the probe generation, so that a
+ *	model skipping its steps (steady-state, pure) computes a newly watched signal.
+ *	While the signals are published to shared memory, all of them are watched, the
+ *	segment would otherwise hold stale values of the signals gated by IS_PROBED.
+ *	Called by the thread running the model.
+========================================================================*/
+static void NI_UpdateProbed(void)
+{
+	uint32_t changed = 0, word;
+	int32_t i;
+	
+	for (i = 0; i < NI_PROBE_WORDS; i++)
+	{
+		word = NI_ProbeList[i] | NI_Subscribed[i];
+#if defined (NI_SHM_PUBLISH) && defined (kNIOSLinux)
+		if (NI_Shm.header != NULL)
+		{
+			word = ~0u;
+		}
+#endif
+		changed |= word ^ rtModel.probed[i];
+		rtModel.probed[i] = word;
+	}
+	
+	if (changed)
+	{
+		NIRT_system.probeGeneration++;
+	}
+}
+
+ /*========================================================================*
+ * Function: NI_RequestProbes
+ *
+ * Abstract:
+ *	Hands the probe list of a host thread over to the next NIRT_PostOutputs. Host
+ *	threads writing a list at the same time take turns.
+========================================================================*/
+static void NI_RequestProbes(const uint32_t* probed)
+{
+	int64_t sequence;
+	
+	/* Make the sequence odd, it is only ever made odd by one writer */
+	for (;;)
+	{
+		sequence = NI_AtomicLoad64(&NI_Published.requestSequence);
+		if (!(sequence & 1) && NI_AtomicCAS64(&NI_Published.requestSequence, sequence, sequence + 1))
+		{
+			break;
+		}
+		NI_CpuRelax();
+	}
+	
+	if (memcmp(NI_Published.request, probed, sizeof(NI_Published.request)) != 0)
+	{
+		memcpy(NI_Published.request, probed, sizeof(NI_Published.request));
+		sequence += 2;
+	}
+	
+	NI_AtomicStore64(&NI_Published.requestSequence, sequence);
+}
+
+ /*========================================================================*
+ * Function: NIRT_ProbeSignals
+ *
+ * Abstract:
+ *	returns the latest signal values: of the last step when called by the thread
+ *	running the model, of the published frame when called by another thread.
+ *
+ * Input Parameters: 
+ *	sigindices	: list of signal indices to be probed.
+ *	numsigs		: length of sigindices array.
+ * 	
+ *		NOTE: (Implementation detail) the sigindices array that is passed in is delimited by a value of -1. 
+ *		Thus the # of valid indices in the sigindices table is min(numsigs, index of value -1) - 1. 
+ *		Reason for subtracting 1, the first index in the array is used for bookkeeping and should be copied
+ *		into the 0th index in the signal values buffer. 
+ *		Also, the 1st index in the signal values buffer should contain the current timestamp. Hence valid 
+ *		signal data should be filled in starting from index 2. Any non-scalar signals should be added to the 
+ *		buffer in row-order. 
+ * 	  
+ * Input/Output Parameters
+ *	num			: (in) length of sigvalues buffer (out) number of values returned in the buffer
+ * 	  
+ * Output Parameters: 
+ *	value		: array of signal values
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_ProbeSignals(int32_t *sigindices, int32_t numsigs, double *value, int32_t* len)
+{
+	int32_t i = 0;
+	int32_t count = 0;
+	int32_t idx = 0;
+	uint32_t sequence = 0;
+	const unsigned char *frame = NULL;
+	uint32_t probed[NI_PROBE_WORDS + 1];
+	
+	/* Once the model publishes its outputs, probes of host threads read the published frame,
+	   the thread running the model reads the signals of its last step */
+	int32_t front = NI_AtomicLoad32(&NI_Published.front);
+	
+	if ((front < 0) && !NIRT_system.inCriticalSection)
+	{
+    	SetErrorMessage("SignalProbe should only be called between ScheduleTasks and PostOutputs", 1);
+	}
+	
+	if (NI_ModelThread == &NI_ThreadTag)
+	{
+		front = -1;
+	}
+	
+	do
+	{
+		if (front >= 0)
+		{
+			/* Read the front frame, retry if NIRT_PostOutputs rewrote it meanwhile */
+			front = NI_AtomicLoad32(&NI_Published.front);
+			sequence = NI_AtomicLoad32(&NI_Published.frame[front].sequence);
+			while (sequence & 1)
+			{
+				NI_CpuRelax();
+				front = NI_AtomicLoad32(&NI_Published.front);
+				sequence = NI_AtomicLoad32(&NI_Published.frame[front].sequence);
+			}
+			frame = NI_Published.frame[front].data;
+		}
+		
+		count = 0;
+		
+		/* Get the index to the first signal */
+	  	if ((*len > 1)  && (numsigs > 0)) 
+		{
+		    value[count++] = sigindices[0];
+		    value[count++] = 0;
+	  	}
+		
+		memset(probed, 0, sizeof(probed));
+		
+		/* Get the second and other signals */
+	  	for (i = 1; (i < numsigs) && (count < *len); i++)
+		{
+		    idx = sigindices[i];
+			
+		    if (idx < 0)
+			{
+	    	  	break;
+			}
+			
+	    	if (idx < SignalSize)
+			{
+	      		NI_ProbeOneSignal(idx, value, *len, &count, frame);
+				probed[idx >> 5] |= 1u << (idx & 31);
+			}
+	  	}
+		
+		if (frame != NULL)
+		{
+			NI_MemoryFence();
+		}
+	} while ((frame == NULL) ? 0 : (NI_AtomicLoad32(&NI_Published.frame[front].sequence) != sequence));
+	
+	/* The probed signals become the watched ones from the next step on. Probes of the front
+	   frame run concurrently with the step, NIRT_PostOutputs hands their list over. */
+	if (frame != NULL)
+	{
+		NI_RequestProbes(probed);
+	}
+	else if (memcmp(NI_ProbeList, probed, sizeof(NI_ProbeList)) != 0)
+	{
+		memcpy(NI_ProbeList, probed, sizeof(NI_ProbeList));
+		NI_UpdateProbed();
+	}
+
+  	*len = count;
+	return count;	
+}
+
+ /*========================================================================*
+ * Function: NIRT_ProbeSignalChanges
+ *
+ * Abstract:
+ *	Sends the signals of a list that moved more than their deadband since they were last
+ *	sent, as (index, value) pairs. Every NI_KEYFRAME_INTERVAL calls, on the first call, 
+ *	when the list changes or after NIRT_ResyncSignalChanges all signals of the list are
+ *	sent (a keyframe). Values are read like NIRT_ProbeSignals reads them; signals not 
+ *	watched otherwise should be subscribed (NIRT_SubscribeSignal). Of a non-scalar signal
+ *	only the first element is sent.
+ *
+ *	The deadbands of the list stay with the stream until the list or a deadband changes.
+ *	The double signals are compared where they are, in the published frame or the arena,
+ *	by the vector kernel of NI_DetectChanges; only the other signals are converted first.
+ *	Only the changed values are copied out.
+ *
+ * Input Parameters:
+ *	stream		: stream of the consumer, 0 to NI_CHANGE_STREAMS - 1. Each consumer (thread)
+ *				  uses its own stream.
+ *	sigindices	: indices of the signals, NULL for the subscribed signals
+ *	numsigs		: length of sigindices
+ *
+ * Input/Output Parameters:
+ *	num			: length of indices and values (in), number of pairs returned (out). Changes
+ *				  that do not fit are sent by the next call.
+ *
+ * Output Parameters:
+ *	indices		: signal indices of the pairs
+ *	values		: signal values of the pairs
+ *	keyframe	: 1 if the pairs are a keyframe, 0 if only changes
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if change-only probing is not enabled ("ChangeOnly"),
+ *	the stream or an index is out of bounds or a keyframe does not fit into num pairs
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_ProbeSignalChanges(int32_t stream, const int32_t* sigindices, int32_t numsigs, int32_t* indices, double* values, int32_t* num, int32_t* keyframe)
+{
+#ifdef NI_CHANGE_STREAMS
+	NI_ChangeStream* st;
+	const unsigned char *frame = NULL;
+	const double *src;
+	uintptr_t base;
+	uint32_t sequence = 0, generation;
+	ptrdiff_t offset, last = 0;
+	int32_t front, count = 0, sent, found, relist = 0, resync, idx, i, k, r, n;
+	
+	if ((stream < 0) || (stream >= NI_CHANGE_STREAMS) || (num == NULL) || (*num < 0) || (numsigs < 0) || (numsigs > SignalSize))
+	{
+		return NI_ERROR;
+	}
+	st = &NI_ChangeStreams[stream];
+	
+	/* The list of this call, a different list than the last call's starts over with a keyframe */
+	for (i = 0; i < ((sigindices != NULL) ? numsigs : SignalSize); i++)
+	{
+		idx = (sigindices != NULL) ? sigindices[i] : i;
+		if ((idx < 0) || (idx >= SignalSize))
+		{
+			st->resync = 1;
+			return NI_ERROR;
+		}
+		
+		if ((sigindices != NULL) || ((NI_Subscribed[idx >> 5] >> (idx & 31)) & 1u))
+		{
+			relist |= (count >= st->count) || (st->list[count] != idx);
+			st->list[count++] = idx;
+		}
+	}
+	relist |= (count != st->count);
+	st->count = count;
+	resync = st->resync || (++st->calls >= NI_KEYFRAME_INTERVAL) || relist;
+	
+	if (resync && (*num < count))
+	{
+		/* the list is already stored, the next call must still start with a keyframe */
+		st->resync = 1;
+		SetErrorMessage("The buffer is too small for a keyframe of the signal changes.", 0);
+		return NI_ERROR;
+	}
+	
+	if (relist)
+	{
+		/* A run continues while the signals are doubles following each other in the arena, or are not doubles (0: rtDBL) */
+		st->runs = 0;
+		for (k = 0; k < count; k++)
+		{
+			offset = (rtSignalAttribs[st->list[k]].datatype == 0) ? (ptrdiff_t)rtSignalAttribs[st->list[k]].addr : -1;
+			if ((k == 0) || ((offset < 0) != (last < 0)) || ((offset >= 0) && (offset != last + (ptrdiff_t)sizeof(double))))
+			{
+				st->run[st->runs] = k;
+				st->source[st->runs++] = offset;
+			}
+			last = offset;
+		}
+		st->run[st->runs] = count;
+	}
+	generation = NI_DeadbandGeneration;
+	if (relist || (st->bandGeneration != generation))
+	{
+		for (k = 0; k < count; k++)
+		{
+			st->band[k] = NI_Deadbands[st->list[k]];
+		}
+		st->bandGeneration = generation;
+	}
+	
+	/* Detect the changes and copy them out, from the published frame once there is one unless called by the thread running the model */
+	front = (NI_ModelThread == &NI_ThreadTag) ? -1 : NI_AtomicLoad32(&NI_Published.front);
+	do
+	{
+		if (front >= 0)
+		{
+			front = NI_AtomicLoad32(&NI_Published.front);
+			sequence = NI_AtomicLoad32(&NI_Published.frame[front].sequence);
+			while (sequence & 1)
+			{
+				NI_CpuRelax();
+				front = NI_AtomicLoad32(&NI_Published.front);
+				sequence = NI_AtomicLoad32(&NI_Published.frame[front].sequence);
+			}
+			frame = NI_Published.frame[front].data;
+		}
+		base = (frame != NULL) ? (uintptr_t)frame - NI_PUBLISHED_BEGIN : (uintptr_t)&rtModel;
+		
+		sent = 0;
+		for (r = 0; r < st->runs; r++)
+		{
+			k = st->run[r];
+			n = st->run[r + 1] - k;
+			if (st->source[r] < 0)
+			{
+				for (i = k; i < k + n; i++)
+				{
+					idx = i;
+					NI_ProbeOneSignal(st->list[i], st->current, i + 1, &idx, frame);
+				}
+				src = st->current + k;
+			}
+			else
+			{
+				src = (const double *)(base + (uintptr_t)st->source[r]);
+			}
+			
+			/* Moved more than the deadband, or between NaN and a number; the changes that fit are copied while the frame is valid */
+			found = NI_DetectChanges(n, src, st->sent + k, st->band + k, st->changed + k);
+			for (i = 0; (found || resync) && (i < n) && (sent < *num); i++)
+			{
+				if (st->changed[k + i] || resync)
+				{
+					indices[sent] = st->list[k + i];
+					values[sent++] = src[i];
+				}
+			}
+		}
+		
+		if (frame != NULL)
+		{
+			NI_MemoryFence();
+		}
+	} while ((frame == NULL) ? 0 : (NI_AtomicLoad32(&NI_Published.frame[front].sequence) != sequence));
+	
+	/* The values sent, in the order they were copied */
+	for (k = 0, i = 0; i < sent; k++)
+	{
+		if (st->changed[k] || resync)
+		{
+			st->sent[k] = values[i++];
+		}
+	}
+	
+	if (resync)
+	{
+		st->resync = 0;
+		st->calls = 0;
+	}
+	if (keyframe != NULL)
+	{
+		*keyframe = resync;
+	}
+	*num = sent;
+	return NI_OK;
+#else
+	UNUSED_PARAMETER(stream);
+	UNUSED_PARAMETER(sigindices);
+	UNUSED_PARAMETER(numsigs);
+	UNUSED_PARAMETER(indices);
+	UNUSED_PARAMETER(values);
+	UNUSED_PARAMETER(keyframe);
+	
+	if (num != NULL)
+	{
+		*num = 0;
+	}
+	return NI_ERROR;
+#endif
+}
+
+ /*========================================================================*
+ * Function: NIRT_ResyncSignalChanges
+ *
+ * Abstract:
+ *	Makes the next NIRT_ProbeSignalChanges call of a stream send a keyframe, e.g. after
+ *	the consumer lost pairs.
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the stream is out of bounds
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_ResyncSignalChanges(int32_t stream)
+{
+#ifdef NI_CHANGE_STREAMS
+	if ((stream < 0) || (stream >= NI_CHANGE_STREAMS))
+	{
+		return NI_ERROR;
+	}
+	
+	NI_ChangeStreams[stream].resync = 1;
+	return NI_OK;
+#else
+	UNUSED_PARAMETER(stream);
+	return NI_ERROR;
+#endif
+}
+
+ /*========================================================================*
+ * Function: NIRT_SetSignalDeadband
+ *
+ * Abstract:
+ *	Sets the deadband of a signal for NIRT_ProbeSignalChanges, overriding the "deadband"
+ *	of the model definition. 0 sends every change, a negative deadband every value.
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the index is out of bounds
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_SetSignalDeadband(int32_t index, double deadband)
+{
+#ifdef NI_CHANGE_STREAMS
+	int32_t i;
+	
+	if ((index < -1) || (index >= SignalSize))
+	{
+		return NI_ERROR;
+	}
+	
+	for (i = (index < 0 ? 0 : index); i < (index < 0 ? SignalSize : index + 1); i++)
+	{
+		NI_Deadbands[i] = deadband;
+	}
+	/* the streams refresh their deadbands at their next call */
+	NI_DeadbandGeneration++;
+	return NI_OK;
+#else
+	UNUSED_PARAMETER(index);
+	UNUSED_PARAMETER(deadband);
+	return NI_ERROR;
+#endif
+}
+
+ /*========================================================================*
+ * Function: NIRT_PostOutputs
+ *
+ * Abstract:
+ *	Publishes the outports and signals of the step into the back frame, makes it the
+ *	front frame and pushes the outport data out.
+ *
+ * Output Parameters:
+ *	outData	: preallocated array of model outputs
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_PostOutputs(double *outData)
+{
+	int32_t back = (NI_Published.front == 0) ? 1 : 0;
+	NI_PublishedFrame *frame = &NI_Published.frame[back];
+	uint32_t request[NI_PROBE_WORDS + 1];
+	int64_t sequence;
+	
+	NI_AtomicStore32(&frame->sequence, frame->sequence + 1);
+	NI_MemoryFence();
+	frame->timestamp = NIRT_system.timestamp;
+	memcpy(frame->data, (unsigned char *)&rtModel + NI_PUBLISHED_BEGIN, NI_PUBLISHED_SIZE);
+	NI_AtomicStore32(&frame->sequence, frame->sequence + 1);
+	NI_AtomicStore32(&NI_Published.front, back);
+	
+	/* Take over a new probe list of the host threads unless one is being written */
+	sequence = NI_AtomicLoad64(&NI_Published.requestSequence);
+	if (!(sequence & 1) && (sequence != NI_Published.requestTaken))
+	{
+		memcpy(request, NI_Published.request, sizeof(request));
+		NI_MemoryFence();
+		if (NI_AtomicLoad64(&NI_Published.requestSequence) == sequence)
+		{
+			NI_Published.requestTaken = sequence;
+			memcpy(NI_ProbeList, request, sizeof(NI_ProbeList));
+			NI_UpdateProbed();
+		}
+	}
+	
+	return USER_PublishOutputs(outData);
+}
+
+ /*========================================================================*
+ * Function: NIRT_SubscribeSignal
+ *
+ * Abstract:
+ *	Keeps a signal watched (see IS_PROBED) regardless of the NIRT_ProbeSignals lists, 
+ *	e.g. for logging. Call it after NIRT_InitializeModel, from the thread running the
+ *	model or while it is stopped.
+ *
+ * Input Parameters: 
+ *	index		: index of the signal, -1 for all signals
+ *	subscribe	: 1 to subscribe, 0 to unsubscribe
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the index is out of bounds
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_SubscribeSignal(int32_t index, int32_t subscribe)
+{
+	int32_t i;
+	
+	if (index < -1 || index >= SignalSize)
+	{
+		SetErrorMessage("Signal index is out of bounds.", 0);
+		return NI_ERROR;
+	}
+	
+	for (i = (index < 0 ? 0 : index); i < (index < 0 ? SignalSize : index + 1); i++)
+	{
+		if (subscribe)
+		{
+			NI_Subscribed[i >> 5] |= 1u << (i & 31);
+		}
+		else
+		{
+			NI_Subscribed[i >> 5] &= ~(1u << (i & 31));
+		}
+	}
+	
+	NI_UpdateProbed();
+	return NI_OK;
+}
+
+ /*========================================================================*
+ * Function: NIRT_GetSignalSpec
+ *
+ * Abstract:
+ *	If index == -1, lookup parameter by the ID.
+ *	If ID_len == 0 or if ID == null, return number of parameters in model.
+ *	Otherwise, lookup parameter by index, and return the information. 
+ *
+ * Input/Output Parameters:
+ *	index		: index of the signal (in/out) 
+ *	ID			: ID of signal to be looked up (in), ID of signal at index (out)
+ *	ID_len		: length of input ID(in), length of ID (out)
+ *	bnlen		: length of buffer blkname (in), length of output blkname (out)
+ *	snlen		: length of buffer signame (in), length of output signame (out)
+ *
+ * Output Parameters:  
+ *	blkname		: Name of the source block for the signal
+ *	portnum		: port number of the block that is the source of the signal (0 indexed)
+ *	signame		: Name of the signal
+ *	datatype	: same as with parameters. Currently assuming all data to be double. 
+ *	dims		: The port's dimension of length 'numdims'. 
+ *	numdims		: the port's number of dimensions. If a value of "-1" is specified, the minimum buffer size of "dims" is returned as its value. 
+ *		
+ * Returns:
+ *	NI_OK if no error(if sigidx == -1, number of signals)
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_GetSignalSpec(int32_t* sidx, char* ID, int32_t* ID_len, char* blkname, int32_t* bnlen, int32_t *portnum, char* signame, int32_t* snlen, int32_t *dattype, int32_t* dims, int32_t* numdim)
+{
+	  int32_t sigidx = *sidx;
+	  int32_t i = 0;
+	  char *addr = NULL;
+	  char *IDblk = 0;
+	  int32_t IDport = 0;
+	  
+	if (sigidx < 0) 
+	{
+		/* check if ID has been specified. */
+		if ((ID != NULL) && (ID_len != NULL) &&  (*ID_len > 0)) 
+		{
+			/* parse ID into blkname and port */
+			addr = strrchr(ID, ':');
+			if (addr == NULL)
+			{
+				return SignalSize;
+			}
+			
+			/* Calculate the char offset into the string after the port */
+			i = addr - ID;
+	  
+			/* malformed ID */
+			if (i <= 0)
+			{
+				return SignalSize;
+			}
+
+			ID[i] = 0;
+			IDblk = ID;
+			IDport = atoi(ID+i+1);
+
+			/* lookup the table for matching ID */
+			for (i = 0; i < SignalSize; i++) 
+			{
+				if (NI_StringEquals(rtSignalAttribs[i].blockname, IDblk) && IDport==(rtSignalAttribs[i]. portno+1))
+				{
+					break;
+				}
+			}
+
+			if (i < SignalSize)
+			{
+				sigidx = *sidx = i;
+			}
+			else
+			{
+				return SignalSize;
+			}
+		} 
+		else 
+		{		
+			/* no index or ID specified. */
+			return SignalSize;
+		}
+	}
+
+	if ( (sigidx >= 0) && (sigidx < SignalSize) ) 
+	{
+		if (ID != NULL) 
+		{
+			/* no need for return string to be null terminated! */
+			/* 10 to accomodate ':', port number and null character */
+			uint32_t len = NI_StringLength(rtSignalAttribs[sigidx].blockname);
+			char *tempID = (char *)calloc(len + 10, sizeof(char));
+			NI_CopyString(rtSignalAttribs[sigidx].blockname, tempID, len);
+			sprintf(tempID + len,":%d",rtSignalAttribs[sigidx]. portno+1);
+		
+				if ((int32_t)strlen(tempID) < *ID_len)
+				{
+					*ID_len = strlen(tempID);
+				}
+
+				strncpy(ID, tempID, *ID_len);
+				free(tempID);
+			}
+
+		if (blkname != NULL) 
+		{
+			/* no need for return string to be null terminated! */
+				if ((int32_t)NI_StringLength(rtSignalAttribs[sigidx].blockname) < *bnlen)
+				{
+					*bnlen = NI_StringLength(rtSignalAttribs[sigidx].blockname);
+				}
+			
+				NI_CopyString(rtSignalAttribs[sigidx].blockname, blkname, *bnlen);
+			}
+
+		if (signame != NULL) 
+			{
+				/* no need for return string to be null terminated! */
+				if ((int32_t)NI_StringLength(rtSignalAttribs[sigidx].signalname)<*snlen)
+				{
+					*snlen = NI_StringLength(rtSignalAttribs[sigidx].signalname);
+				}
+				
+				NI_CopyString(rtSignalAttribs[sigidx].signalname, signame, *snlen);
+			}
+
+		if (portnum != NULL) 
+		{
+			*portnum = rtSignalAttribs[sigidx].portno;
+		}
+		
+		if (dattype != NULL) 
+		{
+			*dattype = rtSignalAttribs[sigidx].datatype;
+		}
+				
+		if (numdim != NULL)
+		{
+			if (*numdim == -1)
+			{
+				*numdim = rtSignalAttribs[sigidx].numofdims;
+			}
+			else if (dims != NULL) 
+			{
+				for (i = 0; i < *numdim; i++)
+				{
+					dims[i] = SigDimList[rtSignalAttribs[sigidx].dimListOffset + i];
+				}
+			}
+		}
+
+		return NI_OK;
+	}
+
+	return SignalSize;	
+}
+
+ /*========================================================================*
+ * Function: NIRT_GetParameterIndices
+ *
+ * Abstract:
+ *	Returns an array of indices to tunable parameters
+ *
+ * Output Parameters:
+ *	indices	: buffer to store the parameter indices of length "len"
+ *	len		: returns the number of indices. If a value of "-1" is specified, the minimum buffer size of "indices" is returned as its value. 
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_GetParameterIndices(int32_t* indices, int32_t* len)
+{
+  	int32_t i;
+	
+	if((len == NULL) || (indices == NULL))
+	{
+		return NI_ERROR;
+	}
+	
+	if (*len == -1)
+	{
+		*len = ParameterSize;
+	}
+	else
+	{
+		for (i = 0; i < ParameterSize && i < *len; i++)
+		{
+			indices[i] = i;
+		}
+		
+		*len = i;
+	}
+
+  	return NI_OK;	
+}
+
+ /*========================================================================*
+ * Function: NIRT_GetParameterSpec
+ *
+ * Abstract:
+ *	If index == -1, lookup parameter by the ID.
+ *	If ID_len == 0 or if ID == null, return number of parameters in model.
+ *	Otherwise, lookup parameter by index, and return the information. 
+ *
+ * Input/Output Parameters:
+ *	paramidx	: index of the parameter(in/out). If a value of "-1" is specified, the parameter's ID is used instead
+ *	ID			: ID of parameter to be looked up (in), ID of parameter at index (out)
+ *	ID_len		: length of input ID (in), length of ID (out)
+ *	pnlen		: length of buffer paramname(in), length of the returned paramname (out)
+ *	numdim		: length of buffer dimension(in), length of output dimension (out). If a value of "-1" is specified, the minimum buffer size of "dims" is returned as its value
+ *
+ * Output Parameters: 
+ *	paramname	: Name of the parameter
+ *	datatype	: datatype of the parameter (currently assuming 0: double, .. )
+ *	dims		: array of dimensions with length 'numdim'
+ *		
+ * Returns:
+ *	NI_OK if no error (if paramidx == -1, number of tunable parameters)
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_GetParameterSpec(int32_t* pidx, char* ID, int32_t* ID_len, char* paramname, int32_t *pnlen, int32_t *dattype, int32_t* dims, int32_t* numdim)
+{
+	int32_t i= 0;
+	int32_t paramidx = *pidx;
+
+	if (paramidx < 0) 
+	{
+		/* check if ID has been specified. */
+		if ( (ID != NULL) && (ID_len != NULL) && (*ID_len > 0) ) 
+		{
+			/* lookup the table for matching ID */
+			for (i = 0; i < ParameterSize; i++) 
+			{
+				if (NI_StringEquals(rtParamAttribs[i].paramname, ID))
+				{
+					/* found matching string */
+					break;
+				}
+			}
+
+			if (i < ParameterSize)
+			{
+				/* note the index into the rtParamAttribs */
+				paramidx = *pidx = i;
+			}
+			else
+			{
+				return ParameterSize;
+			}
+		} 
+		else
+		{
+			/* no index or ID specified. */
+			return ParameterSize;
+		}
+	}
+	
+	if ( (paramidx >= 0) && (paramidx < ParameterSize) ) 
+	{
+		if(ID != NULL) 
+		{
+			if ((int32_t)NI_StringLength(rtParamAttribs[paramidx].paramname) < *ID_len)
+			{
+				*ID_len = NI_StringLength(rtParamAttribs[paramidx].paramname);
+			}
+			NI_CopyString(rtParamAttribs[paramidx].paramname, ID, *ID_len);
+		}
+
+		if(paramname != NULL) 
+		{
+			/* no need for return string to be null terminated! */
+			if ((int32_t)NI_StringLength(rtParamAttribs[paramidx].paramname) < *pnlen)
+			{
+				*pnlen = NI_StringLength(rtParamAttribs[paramidx].paramname);
+			}
+			NI_CopyString(rtParamAttribs[paramidx].paramname, paramname, *pnlen);
+		}
+
+		if (dattype != NULL)
+		{
+			*dattype = rtParamAttribs[paramidx].datatype;
+		}
+		
+		if (numdim != NULL)
+		{
+			if (*numdim == -1)
+			{
+				*numdim = rtParamAttribs[paramidx].numofdims;
+			}
+			else if (dims != NULL)
+			{
+				for (i = 0; i < *numdim; i++)
+				{
+					dims[i] = ParamDimList[rtParamAttribs[paramidx].dimListOffset + i];
+				}
+			}
+		}
+
+		return NI_OK;
+	}
+
+	return ParameterSize;	
+}
+
+ /*========================================================================*
+ * Function: NIRT_GetParameter
+ *
+ * Abstract:
+ *	Get the current value of a parameter.
+ * 
+ * Input Parameters: 
+ *	index	: index of the parameter
+ *	subindex: element index into the flattened array if an array
+ * 
+ * Output Parameters:
+ *	val		: value of the parameter 
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_GetParameter(int32_t index, int32_t subindex, double* val)
+{
+  	char* ptr = NULL;
+	
+	/* Check index boundaries */
+  	if ( (index >= ParameterSize) || (index < 0) || (subindex >= rtParamAttribs[index].width) )
+	{
+	    return NI_ERROR;
+	}
+	
+	/* Get the parameter's address into the Parameter struct 
+	casting to char to perform pointer arithmetic using the byte offset */
+  	ptr = (char*)&rtParameter[READSIDE] + rtParamAttribs[index].addr;
+	
+	/* Convert the parameter's internal datatype to double and return its value */
+  	*val = USER_GetValueByDataType(ptr, subindex, rtParamAttribs[index].datatype);
+	
+  	return NI_OK;	
+}
+
+ /*========================================================================*
+ * Function: NIRT_GetVectorParameter
+ *
+ * Abstract:
+ *	Get the current value of a vector parameter.
+ * 
+ * Input Parameters: 
+ *	index: index of the parameter
+ *	paramLength: length of the parameter
+ * 
+ * Output Parameters:
+ *	paramValues: an array of the parameter's value
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_GetVectorParameter(uint32_t index, double* paramValues, uint32_t paramLength)
+{
+  	char* ptr = NULL;
+	uint32_t i = 0;
+	
+	/* Check index boundaries */
+  	if ( (index >= ParameterSize) || (index < 0) || (paramLength != rtParamAttribs[index].width) )
+	{
+	    return NI_ERROR;
+	}
+
+	/* Get the parameter's address into the Parameter struct 
+	casting to char to perform pointer arithmetic using the byte offset */
+  	ptr = (char*)&rtParameter[READSIDE] + rtParamAttribs[index].addr;
+	
+  	while(i < paramLength)
+	{
+		/* Convert the parameter's internal datatype to double and return its value */
+		paramValues[i] = USER_GetValueByDataType(ptr, i, rtParamAttribs[index].datatype);
+		i++;
+	}
+	
+  	return NI_OK;	
+}
+
+#ifdef NI_PARAM_QUEUE_SIZE
+ /*========================================================================*
+ * Function: NI_MergeQueuedParameters
+ *
+ * Abstract:
+ *	Copies the parameters changed by the parameter queue since the last commit from
+ *	the read side into the image about to be committed, so that the flip does not
+ *	undo them. A queued change wins over a value set for the same parameter since
+ *	the last commit. Must be called while holding the flip semaphore.
+========================================================================*/
+static void NI_MergeQueuedParameters(Parameters* image)
+{
+	int32_t i;
+	
+	for (i = 0; i < ParameterSize; i++)
+	{
+		if ((NI_ParamQueue.touched[i >> 5] >> (i & 31)) & 1u)
+		{
+			memcpy((char*)image + rtParamAttribs[i].addr, (char*)&rtParameter[READSIDE] + rtParamAttribs[i].addr, 
+				(size_t)Parameters_sizes[i + 1].size * (size_t)rtParamAttribs[i].width);
+		}
+	}
+	
+	memset(NI_ParamQueue.touched, 0, sizeof(NI_ParamQueue.touched));
+}
+#endif
+
+ /*========================================================================*
+ * Function: NIRT_SetParameter
+ *
+ * Abstract:
+ *	Set parameter value. Called either in scheduler loop or a background loop. 
+ * 	
+ * Input Parameters:
+ *	index	: index of the parameter (as specified in Parameter Information)
+ *	subindex: index in the flattened array, if parameter is n-D array
+ *	val		: Value to set the parameter to
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_SetParameter(int32_t index, int32_t subindex, double val)
+{
+  	char* ptr = NULL;
+	
+	/* Check bounds */
+  	if (index >= ParameterSize) 
+	{
+	  	NIRT_system.SetParamTxStatus = NI_ERROR;
+		SetErrorMessage("Parameter index is out of bounds.", 1);
+	    return NIRT_system.SetParamTxStatus;
+    }
+	
+	/* Commit parameter values */
+  	if (index < 0) 
+	{
+		/* Check if the read-side has since been modified. If it is, return an error and flush all changes to the write-side*/
+		if(ReadSideDirtyFlag == 1)
+		{
+			memcpy(&rtParameter[1-READSIDE], &rtParameter[READSIDE], sizeof(Parameters));
+			ReadSideDirtyFlag = 0;
+			
+			if(WriteSideDirtyFlag == 0)
+			{
+				/* No values to commit */
+				return NI_OK;
+			}
+			else
+			{
+				SetErrorMessage("Parameters have been set inline and from the background loop at the same time. Parameters written from the background loop since the last commit have been lost.",1);
+				WriteSideDirtyFlag = 0;
+				return NI_ERROR;
+			}
+		}
+
+		/* If an error occurred and we have values to commit, then save to the write side and return error */
+	    if (NIRT_system.SetParamTxStatus == NI_ERROR) 
+		{
+	 		if(WriteSideDirtyFlag == 1)
+			{
+				WaitForSingleObject(NIRT_system.flip, INFINITE);
+#ifdef NI_PARAM_QUEUE_SIZE
+				NI_MergeQueuedParameters(&rtParameter[1-READSIDE]);
+#endif
+				memcpy(&rtParameter[READSIDE], &rtParameter[1-READSIDE], sizeof(Parameters));
+				NIRT_system.paramGeneration++;
+				ReleaseSemaphore(NIRT_system.flip, 1, NULL);
+			}
+
+      		/* reset the status. */
+      		NIRT_system.SetParamTxStatus = NI_OK;
+			WriteSideDirtyFlag = 0;
+			
+      		return NI_ERROR;
+	    }
+		
+		/* If we have values to commit, then save to the write-side */
+		if(WriteSideDirtyFlag == 1)
+		{
+			/* commit changes */
+			WaitForSingleObject(NIRT_system.flip, INFINITE);
+#ifdef NI_PARAM_QUEUE_SIZE
+			NI_MergeQueuedParameters(&rtParameter[1-READSIDE]);
+#endif
+			READSIDE = 1 - READSIDE;
+			NIRT_system.paramGeneration++;
+			ReleaseSemaphore(NIRT_system.flip, 1, NULL);
+
+			/* Copy back the newly set parameters to the write-side. */
+			memcpy(&rtParameter[1-READSIDE], &rtParameter[READSIDE], sizeof(Parameters));
+			WriteSideDirtyFlag = 0;
+		}
+		
+    	return NI_OK;
+  	}
+	else
+	{
+		/* Update a parameter value in the pending buffer */
+
+		/* verify that sub-index is within bounds. */
+		if (subindex >= rtParamAttribs[index].width) 
+		{
+			NIRT_system.SetParamTxStatus = NI_ERROR;
+			SetErrorMessage("Parameter subindex is out of bounds.",1);
+			return NIRT_system.SetParamTxStatus;
+		}
+
+		/* If we have pending modified parameters, then copy to write-side */
+		if(ReadSideDirtyFlag == 1)
+		{
+			memcpy(&rtParameter[1-READSIDE], &rtParameter[READSIDE], sizeof(Parameters));
+			ReadSideDirtyFlag = 0;
+		}
+			
+		/* Get the parameter's address into the Parameter struct 
+		casting to char to perform pointer arithmetic using the byte offset */
+		ptr = (char*)&rtParameter[1-READSIDE] + rtParamAttribs[index].addr;
+		WriteSideDirtyFlag = 1;
+		
+		/* Convert the incoming double datatype to the parameter's internal datatype and update value */
+		return USER_SetValueByDataType(ptr, subindex, val, rtParamAttribs[index].datatype);
+	}
+}
+
+ /*========================================================================*
+ * Function: NIRT_SetScalarParameterInline
+ *
+ * Abstract:
+ *	Sets the value to a parameter immediately without the need of a commit request.
+ *
+ * Input Parameters:
+ *	index		: index of the parameter as returned by NIRT_GetParameterSpec()
+ *	subindex	: offset of the element within the parameter
+ *	paramvalue	: Value to set the parameter to
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_SetScalarParameterInline( uint32_t index,  uint32_t subindex,  double paramvalue)
+{
+  	char* ptr = NULL;
+	
+	/*verify that index is within bounds*/
+  	if (index >= ParameterSize) 
+	{
+	  	NIRT_system.SetParamTxStatus = NI_ERROR;
+		SetErrorMessage("Parameter index is out of bounds.",1);
+	    return NIRT_system.SetParamTxStatus;
+    }
+
+  	/* verify that parameter length is correct. */
+  	if (subindex >= rtParamAttribs[index].width) 
+	{
+	  	NIRT_system.SetParamTxStatus = NI_ERROR;
+		SetErrorMessage("Parameter subindex is out of bounds.",1);
+	    return NIRT_system.SetParamTxStatus;
+    }
+	
+	/* Get the parameter's address into the Parameter struct 
+	casting to char to perform pointer arithmetic using the byte offset */
+  	ptr = (char*)&rtParameter[READSIDE] + rtParamAttribs[index].addr;
+	ReadSideDirtyFlag = 1;
+	NIRT_system.paramGeneration++;
+	
+	/* Convert the incoming double datatype to the parameter's internal datatype and update value */
+	return USER_SetValueByDataType(ptr, subindex, paramvalue, rtParamAttribs[index].datatype);
+}
+
+ /*========================================================================*
+ * Function: NIRT_SetVectorParameter
+ *
+ * Abstract:
+ *	Sets the value to a parameter array.
+ * 	
+ * Input Parameters:
+ *	index		: index of the parameter as returned by NIRT_GetParameterSpec()
+ *	paramvalues	: array of values to set
+ *	paramlength	: Length of parameter values.
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_SetVectorParameter( uint32_t index, const double* paramvalues,  uint32_t paramlength)
+{
+  	char* ptr = NULL;
+	uint32_t i = 0;
+	int32_t retval = NI_OK;
+	
+	/*verify that index is within bounds*/
+  	if (index >= ParameterSize) 
+	{
+	  	NIRT_system.SetParamTxStatus = NI_ERROR;
+		SetErrorMessage("Parameter index is out of bounds.",1);
+	    return NIRT_system.SetParamTxStatus;
+    }
+
+  	/* verify that parameter length is correct. */
+  	if (paramlength != rtParamAttribs[index].width) 
+	{
+	  	NIRT_system.SetParamTxStatus = NI_ERROR;
+		SetErrorMessage("Parameter length is incorrect.",1);
+	    return NIRT_system.SetParamTxStatus;
+    }
+	
+	/* If we have pending modified parameters, then copy to write-side */
+	if(ReadSideDirtyFlag == 1)
+	{
+		memcpy(&rtParameter[1-READSIDE], &rtParameter[READSIDE], sizeof(Parameters));
+		ReadSideDirtyFlag = 0;
+	}
+	
+	/* Get the parameter's address into the Parameter struct 
+	casting to char to perform pointer arithmetic using the byte offset */
+  	ptr = (char*)&rtParameter[1-READSIDE] + rtParamAttribs[index].addr;
+	
+	while(i < paramlength)
+	{
+		/* Convert the incoming double datatype to the parameter's internal datatype and update value */
+		retval = retval & USER_SetValueByDataType(ptr, i, paramvalues[i], rtParamAttribs[index].datatype);
+		i++;
+	}
+	
+	WriteSideDirtyFlag = 1;
+	return retval;
+}
+
+ /*========================================================================*
+ * Function: NI_CommitParameterImage
+ *
+ * Abstract:
+ *	Copies an image of the Parameters struct into the write side and commits it 
+ *	with a single flip of the read side.
+ *
+ * Returns:
+ *	NI_OK if no error
+========================================================================*/
+static int32_t NI_CommitParameterImage(const void* image)
+{
+	/* The image replaces the parameters set inline on the read side too */
+	ReadSideDirtyFlag = 0;
+	
+	memcpy(&rtParameter[1-READSIDE], image, sizeof(Parameters));
+	
+	WaitForSingleObject(NIRT_system.flip, INFINITE);
+#ifdef NI_PARAM_QUEUE_SIZE
+	NI_MergeQueuedParameters(&rtParameter[1-READSIDE]);
+#endif
+	READSIDE = 1 - READSIDE;
+	NIRT_system.paramGeneration++;
+	ReleaseSemaphore(NIRT_system.flip, 1, NULL);
+	
+	/* Copy back the newly set parameters to the write-side. */
+	memcpy(&rtParameter[1-READSIDE], &rtParameter[READSIDE], sizeof(Parameters));
+	WriteSideDirtyFlag = 0;
+	
+	return NI_OK;
+}
+
+ /*========================================================================*
+ * Function: NIRT_SetParameterBatch
+ *
+ * Abstract:
+ *	Sets many parameter values and commits them at once, with a single flip of the 
+ *	read side. The whole batch is validated and converted into a staging copy of 
+ *	the write side first: if any entry is invalid, nothing is applied. Parameters
+ *	set with NIRT_SetParameter and not yet committed are committed with the batch.
+ *
+ * Input Parameters:
+ *	indices		: indices of the parameters as returned by NIRT_GetParameterSpec()
+ *	subindices	: offsets of the elements within the parameters, NULL for scalars
+ *	values		: values to set
+ *	count		: number of entries
+ *
+ * Output Parameters:
+ *	errors		: NI_OK or NI_ERROR per entry, may be NULL
+ *
+ * Returns:
+ *	NI_OK if the batch was committed, NI_ERROR otherwise
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_SetParameterBatch(const int32_t* indices, const int32_t* subindices, const double* values, int32_t count, int32_t* errors)
+{
+	int32_t i, index, subindex, status;
+	int32_t retval = NI_OK;
+	
+	if ((count < 0) || ((count > 0) && ((indices == NULL) || (values == NULL))))
+	{
+		SetErrorMessage("Invalid parameter batch.", 0);
+		return NI_ERROR;
+	}
+	
+	/* Parameters set inline since the last commit must not be lost */
+	if (ReadSideDirtyFlag == 1)
+	{
+		memcpy(&rtParameter[1-READSIDE], &rtParameter[READSIDE], sizeof(Parameters));
+		ReadSideDirtyFlag = 0;
+	}
+	
+	/* Validate and convert the whole batch into the staging copy */
+	memcpy(&NI_ParamStaging, &rtParameter[1-READSIDE], sizeof(Parameters));
+	
+	for (i = 0; i < count; i++)
+	{
+		index = indices[i];
+		subindex = (subindices != NULL) ? subindices[i] : 0;
+		
+		status = NI_ERROR;
+		
+		if ((index >= 0) && (index < ParameterSize) && (subindex >= 0) && (subindex < rtParamAttribs[index].width))
+		{
+			/* Convert the incoming double to the parameter's internal datatype, unknown datatypes are rejected */
+			status = USER_SetValueByDataType((char*)&NI_ParamStaging + rtParamAttribs[index].addr, subindex, values[i], rtParamAttribs[index].datatype);
+		}
+		
+		if (errors != NULL)
+		{
+			errors[i] = status;
+		}
+		
+		if (status != NI_OK)
+		{
+			retval = NI_ERROR;
+		}
+	}
+	
+	if (retval != NI_OK)
+	{
+		SetErrorMessage("Parameter batch rejected, invalid entries. No parameter has been changed.", 0);
+		return NI_ERROR;
+	}
+	
+	return NI_CommitParameterImage(&NI_ParamStaging);
+}
+
+ /*========================================================================*
+ * Function: NIRT_SetParameterImage
+ *
+ * Abstract:
+ *	Replaces all the parameters with a contiguous image of the Parameters struct 
+ *	(e.g. saved from NIRT_GetParameterImage) and commits it with a single flip of 
+ *	the read side.
+ *
+ * Input Parameters:
+ *	image	: image of the Parameters struct
+ *	size	: size of the image, must be the size of the Parameters struct
+ *
+ * Returns:
+ *	NI_OK if the image was committed, NI_ERROR otherwise
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_SetParameterImage(const void* image, uint32_t size)
+{
+	if ((image == NULL) || (size != sizeof(Parameters)))
+	{
+		SetErrorMessage("Parameter image size does not match the model.", 0);
+		return NI_ERROR;
+	}
+	
+	return NI_CommitParameterImage(image);
+}
+
+ /*========================================================================*
+ * Function: NIRT_GetParameterImage
+ *
+ * Abstract:
+ *	Copies the read side parameters, as a contiguous image of the Parameters struct.
+ *
+ * Input/Output Parameters:
+ *	size	: size of the image buffer (in), size of the Parameters struct (out). 
+ *			  If image is NULL, only the size is returned.
+ *
+ * Output Parameters:
+ *	image	: buffer receiving the image
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the buffer is too small
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_GetParameterImage(void* image, uint32_t* size)
+{
+	if (size == NULL)
+	{
+		return NI_ERROR;
+	}
+	
+	if (image == NULL)
+	{
+		*size = sizeof(Parameters);
+		return NI_OK;
+	}
+	
+	if (*size < sizeof(Parameters))
+	{
+		*size = sizeof(Parameters);
+		return NI_ERROR;
+	}
+	
+	memcpy(image, &rtParameter[READSIDE], sizeof(Parameters));
+	*size = sizeof(Parameters);
+	
+	return NI_OK;
+}
+
+ /*========================================================================*
+ * Function: NI_ParameterLayoutHash
+ *
+ * Abstract:
+ *	Hashes (FNV-1a) the layout of the Parameters struct: the size of the struct and the 
+ *	name, offset, datatype, element size and width of every parameter.
+ *
+ * Returns:
+ *	the layout hash
+========================================================================*/
+static uint32_t NI_ParameterLayoutHash(void)
+{
+	uint32_t hash = 2166136261u;
+	uint32_t fields[5];
+	const unsigned char* p;
+	int32_t i;
+	size_t j;
+	
+	for (i = -1; i < ParameterSize; i++)
+	{
+		fields[0] = (i < 0) ? (uint32_t)sizeof(Parameters) : (uint32_t)rtParamAttribs[i].addr;
+		fields[1] = (i < 0) ? (uint32_t)ParameterSize : (uint32_t)rtParamAttribs[i].datatype;
+		fields[2] = (i < 0) ? 0 : (uint32_t)rtParamAttribs[i].width;
+		fields[3] = (i < 0) ? 0 : (uint32_t)Parameters_sizes[i + 1].size;
+		fields[4] = 0;
+		
+		for (p = (const unsigned char*)fields, j = 0; j < sizeof(fields); j++)
+		{
+			hash = (hash ^ p[j]) * 16777619u;
+		}
+		
+		if (i >= 0)
+		{
+			hash = NI_HashString(hash, rtParamAttribs[i].paramname);
 		}
 	}
+	
+	return hash;
+}
 
-	if ( (sigidx >= 0) && (sigidx < SignalSize) ) 
+ /*========================================================================*
+ * Function: NI_MapFile
+ *
+ * Abstract:
+ *	Maps a file read-only into memory; reads it into an allocated buffer on targets
+ *	without mmap. Release it with NI_UnmapFile.
+ *
+ * Returns:
+ *	NI_OK if no error
+========================================================================*/
+static int32_t NI_MapFile(const char* path, void** data, size_t* size)
+{
+#ifdef kNIOSLinux
+	struct stat st;
+	int fd = open(path, O_RDONLY);
+	
+	if (fd < 0)
 	{
-		if (ID != NULL) 
-		{
-			/* no need for return string to be null terminated! */
-			/* 10 to accomodate ':', port number and null character */
-			char *tempID = (char *)calloc(strlen(rtSignalAttribs[sigidx].blockname) + 10, sizeof(char));
-			sprintf(tempID,"%s:%d",rtSignalAttribs[sigidx].blockname,rtSignalAttribs[sigidx]. portno+1);
-		
-				if ((int32_t)strlen(tempID) < *ID_len)
-				{
-					*ID_len = strlen(tempID);
-				}
+		return NI_ERROR;
+	}
+	
+	if ((fstat(fd, &st) != 0) || (st.st_size <= 0))
+	{
+		close(fd);
+		return NI_ERROR;
+	}
+	
+	*size = (size_t)st.st_size;
+	*data = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	
+	return (*data == MAP_FAILED) ? NI_ERROR : NI_OK;
+#else
+	FILE* fp = fopen(path, "rb");
+	long length;
+	
+	if (fp == NULL)
+	{
+		return NI_ERROR;
+	}
+	
+	fseek(fp, 0, SEEK_END);
+	length = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	
+	*data = (length > 0) ? malloc((size_t)length) : NULL;
+	*size = (size_t)length;
+	if ((*data == NULL) || (fread(*data, 1, *size, fp) != *size))
+	{
+		free(*data);
+		fclose(fp);
+		return NI_ERROR;
+	}
+	
+	fclose(fp);
+	return NI_OK;
+#endif
+}
 
-				strncpy(ID, tempID, *ID_len);
-				free(tempID);
-			}
+static void NI_UnmapFile(void* data, size_t size)
+{
+#ifdef kNIOSLinux
+	munmap(data, size);
+#else
+	UNUSED_PARAMETER(size);
+	free(data);
+#endif
+}
 
-		if (blkname != NULL) 
+ /*========================================================================*
+ * Function: NI_RemapParameterSet
+ *
+ * Abstract:
+ *	Copies the parameters of a parameter set file saved from another layout into the
+ *	staging copy of the write side, matching them by name. An entry is only read if
+ *	its element size is the size of its datatype in this model and its elements are
+ *	aligned, its extent in the image was checked by NIRT_LoadParameterSet.
+ *
+ * Returns:
+ *	the number of parameters of the file left out
+========================================================================*/
+static int32_t NI_RemapParameterSet(const char* file, const NI_ParamSetHeader* header, const NI_ParamSetEntry* entries)
+{
+	const char* image = file + header->imageOffset;
+	const char* name;
+	int32_t unmatched = 0;
+	int32_t e, i, k, j;
+	
+	for (e = 0; e < (int32_t)header->count; e++)
+	{
+		name = file + entries[e].nameOffset;
+		
+		if ((entries[e].size <= 0) || (entries[e].size != USER_DataTypeSize(entries[e].datatype)) ||
+			(entries[e].offset % (uint32_t)entries[e].size != 0))
 		{
-			/* no need for return string to be null terminated! */
-				if ((int32_t)strlen(rtSignalAttribs[sigidx].blockname) < *bnlen)
-				{
-					*bnlen = strlen(rtSignalAttribs[sigidx].blockname);
-				}
-			
-				strncpy(blkname, rtSignalAttribs[sigidx].blockname, *bnlen);
-			}
-
-		if (signame != NULL) 
+			unmatched++;
+			continue;
+		}
+		
+		/* Most parameters keep their position, look there first */
+		for (k = 0, i = -1; (k < ParameterSize) && (i < 0); k++)
+		{
+			j = (e + k) % ParameterSize;
+			if (NI_StringEquals(rtParamAttribs[j].paramname, name))
 			{
-				/* no need for return string to be null terminated! */
-				if ((int32_t)strlen(rtSignalAttribs[sigidx].signalname)<*snlen)
-				{
-					*snlen = strlen(rtSignalAttribs[sigidx].signalname);
-				}
-				
-				strncpy(signame, rtSignalAttribs[sigidx].signalname, *snlen);
+				i = j;
 			}
-
-		if (portnum != NULL) 
-		{
-			*portnum = rtSignalAttribs[sigidx].portno;
 		}
 		
-		if (dattype != NULL) 
+		if ((i < 0) || (rtParamAttribs[i].width != entries[e].width))
 		{
-			*dattype = rtSignalAttribs[sigidx].datatype;
+			unmatched++;
+			continue;
 		}
-				
-		if (numdim != NULL)
+		
+		for (j = 0; j < entries[e].width; j++)
 		{
-			if (*numdim == -1)
-			{
-				*numdim = rtSignalAttribs[sigidx].numofdims;
-			}
-			else if (dims != NULL) 
-			{
-				for (i = 0; i < *numdim; i++)
-				{
-					dims[i] = SigDimList[rtSignalAttribs[sigidx].dimListOffset + i];
-				}
-			}
+			/* Convert through double, the datatype may have changed */
+			USER_SetValueByDataType((char*)&NI_ParamStaging + rtParamAttribs[i].addr, j, 
+				USER_GetValueByDataType((void*)(image + entries[e].offset), j, entries[e].datatype), rtParamAttribs[i].datatype);
 		}
-
-		return NI_OK;
 	}
-
-	return SignalSize;	
+	
+	return unmatched;
 }
 
  /*========================================================================*
- * Function: NIRT_GetParameterIndices
+ * Function: NIRT_LoadParameterSet
  *
  * Abstract:
- *	Returns an array of indices to tunable parameters
+ *	Loads a parameter set file saved by NIRT_SaveParameterSet and commits it with a 
+ *	single flip of the read side. The file is memory-mapped where the target supports it.
+ *	If it was saved from the same parameter layout (same layout hash), its image is 
+ *	copied as a whole; otherwise its parameters are matched by name, and those missing
+ *	from the model, of a different width or with an element size not matching their
+ *	datatype are left out.
+ *
+ * Input Parameters:
+ *	path		: path of the file
  *
  * Output Parameters:
- *	indices	: buffer to store the parameter indices of length "len"
- *	len		: returns the number of indices. If a value of "-1" is specified, the minimum buffer size of "indices" is returned as its value. 
+ *	unmatched	: number of parameters of the file left out, may be NULL
  *
  * Returns:
- *	NI_OK if no error
+ *	NI_OK if the parameter set was committed, NI_ERROR otherwise
  *========================================================================*/
-DLL_EXPORT int32_t NIRT_GetParameterIndices(int32_t* indices, int32_t* len)
+DLL_EXPORT int32_t NIRT_LoadParameterSet(const char* path, int32_t* unmatched)
 {
-  	int32_t i;
+	const NI_ParamSetHeader* header;
+	const NI_ParamSetEntry* entries;
+	const char* file;
+	void* data = NULL;
+	size_t size = 0;
+	int32_t retval = NI_OK;
+	int32_t missing = 0;
+	uint32_t e;
 	
-	if((len == NULL) || (indices == NULL))
+	if ((path == NULL) || (NI_MapFile(path, &data, &size) != NI_OK))
 	{
+		SetErrorMessage("Cannot open the parameter set file.", 0);
 		return NI_ERROR;
 	}
 	
-	if (*len == -1)
+	file = (const char*)data;
+	header = (const NI_ParamSetHeader*)data;
+	entries = (const NI_ParamSetEntry*)(file + ((size >= sizeof(NI_ParamSetHeader)) ? header->directoryOffset : 0));
+	
+	/* Validate the header and the directory before using any offset of the file */
+	if ((size < sizeof(NI_ParamSetHeader)) || (memcmp(header->magic, NI_PARAMSET_MAGIC, 4) != 0) || 
+		(header->version != NI_PARAMSET_VERSION) || (header->fileSize != size) ||
+		(header->imageOffset > size) || (header->imageOffset % sizeof(double) != 0) || (header->imageSize > size - header->imageOffset) ||
+		(header->directoryOffset > size) || (header->directoryOffset % sizeof(uint32_t) != 0) || (header->count > (size - header->directoryOffset) / sizeof(NI_ParamSetEntry)))
 	{
-		*len = ParameterSize;
+		retval = NI_ERROR;
+	}
+	
+	for (e = 0; (retval == NI_OK) && (e < header->count); e++)
+	{
+		if ((entries[e].nameOffset >= size) || (memchr(file + entries[e].nameOffset, 0, size - entries[e].nameOffset) == NULL) ||
+			(entries[e].width < 0) || (entries[e].size < 0) || (entries[e].offset > header->imageSize) ||
+			((uint64_t)entries[e].size * (uint64_t)entries[e].width > header->imageSize - entries[e].offset))
+		{
+			retval = NI_ERROR;
+		}
+	}
+	
+	if (retval != NI_OK)
+	{
+		SetErrorMessage("Invalid parameter set file.", 0);
+	}
+	else if ((header->layoutHash == NI_ParameterLayoutHash()) && (header->imageSize == sizeof(Parameters)))
+	{
+		/* Same layout: a single copy of the image */
+		retval = NI_CommitParameterImage(file + header->imageOffset);
 	}
 	else
 	{
-		for (i = 0; i < ParameterSize && i < *len; i++)
+		/* Parameters set inline since the last commit must not be lost */
+		if (ReadSideDirtyFlag == 1)
 		{
-			indices[i] = i;
+			memcpy(&rtParameter[1-READSIDE], &rtParameter[READSIDE], sizeof(Parameters));
+			ReadSideDirtyFlag = 0;
 		}
 		
-		*len = i;
+		memcpy(&NI_ParamStaging, &rtParameter[1-READSIDE], sizeof(Parameters));
+		missing = NI_RemapParameterSet(file, header, entries);
+		
+		if (missing < (int32_t)header->count)
+		{
+			retval = NI_CommitParameterImage(&NI_ParamStaging);
+		}
+		else
+		{
+			SetErrorMessage("No parameter of the parameter set file matches the model.", 0);
+			retval = NI_ERROR;
+		}
 	}
-
-  	return NI_OK;	
+	
+	if (unmatched != NULL)
+	{
+		*unmatched = missing;
+	}
+	
+	NI_UnmapFile(data, size);
+	return retval;
 }
 
  /*========================================================================*
- * Function: NIRT_GetParameterSpec
+ * Function: NIRT_SaveParameterSet
  *
  * Abstract:
- *	If index == -1, lookup parameter by the ID.
- *	If ID_len == 0 or if ID == null, return number of parameters in model.
- *	Otherwise, lookup parameter by index, and return the information. 
+ *	Saves a snapshot of the read side parameters to a parameter set file.
  *
- * Input/Output Parameters:
- *	paramidx	: index of the parameter(in/out). If a value of "-1" is specified, the parameter's ID is used instead
- *	ID			: ID of parameter to be looked up (in), ID of parameter at index (out)
- *	ID_len		: length of input ID (in), length of ID (out)
- *	pnlen		: length of buffer paramname(in), length of the returned paramname (out)
- *	numdim		: length of buffer dimension(in), length of output dimension (out). If a value of "-1" is specified, the minimum buffer size of "dims" is returned as its value
+ * Input Parameters:
+ *	path	: path of the file
  *
- * Output Parameters: 
- *	paramname	: Name of the parameter
- *	datatype	: datatype of the parameter (currently assuming 0: double, .. )
- *	dims		: array of dimensions with length 'numdim'
- *		
  * Returns:
- *	NI_OK if no error (if paramidx == -1, number of tunable parameters)
+ *	NI_OK if no error
  *========================================================================*/
-DLL_EXPORT int32_t NIRT_GetParameterSpec(int32_t* pidx, char* ID, int32_t* ID_len, char* paramname, int32_t *pnlen, int32_t *dattype, int32_t* dims, int32_t* numdim)
+DLL_EXPORT int32_t NIRT_SaveParameterSet(const char* path)
 {
-	int32_t i= 0;
-	int32_t paramidx = *pidx;
+	NI_ParamSetHeader header;
+	NI_ParamSetEntry entry;
+	uint32_t nameOffset, len, maxLen = 0;
+	char* name;
+	FILE* fp;
+	int32_t i, ok;
+	
+	if ((path == NULL) || ((fp = fopen(path, "wb")) == NULL))
+	{
+		SetErrorMessage("Cannot create the parameter set file.", 0);
+		return NI_ERROR;
+	}
+	
+	/* Snapshot the read side first, the file is written from the snapshot */
+	memcpy(&NI_ParamStaging, &rtParameter[READSIDE], sizeof(Parameters));
+	
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, NI_PARAMSET_MAGIC, 4);
+	header.version = NI_PARAMSET_VERSION;
+	header.layoutHash = NI_ParameterLayoutHash();
+	header.count = (uint32_t)ParameterSize;
+	header.imageOffset = NI_CACHE_LINE_SIZE;
+	header.imageSize = sizeof(Parameters);
+	header.directoryOffset = header.imageOffset + header.imageSize;
+	header.fileSize = header.directoryOffset + header.count * sizeof(NI_ParamSetEntry);
+	for (i = 0; i < ParameterSize; i++)
+	{
+		len = NI_StringLength(rtParamAttribs[i].paramname);
+		maxLen = (len > maxLen) ? len : maxLen;
+		header.fileSize += len + 1;
+	}
+	
+	/* the names are decoded from rtStrings into this buffer */
+	name = (char*)malloc(maxLen + 1);
+	ok = (name != NULL) && (fwrite(&header, sizeof(header), 1, fp) == 1);
+	ok = ok && (fseek(fp, header.imageOffset, SEEK_SET) == 0);
+	ok = ok && (fwrite(&NI_ParamStaging, sizeof(Parameters), 1, fp) == 1);
+	
+	nameOffset = header.directoryOffset + header.count * sizeof(NI_ParamSetEntry);
+	for (i = 0; ok && (i < ParameterSize); i++)
+	{
+		entry.nameOffset = nameOffset;
+		entry.offset = (uint32_t)rtParamAttribs[i].addr;
+		entry.datatype = rtParamAttribs[i].datatype;
+		entry.size = Parameters_sizes[i + 1].size;
+		entry.width = rtParamAttribs[i].width;
+		ok = (fwrite(&entry, sizeof(entry), 1, fp) == 1);
+		nameOffset += NI_StringLength(rtParamAttribs[i].paramname) + 1;
+	}
+	
+	for (i = 0; ok && (i < ParameterSize); i++)
+	{
+		len = NI_CopyString(rtParamAttribs[i].paramname, name, maxLen);
+		name[len] = '\0';
+		ok = (fwrite(name, len + 1, 1, fp) == 1);
+	}
+	free(name);
+	
+	if ((fclose(fp) != 0) || !ok)
+	{
+		SetErrorMessage("Cannot write the parameter set file.", 0);
+		return NI_ERROR;
+	}
+	
+	return NI_OK;
+}
 
-	if (paramidx < 0) 
+ /*========================================================================*
+ * Function: NIRT_QueueParameter
+ *
+ * Abstract:
+ *	Queues a parameter change to take effect at a given simulation time: it is applied
+ *	by NIRT_Schedule at the first step whose time is not earlier than the requested one
+ *	(within half a base rate), before the model computes that step. The time is converted
+ *	to the tick of that step here, the step compares ticks. Changes due at the same step
+ *	are applied in the order they were queued. Can be called from any thread, it never
+ *	blocks and never blocks the step (requires "ParameterQueue" in the model definition).
+ *
+ * Input Parameters:
+ *	timestamp	: simulation time at which the change takes effect
+ *	index		: index of the parameter as returned by NIRT_GetParameterSpec()
+ *	subindex	: offset of the element within the parameter
+ *	value		: value to set the parameter to
+ *
+ * Returns:
+ *	NI_OK if queued, NI_ERROR if the parameter is out of bounds or the queue is full
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_QueueParameter(double timestamp, int32_t index, int32_t subindex, double value)
+{
+#ifdef NI_PARAM_QUEUE_SIZE
+	NI_QueuedParameter* slot;
+	int64_t pos, seq;
+	double tick = ceil(timestamp / USER_BaseRate - 0.5);
+	
+	if ((index < 0) || (index >= ParameterSize) || (subindex < 0) || (subindex >= rtParamAttribs[index].width) || (timestamp != timestamp))
 	{
-		/* check if ID has been specified. */
-		if ( (ID != NULL) && (ID_len != NULL) && (*ID_len > 0) ) 
+		return NI_ERROR;
+	}
+	
+	/* Claim a slot */
+	pos = NI_AtomicLoad64(&NI_ParamQueue.tail);
+	for (;;)
+	{
+		slot = &NI_ParamQueue.slots[pos & (NI_PARAM_QUEUE_SIZE - 1)];
+		seq = NI_AtomicLoad64(&slot->sequence);
+		
+		if (seq == pos)
 		{
-			/* lookup the table for matching ID */
-			for (i = 0; i < ParameterSize; i++) 
+			if (NI_AtomicCAS64(&NI_ParamQueue.tail, pos, pos + 1))
 			{
-				if (strcmp(ID, rtParamAttribs[i].paramname) == 0)
-				{
-					/* found matching string */
-					break;
-				}
+				break;
 			}
+		}
+		else if (seq < pos)
+		{
+			/* The step has not consumed this slot yet: the queue is full */
+			return NI_ERROR;
+		}
+		
+		pos = NI_AtomicLoad64(&NI_ParamQueue.tail);
+	}
+	
+	/* Fill it and hand it over to the step */
+	slot->tick = (tick <= 0.0) ? 0 : ((tick < 18446744073709551615.0) ? (uint64_t)tick : ~(uint64_t)0);
+	slot->index = index;
+	slot->subindex = subindex;
+	slot->value = value;
+	NI_AtomicStore64(&slot->sequence, pos + 1);
+	
+	return NI_OK;
+#else
+	UNUSED_PARAMETER(timestamp);
+	UNUSED_PARAMETER(index);
+	UNUSED_PARAMETER(subindex);
+	UNUSED_PARAMETER(value);
+	
+	return NI_ERROR;
+#endif
+}
 
-			if (i < ParameterSize)
-			{
-				/* note the index into the rtParamAttribs */
-				paramidx = *pidx = i;
-			}
-			else
-			{
-				return ParameterSize;
-			}
-		} 
+#ifdef NI_PARAM_QUEUE_SIZE
+ /*========================================================================*
+ * Function: NI_ApplyQueuedParameters
+ *
+ * Abstract:
+ *	Moves the parameter changes queued since the last step to the buckets of their
+ *	ticks, then applies the changes due at the step at tick to the read side. Called by
+ *	NIRT_Schedule while it holds the flip semaphore. A step only visits the bucket of its
+ *	tick: applying k changes costs O(k), plus the changes queued a whole turn of the
+ *	wheel (NI_PARAM_WHEEL_SIZE ticks) or more ahead that share the bucket. After a jump
+ *	of the tick (NIRT_SetModelTick) the buckets of the skipped ticks are visited once.
+ *	The changed parameters are marked, the next commit carries them over
+ *	(NI_MergeQueuedParameters).
+========================================================================*/
+static void NI_ApplyQueuedParameters(uint64_t tick)
+{
+	NI_QueuedParameter* slot;
+	NI_PendingParameter* entry;
+	uint64_t t;
+	int32_t e, next, prev, bucket;
+	
+	while (NI_ParamQueue.free >= 0)
+	{
+		slot = &NI_ParamQueue.slots[NI_ParamQueue.head & (NI_PARAM_QUEUE_SIZE - 1)];
+		if (NI_AtomicLoad64(&slot->sequence) != NI_ParamQueue.head + 1)
+		{
+			break;
+		}
+		
+		e = NI_ParamQueue.free;
+		entry = &NI_ParamQueue.pending[e];
+		NI_ParamQueue.free = entry->next;
+		
+		/* A change for an earlier tick takes effect at this step */
+		entry->tick = (slot->tick < tick) ? tick : slot->tick;
+		entry->index = slot->index;
+		entry->subindex = slot->subindex;
+		entry->value = slot->value;
+		entry->next = -1;
+		NI_AtomicStore64(&slot->sequence, NI_ParamQueue.head + NI_PARAM_QUEUE_SIZE);
+		NI_ParamQueue.head++;
+		
+		bucket = (int32_t)(entry->tick & (NI_PARAM_WHEEL_SIZE - 1));
+		if (NI_ParamQueue.last[bucket] >= 0)
+		{
+			NI_ParamQueue.pending[NI_ParamQueue.last[bucket]].next = e;
+		}
 		else
 		{
-			/* no index or ID specified. */
-			return ParameterSize;
+			NI_ParamQueue.first[bucket] = e;
 		}
+		NI_ParamQueue.last[bucket] = e;
 	}
 	
-	if ( (paramidx >= 0) && (paramidx < ParameterSize) ) 
+	/* The buckets from the first tick not applied yet (after a jump forward, at most one
+	   turn of the wheel) to this one, a jump back only applies this tick */
+	t = (NI_ParamQueue.nextTick > tick) ? tick : NI_ParamQueue.nextTick;
+	if (tick - t >= NI_PARAM_WHEEL_SIZE)
 	{
-		if(ID != NULL) 
+		t = tick - (NI_PARAM_WHEEL_SIZE - 1);
+	}
+	for (;; t++)
+	{
+		bucket = (int32_t)(t & (NI_PARAM_WHEEL_SIZE - 1));
+		for (prev = -1, e = NI_ParamQueue.first[bucket]; e >= 0; e = next)
 		{
-			if ((int32_t)strlen(rtParamAttribs[paramidx].paramname) < *ID_len)
+			entry = &NI_ParamQueue.pending[e];
+			next = entry->next;
+			if (entry->tick > tick)
+			{
+				/* due a turn of the wheel or more later */
+				prev = e;
+				continue;
+			}
+			
+			USER_SetValueByDataType((char*)&rtParameter[READSIDE] + rtParamAttribs[entry->index].addr, entry->subindex, 
+				entry->value, rtParamAttribs[entry->index].datatype);
+			NI_ParamQueue.touched[entry->index >> 5] |= 1u << (entry->index & 31);
+			NIRT_system.paramGeneration++;
+			
+			/* Unlink it and return it to the free list */
+			if (prev >= 0)
+			{
+				NI_ParamQueue.pending[prev].next = next;
+			}
+			else
 			{
-				*ID_len = strlen(rtParamAttribs[paramidx].paramname);
+				NI_ParamQueue.first[bucket] = next;
 			}
-			strncpy(ID, rtParamAttribs[paramidx].paramname, *ID_len);
-		}
-
-		if(paramname != NULL) 
-		{
-			/* no need for return string to be null terminated! */
-			if ((int32_t)strlen(rtParamAttribs[paramidx].paramname) < *pnlen)
+			if (NI_ParamQueue.last[bucket] == e)
 			{
-				*pnlen = strlen(rtParamAttribs[paramidx].paramname);
+				NI_ParamQueue.last[bucket] = prev;
 			}
-			strncpy(paramname, rtParamAttribs[paramidx].paramname, *pnlen);
-		}
-
-		if (dattype != NULL)
-		{
-			*dattype = rtParamAttribs[paramidx].datatype;
+			entry->next = NI_ParamQueue.free;
+			NI_ParamQueue.free = e;
 		}
 		
-		if (numdim != NULL)
+		if (t == tick)
 		{
-			if (*numdim == -1)
-			{
-				*numdim = rtParamAttribs[paramidx].numofdims;
-			}
-			else if (dims != NULL)
-			{
-				for (i = 0; i < *numdim; i++)
-				{
-					dims[i] = ParamDimList[rtParamAttribs[paramidx].dimListOffset + i];
-				}
-			}
+			break;
 		}
-
-		return NI_OK;
 	}
-
-	return ParameterSize;	
+	NI_ParamQueue.nextTick = tick + 1;
 }
+#endif
 
+#ifdef NI_STEADY_STATE
  /*========================================================================*
- * Function: NIRT_GetParameter
+ * Function: NI_SteadyStateSkip
  *
  * Abstract:
- *	Get the current value of a parameter.
- * 
- * Input Parameters: 
- *	index	: index of the parameter
- *	subindex: element index into the flattened array if an array
- * 
- * Output Parameters:
- *	val		: value of the parameter 
+ *	Checks if the step can be skipped: the last computed step converged and neither
+ *	the marked inputs nor the parameters have changed since. Every NI_STEADY_RECHECK
+ *	skipped steps one step is computed anyway: a state drifting by less than its
+ *	tolerance per step then moves away from its anchor and ends the steady state.
  *
  * Returns:
- *	NI_OK if no error
- *========================================================================*/
-DLL_EXPORT int32_t NIRT_GetParameter(int32_t index, int32_t subindex, double* val)
+ *	1 if the step can be skipped, 0 otherwise
+========================================================================*/
+static int32_t NI_SteadyStateSkip(const double *inData)
 {
-  	char* ptr = NULL;
+	int32_t i;
 	
-	/* Check index boundaries */
-  	if ( (index >= ParameterSize) || (index < 0) || (subindex >= rtParamAttribs[index].width) )
+	if (!NI_SteadyStateInfo.steady || (NI_SteadyStateInfo.paramGeneration != NIRT_system.paramGeneration)
+		|| (NI_SteadyStateInfo.probeGeneration != NIRT_system.probeGeneration))
 	{
-	    return NI_ERROR;
+		return 0;
 	}
 	
-	/* Get the parameter's address into the Parameter struct 
-	casting to char to perform pointer arithmetic using the byte offset */
-  	ptr = (char*)&rtParameter[READSIDE] + rtParamAttribs[index].addr;
+	if ((NI_SteadyStateInfo.nullInputs != (inData == NULL)) || (NI_SteadyStateInfo.skippedInRow >= NI_STEADY_RECHECK))
+	{
+		return 0;
+	}
 	
-	/* Convert the parameter's internal datatype to double and return its value */
-  	*val = USER_GetValueByDataType(ptr, subindex, rtParamAttribs[index].datatype);
+	for (i = 0; (inData != NULL) && (i < SteadyInputSize); i++)
+	{
+		if (inData[SteadyInputList[i]] != SteadyInputs[i])
+		{
+			return 0;
+		}
+	}
 	
-  	return NI_OK;	
+	NI_SteadyStateInfo.skippedInRow++;
+	return 1;
 }
 
  /*========================================================================*
- * Function: NIRT_GetVectorParameter
+ * Function: NI_SteadyStateBegin
  *
  * Abstract:
- *	Get the current value of a vector parameter.
- * 
- * Input Parameters: 
- *	index: index of the parameter
- *	paramLength: length of the parameter
- * 
- * Output Parameters:
- *	paramValues: an array of the parameter's value
- *
- * Returns:
- *	NI_OK if no error
- *========================================================================*/
-DLL_EXPORT int32_t NIRT_GetVectorParameter(uint32_t index, double* paramValues, uint32_t paramLength)
+ *	Records the inputs, parameter and probe generations a step is computed from.
+========================================================================*/
+static void NI_SteadyStateBegin(const double *inData)
 {
-  	char* ptr = NULL;
-	uint32_t i = 0;
+	int32_t i;
 	
-	/* Check index boundaries */
-  	if ( (index >= ParameterSize) || (index < 0) || (paramLength != rtParamAttribs[index].width) )
-	{
-	    return NI_ERROR;
-	}
-
-	/* Get the parameter's address into the Parameter struct 
-	casting to char to perform pointer arithmetic using the byte offset */
-  	ptr = (char*)&rtParameter[READSIDE] + rtParamAttribs[index].addr;
+	NI_SteadyStateInfo.paramGeneration = NIRT_system.paramGeneration;
+	NI_SteadyStateInfo.probeGeneration = NIRT_system.probeGeneration;
+	NI_SteadyStateInfo.nullInputs = (inData == NULL);
+	NI_SteadyStateInfo.skippedInRow = 0;
 	
-  	while(i < paramLength)
+	for (i = 0; (inData != NULL) && (i < SteadyInputSize); i++)
 	{
-		/* Convert the parameter's internal datatype to double and return its value */
-		paramValues[i] = USER_GetValueByDataType(ptr, i, rtParamAttribs[index].datatype);
-		i++;
+		SteadyInputs[i] = inData[SteadyInputList[i]];
 	}
-	
-  	return NI_OK;	
 }
 
  /*========================================================================*
- * Function: NIRT_SetParameter
+ * Function: NI_SteadyStateEnd
  *
  * Abstract:
- *	Set parameter value. Called either in scheduler loop or a background loop. 
- * 	
- * Input Parameters:
- *	index	: index of the parameter (as specified in Parameter Information)
- *	subindex: index in the flattened array, if parameter is n-D array
- *	val		: Value to set the parameter to
- *
- * Returns:
- *	NI_OK if no error
- *========================================================================*/
-DLL_EXPORT int32_t NIRT_SetParameter(int32_t index, int32_t subindex, double val)
+ *	Checks if every marked state is within its tolerance of its anchor, the value it
+ *	had when it was last found moving. The anchors only move when the check fails, so
+ *	a slow drift accumulates over the computed steps instead of passing step by step.
+ *	The model is steady once the states stayed near their anchors for NI_STEADY_RECHECK
+ *	computed steps: a drift that would leave the tolerance within that many steps
+ *	never counts as converged.
+========================================================================*/
+static void NI_SteadyStateEnd(void)
 {
-  	char* ptr = NULL;
-	
-	/* Check bounds */
-  	if (index >= ParameterSize) 
-	{
-	  	NIRT_system.SetParamTxStatus = NI_ERROR;
-		SetErrorMessage("Parameter index is out of bounds.", 1);
-	    return NIRT_system.SetParamTxStatus;
-    }
+	double delta;
+	int32_t i, quiet = 1;
 	
-	/* Commit parameter values */
-  	if (index < 0) 
+	for (i = 0; i < SteadyStateSize; i++)
 	{
-		/* Check if the read-side has since been modified. If it is, return an error and flush all changes to the write-side*/
-		if(ReadSideDirtyFlag == 1)
-		{
-			memcpy(&rtParameter[1-READSIDE], &rtParameter[READSIDE], sizeof(Parameters));
-			ReadSideDirtyFlag = 0;
-			
-			if(WriteSideDirtyFlag == 0)
-			{
-				/* No values to commit */
-				return NI_OK;
-			}
-			else
-			{
-				SetErrorMessage("Parameters have been set inline and from the background loop at the same time. Parameters written from the background loop since the last commit have been lost.",1);
-				WriteSideDirtyFlag = 0;
-				return NI_ERROR;
-			}
-		}
-
-		/* If an error occurred and we have values to commit, then save to the write side and return error */
-	    if (NIRT_system.SetParamTxStatus == NI_ERROR) 
-		{
-	 		if(WriteSideDirtyFlag == 1)
-			{
-				memcpy(&rtParameter[READSIDE], &rtParameter[1-READSIDE], sizeof(Parameters));
-			}
-
-      		/* reset the status. */
-      		NIRT_system.SetParamTxStatus = NI_OK;
-			WriteSideDirtyFlag = 0;
-			
-      		return NI_ERROR;
-	    }
+		delta = USER_GetValueByDataType(rtSteadyStates[i].addr, 0, rtSteadyStates[i].datatype) - rtSteadyStates[i].anchor;
 		
-		/* If we have values to commit, then save to the write-side */
-		if(WriteSideDirtyFlag == 1)
+		/* also false for NaN */
+		if (!(delta <= rtSteadyStates[i].tolerance && -delta <= rtSteadyStates[i].tolerance))
 		{
-			/* commit changes */
-			WaitForSingleObject(NIRT_system.flip, INFINITE);
-			READSIDE = 1 - READSIDE;
-			ReleaseSemaphore(NIRT_system.flip, 1, NULL);
-
-			/* Copy back the newly set parameters to the write-side. */
-			memcpy(&rtParameter[1-READSIDE], &rtParameter[READSIDE], sizeof(Parameters));
-			WriteSideDirtyFlag = 0;
+			quiet = 0;
+			break;
 		}
-		
-    	return NI_OK;
-  	}
-	else
+	}
+	
+	if (!quiet)
 	{
-		/* Update a parameter value in the pending buffer */
-
-		/* verify that sub-index is within bounds. */
-		if (subindex >= rtParamAttribs[index].width) 
-		{
-			NIRT_system.SetParamTxStatus = NI_ERROR;
-			SetErrorMessage("Parameter subindex is out of bounds.",1);
-			return NIRT_system.SetParamTxStatus;
-		}
-
-		/* If we have pending modified parameters, then copy to write-side */
-		if(ReadSideDirtyFlag == 1)
+		for (i = 0; i < SteadyStateSize; i++)
 		{
-			memcpy(&rtParameter[1-READSIDE], &rtParameter[READSIDE], sizeof(Parameters));
-			ReadSideDirtyFlag = 0;
+			rtSteadyStates[i].anchor = USER_GetValueByDataType(rtSteadyStates[i].addr, 0, rtSteadyStates[i].datatype);
 		}
-			
-		/* Get the parameter's address into the Parameter struct 
-		casting to char to perform pointer arithmetic using the byte offset */
-		ptr = (char*)&rtParameter[1-READSIDE] + rtParamAttribs[index].addr;
-		WriteSideDirtyFlag = 1;
-		
-		/* Convert the incoming double datatype to the parameter's internal datatype and update value */
-		return USER_SetValueByDataType(ptr, subindex, val, rtParamAttribs[index].datatype);
+		NI_SteadyStateInfo.quietSteps = 0;
+	}
+	else if (NI_SteadyStateInfo.quietSteps < NI_STEADY_RECHECK)
+	{
+		NI_SteadyStateInfo.quietSteps++;
 	}
+	
+	NI_SteadyStateInfo.steady = (NI_SteadyStateInfo.quietSteps >= NI_STEADY_RECHECK);
 }
+#endif
 
+#ifdef NI_PURE_MODEL
  /*========================================================================*
- * Function: NIRT_SetScalarParameterInline
+ * Function: NI_MemoHit
  *
  * Abstract:
- *	Sets the value to a parameter immediately without the need of a commit request.
- *
- * Input Parameters:
- *	index		: index of the parameter as returned by NIRT_GetParameterSpec()
- *	subindex	: offset of the element within the parameter
- *	paramvalue	: Value to set the parameter to
+ *	Checks if the outputs of the last computed step of a pure model can be reused:
+ *	the inputs are bit-identical and the parameters have not changed since.
  *
  * Returns:
- *	NI_OK if no error
- *========================================================================*/
-DLL_EXPORT int32_t NIRT_SetScalarParameterInline( uint32_t index,  uint32_t subindex,  double paramvalue)
+ *	1 if the step can be skipped, 0 otherwise
+========================================================================*/
+static int32_t NI_MemoHit(const double *inData)
 {
-  	char* ptr = NULL;
-	
-	/*verify that index is within bounds*/
-  	if (index >= ParameterSize) 
+	if (!NI_MemoInfo.valid || (NI_MemoInfo.paramGeneration != NIRT_system.paramGeneration)
+		|| (NI_MemoInfo.probeGeneration != NIRT_system.probeGeneration))
 	{
-	  	NIRT_system.SetParamTxStatus = NI_ERROR;
-		SetErrorMessage("Parameter index is out of bounds.",1);
-	    return NIRT_system.SetParamTxStatus;
-    }
-
-  	/* verify that parameter length is correct. */
-  	if (subindex >= rtParamAttribs[index].width) 
+		return 0;
+	}
+	
+	if (NI_MemoInfo.nullInputs != (inData == NULL))
 	{
-	  	NIRT_system.SetParamTxStatus = NI_ERROR;
-		SetErrorMessage("Parameter subindex is out of bounds.",1);
-	    return NIRT_system.SetParamTxStatus;
-    }
+		return 0;
+	}
 	
-	/* Get the parameter's address into the Parameter struct 
-	casting to char to perform pointer arithmetic using the byte offset */
-  	ptr = (char*)&rtParameter[READSIDE] + rtParamAttribs[index].addr;
-	ReadSideDirtyFlag = 1;
+	return (inData == NULL) || (memcmp(inData, MemoInputs, InportSize * sizeof(double)) == 0);
+}
+
+ /*========================================================================*
+ * Function: NI_MemoRecord
+ *
+ * Abstract:
+ *	Records the inputs, parameter and probe generations a step of a pure model was computed from.
+========================================================================*/
+static void NI_MemoRecord(const double *inData, uint32_t paramGeneration, uint32_t probeGeneration)
+{
+	NI_MemoInfo.valid = 1;
+	NI_MemoInfo.paramGeneration = paramGeneration;
+	NI_MemoInfo.probeGeneration = probeGeneration;
+	NI_MemoInfo.nullInputs = (inData == NULL);
 	
-	/* Convert the incoming double datatype to the parameter's internal datatype and update value */
-	return USER_SetValueByDataType(ptr, subindex, paramvalue, rtParamAttribs[index].datatype);
+	if (inData != NULL)
+	{
+		memcpy(MemoInputs, inData, InportSize * sizeof(double));
+	}
 }
+#endif
 
  /*========================================================================*
- * Function: NIRT_SetVectorParameter
+ * Function: NI_TakeOneStep
  *
  * Abstract:
- *	Sets the value to a parameter array.
- * 	
- * Input Parameters:
- *	index		: index of the parameter as returned by NIRT_GetParameterSpec()
- *	paramvalues	: array of values to set
- *	paramlength	: Length of parameter values.
+ *	Computes one step of the model. A pure model skips the equations while its
+ *	inputs and parameters are unchanged, a model with steady-state detection while
+ *	it is quiescent; both only republish their outputs.
  *
  * Returns:
  *	NI_OK if no error
- *========================================================================*/
-DLL_EXPORT int32_t NIRT_SetVectorParameter( uint32_t index, const double* paramvalues,  uint32_t paramlength)
+========================================================================*/
+static int32_t NI_TakeOneStep(double *inData, double *outData, double timestamp)
 {
-  	char* ptr = NULL;
-	uint32_t i = 0;
 	int32_t retval = NI_OK;
+#ifdef NI_DEADLINE_BUDGET
+	double start = NI_Now();
+#endif
 	
-	/*verify that index is within bounds*/
-  	if (index >= ParameterSize) 
+#ifdef NI_SEQUENCE_FRAME_SIZE
+	/* the sequence runs first, the step sees what it wrote */
+	if ((NIRT_system.tick >= rtModel.sequence.wakeTick) && (NI_ResumeSequence() != NI_OK))
 	{
-	  	NIRT_system.SetParamTxStatus = NI_ERROR;
-		SetErrorMessage("Parameter index is out of bounds.",1);
-	    return NIRT_system.SetParamTxStatus;
-    }
-
-  	/* verify that parameter length is correct. */
-  	if (paramlength != rtParamAttribs[index].width) 
+		return NI_ERROR;
+	}
+#endif
+	
+#ifdef NI_DEADLINE_BUDGET
+	
+	NI_DeadlineInfo.deadline = start + NI_DEADLINE_BUDGET * USER_BaseRate;
+	NI_DeadlineInfo.shedding = 0;
+	NI_DeadlineInfo.stepShed = 0;
+#endif
+	
+#ifdef NI_PURE_MODEL
+	uint32_t paramGeneration = NIRT_system.paramGeneration;
+	uint32_t probeGeneration = NIRT_system.probeGeneration;
+	
+	if (NI_MemoHit(inData))
 	{
-	  	NIRT_system.SetParamTxStatus = NI_ERROR;
-		SetErrorMessage("Parameter length is incorrect.",1);
-	    return NIRT_system.SetParamTxStatus;
-    }
+		NI_MemoInfo.reusedSteps++;
+		return USER_PublishOutputs(outData);
+	}
 	
-	/* If we have pending modified parameters, then copy to write-side */
-	if(ReadSideDirtyFlag == 1)
+	/* the generations are sampled before the step, a commit during the step forces a recompute */
+	NI_MemoInfo.valid = 0;
+#endif
+	
+#ifdef NI_STEADY_STATE
+	if (NI_SteadyStateSkip(inData))
 	{
-		memcpy(&rtParameter[1-READSIDE], &rtParameter[READSIDE], sizeof(Parameters));
-		ReadSideDirtyFlag = 0;
+		NI_SteadyStateInfo.skippedSteps++;
+		return USER_PublishOutputs(outData);
 	}
 	
-	/* Get the parameter's address into the Parameter struct 
-	casting to char to perform pointer arithmetic using the byte offset */
-  	ptr = (char*)&rtParameter[1-READSIDE] + rtParamAttribs[index].addr;
+	NI_SteadyStateBegin(inData);
+	retval = USER_TakeOneStep(inData, outData, timestamp);
+	NI_SteadyStateEnd();
+#else
+	retval = USER_TakeOneStep(inData, outData, timestamp);
+#endif
 	
-	while(i < paramlength)
+#ifdef NI_PURE_MODEL
+	if (retval == NI_OK)
 	{
-		/* Convert the incoming double datatype to the parameter's internal datatype and update value */
-		retval = retval & USER_SetValueByDataType(ptr, i, paramvalues[i], rtParamAttribs[index].datatype);
-		i++;
+		NI_MemoRecord(inData, paramGeneration, probeGeneration);
 	}
+#endif
+	
+#ifdef NI_DEADLINE_BUDGET
+	NI_DeadlineInfo.stepCost += (NI_Now() - start - NI_DeadlineInfo.stepCost) * 0.125;
+	if (NI_DeadlineInfo.stepShed)
+	{
+		NI_DeadlineInfo.shedSteps++;
+		NI_DeadlineInfo.shedCount += NI_DeadlineInfo.stepShed;
+	}
+#endif
 	
-	WriteSideDirtyFlag = 1;
 	return retval;
 }
 
+/* Moves the model time to the next tick. The time is computed from the tick instead of 
+   accumulated, so there is no rounding drift. */
+static void NI_AdvanceTick(void)
+{
+	NIRT_system.tick++;
+	NIRT_system.timestamp = (double)NIRT_system.tick * USER_BaseRate;
+}
+
+ /*========================================================================*
+ * Function: NI_SetModelTick
+ *
+ * Abstract:
+ *	Moves the model time to the given base rate tick. The caller holds the flip 
+ *	semaphore: NIRT_SetModelTick takes it, NIRT_SetSimState called between
+ *	NIRT_Schedule and NIRT_ModelUpdate already holds it.
+========================================================================*/
+void NI_SetModelTick(uint64_t tick)
+{
+	NIRT_system.tick = tick;
+	NIRT_system.timestamp = (double)tick * USER_BaseRate;
+}
+
  /*========================================================================*
  * Function: NIRT_Schedule
  *
@@ -1072,13 +3867,78 @@ DLL_EXPORT int32_t NIRT_Schedule(double *inData, double *outData, double *outTim
 	}
 	else
 	{
-		retval = USER_TakeOneStep(inData, outData, NIRT_system.timestamp);
+		NI_ModelThread = &NI_ThreadTag;
+#ifdef NI_PARAM_QUEUE_SIZE
+		NI_ApplyQueuedParameters(NIRT_system.tick);
+#endif
+		retval = NI_TakeOneStep(inData, outData, NIRT_system.timestamp);
+#if defined (NI_SHM_PUBLISH) && defined (kNIOSLinux)
+		NI_ShmPublish();
+#endif
 		NIRT_system.inCriticalSection++;
 	}
 	
 	return retval;
 }
 
+ /*========================================================================*
+ * Function: NIRT_ScheduleN
+ *
+ * Abstract:
+ *	Runs numTicks consecutive base rate ticks in one call. The flip semaphore is
+ *	held for the whole call, which keeps the read side parameters pinned.
+ *
+ * Input Parameters: 
+ *	inData		: numTicks rows of model inputs, or NULL
+ *	numTicks	: number of ticks to run
+ *
+ * Output Parameters:
+ *	outData		: numTicks rows of model outputs, or NULL
+ *	outTime		: simulation time of the last tick computed
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_ScheduleN(const double *inData, double *outData, int32_t numTicks, double *outTime)
+{
+	int32_t retval = NI_OK;
+	int32_t i;
+	
+	if (NIRT_system.stopExecutionFlag)
+	{
+		return NI_ERROR;
+	}
+	
+	WaitForSingleObject(NIRT_system.flip, INFINITE);
+	if (NIRT_system.inCriticalSection > 0) 
+	{
+		SetErrorMessage("ScheduleN() cannot be called between Schedule() and ModelUpdate().", 1);
+		ReleaseSemaphore(NIRT_system.flip, 1, NULL);
+		return NI_ERROR;
+	}
+	NI_ModelThread = &NI_ThreadTag;
+	
+	for (i = 0; (i < numTicks) && (retval == NI_OK) && !NIRT_system.stopExecutionFlag; i++)
+	{
+#ifdef NI_PARAM_QUEUE_SIZE
+		NI_ApplyQueuedParameters(NIRT_system.tick);
+#endif
+		retval = NI_TakeOneStep((inData != NULL) ? (double *)inData + (size_t)i * InportSize : NULL, 
+			(outData != NULL) ? outData + (size_t)i * OutportSize : NULL, NIRT_system.timestamp);
+#if defined (NI_SHM_PUBLISH) && defined (kNIOSLinux)
+		NI_ShmPublish();
+#endif
+		if (outTime)
+		{
+			*outTime = NIRT_system.timestamp;
+		}
+		NI_AdvanceTick();
+	}
+	
+	ReleaseSemaphore(NIRT_system.flip, 1, NULL);
+	return (NIRT_system.stopExecutionFlag ? NI_ERROR : retval);
+}
+
  /*========================================================================*
  * Function: NIRT_ModelUpdate
  *
@@ -1096,7 +3956,7 @@ DLL_EXPORT int32_t NIRT_ModelUpdate(void)
 	if (NIRT_system.inCriticalSection) 
 	{
 		NIRT_system.inCriticalSection--;
-		NIRT_system.timestamp += USER_BaseRate;
+		NI_AdvanceTick();
 		ReleaseSemaphore(NIRT_system.flip, 1, NULL);
 	} 
 	else 
@@ -1107,6 +3967,50 @@ DLL_EXPORT int32_t NIRT_ModelUpdate(void)
 	return NIRT_system.inCriticalSection;
 }
 
+ /*========================================================================*
+ * Function: NIRT_GetModelTick
+ *
+ * Abstract:
+ *	Returns the number of base rate ticks since the model was initialized.
+ *
+ * Output Parameters:
+ *	tick	: current base rate tick
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_GetModelTick(uint64_t* tick)
+{
+	if (tick)
+	{
+		*tick = NIRT_system.tick;
+	}
+	
+	return NI_OK;
+}
+
+ /*========================================================================*
+ * Function: NIRT_SetModelTick
+ *
+ * Abstract:
+ *	Moves the model time to the given base rate tick. Waits for the current step 
+ *	to complete.
+ *
+ * Input Parameters: 
+ *	tick	: new base rate tick
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_SetModelTick(uint64_t tick)
+{
+	WaitForSingleObject(NIRT_system.flip, INFINITE);
+	NI_SetModelTick(tick);
+	ReleaseSemaphore(NIRT_system.flip, 1, NULL);
+	
+	return NI_OK;
+}
+
  /*========================================================================*
  * Function: NIRT_GetExtIOSpec
  *
@@ -1178,6 +4082,112 @@ DLL_EXPORT int32_t NIRT_GetExtIOSpec(int32_t index, int32_t *idx, char* name, in
   	return NI_OK;
 }
 
+ /*========================================================================*
+ * Function: NIRT_GetSteadyStateInfo
+ *
+ * Abstract:
+ *	Reports whether a model with steady-state detection is currently quiescent, i.e. 
+ *	skipping its equations, and how many steps it has skipped so far.
+ *
+ * Output Parameters:
+ *	steady			: 1 if the model is quiescent, 0 otherwise
+ *	skippedSteps	: number of steps skipped since the model was initialized
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the model has no steady-state detection
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_GetSteadyStateInfo(int32_t* steady, double* skippedSteps)
+{
+#ifdef NI_STEADY_STATE
+	if (steady != NULL)
+	{
+		*steady = NI_SteadyStateInfo.steady;
+	}
+	
+	if (skippedSteps != NULL)
+	{
+		*skippedSteps = NI_SteadyStateInfo.skippedSteps;
+	}
+	
+	return NI_OK;
+#else
+	UNUSED_PARAMETER(steady);
+	UNUSED_PARAMETER(skippedSteps);
+	
+	return NI_ERROR;
+#endif
+}
+
+ /*========================================================================*
+ * Function: NIRT_GetSheddingInfo
+ *
+ * Abstract:
+ *	Reports how often a model with a step deadline shed optional work to meet it.
+ *
+ * Output Parameters:
+ *	shedSteps	: number of steps in which optional work was shed
+ *	shedCount	: number of optional computations shed
+ *	stepCost	: running estimate of the step execution time (s)
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the model has no step deadline
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_GetSheddingInfo(double* shedSteps, double* shedCount, double* stepCost)
+{
+#ifdef NI_DEADLINE_BUDGET
+	if (shedSteps != NULL)
+	{
+		*shedSteps = NI_DeadlineInfo.shedSteps;
+	}
+	
+	if (shedCount != NULL)
+	{
+		*shedCount = NI_DeadlineInfo.shedCount;
+	}
+	
+	if (stepCost != NULL)
+	{
+		*stepCost = NI_DeadlineInfo.stepCost;
+	}
+	
+	return NI_OK;
+#else
+	UNUSED_PARAMETER(shedSteps);
+	UNUSED_PARAMETER(shedCount);
+	UNUSED_PARAMETER(stepCost);
+	
+	return NI_ERROR;
+#endif
+}
+
+ /*========================================================================*
+ * Function: NIRT_GetMemoizationInfo
+ *
+ * Abstract:
+ *	Reports how many steps a pure model has skipped by reusing its previous outputs.
+ *
+ * Output Parameters:
+ *	reusedSteps	: number of steps skipped since the model was initialized
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the model is not pure
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_GetMemoizationInfo(double* reusedSteps)
+{
+#ifdef NI_PURE_MODEL
+	if (reusedSteps != NULL)
+	{
+		*reusedSteps = NI_MemoInfo.reusedSteps;
+	}
+	
+	return NI_OK;
+#else
+	UNUSED_PARAMETER(reusedSteps);
+	
+	return NI_ERROR;
+#endif
+}
+
  /*========================================================================*
  * Function: NIRT_FinalizeModel
  *
@@ -1189,10 +4199,53 @@ DLL_EXPORT int32_t NIRT_GetExtIOSpec(int32_t index, int32_t *idx, char* name, in
  *========================================================================*/
 DLL_EXPORT int32_t NIRT_FinalizeModel(void) 
 {
+	NI_StopSubsystemPool();
+#if defined (NI_SHM_PUBLISH) && defined (kNIOSLinux)
+	NI_ShmDestroy();
+#endif
 	CloseHandle(NIRT_system.flip);
+#ifdef NI_SEQUENCE_FRAME_SIZE
+	NI_StopSequence();
+#endif
 	return USER_Finalize();
 }
 
+ /*========================================================================*
+ * Function: NIRT_GetModelMetadata
+ *
+ * Abstract:
+ *	Copies the metadata image of the model: the static part in .NIVS.metadata, then
+ *	the names in rtStrings.
+ *
+ * Input/Output Parameters:
+ *	size	: size of the image buffer (in), size of the image (out). 
+ *			  If image is NULL, only the size is returned.
+ *
+ * Output Parameters:
+ *	image	: buffer receiving the image
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the buffer is too small
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_GetModelMetadata(void* image, uint32_t* size)
+{
+	if (size == NULL)
+	{
+		return NI_ERROR;
+	}
+	
+	if ((image != NULL) && (*size >= rtMetadataImage->size))
+	{
+		memcpy(image, rtMetadataImage, rtMetadataImage->stringOffset);
+		memcpy((char *)image + rtMetadataImage->stringOffset, rtStrings, rtMetadataImage->stringSize);
+		*size = rtMetadataImage->size;
+		return NI_OK;
+	}
+	
+	*size = rtMetadataImage->size;
+	return (image == NULL) ? NI_OK : NI_ERROR;
+}
+
  /*========================================================================*
  * Function: NIRT_GetModelSpec
  *
@@ -1270,6 +4323,106 @@ DLL_EXPORT int32_t NIRT_GetModelSpec(char* name, int32_t *namelen, double *baseT
 	return NI_OK;	
 }
 
+ /*========================================================================*
+ * Function: NIRT_GetTaskSpec
+ *
+ * Abstract:
+ *	Returns the specification of a task. The models of this framework have the 
+ *	base rate task only.
+ *
+ * Input Parameters:
+ *	index	: index of the task, -1 for the number of tasks
+ *
+ * Output Parameters:
+ *	tid		: task ID
+ *	tstep	: time step of the task
+ *	offset	: offset of the task
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the index is out of bounds (if index == -1, the
+ *	number of tasks)
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_GetTaskSpec(int32_t index, int32_t* tid, double *tstep, double *offset)
+{
+	if (index == -1)
+	{
+		return 1;
+	}
+	
+	if (index != 0)
+	{
+		return NI_ERROR;
+	}
+	
+	if (tid != NULL)
+	{
+		*tid = 0;
+	}
+	
+	if (tstep != NULL)
+	{
+		*tstep = USER_BaseRate;
+	}
+	
+	if (offset != NULL)
+	{
+		*offset = 0;
+	}
+	
+	return NI_OK;
+}
+
+ /*========================================================================*
+ * Function: NIRT_TaskTakeOneStep
+ *
+ * Abstract:
+ *	Advances a task one step. NIRT_Schedule steps the base rate task and never
+ *	dispatches another one, so there is nothing left to do for it.
+ *
+ * Returns:
+ *	NI_OK for the base rate task, NI_ERROR for any other task ID
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_TaskTakeOneStep(int32_t taskid)
+{
+	return (taskid == 0) ? NI_OK : NI_ERROR;
+}
+
+ /*========================================================================*
+ * Function: NIRT_TaskRunTimeInfo
+ *
+ * Abstract:
+ *	Returns the overruns of the tasks. The host times the steps (e.g. ni_runner counts
+ *	the overruns), the model does not, so it reports none.
+ *
+ * Input Parameters:
+ *	halt		: 1: do not halt on task overruns, 2: halt. Not used.
+ *
+ * Input/Output Parameters:
+ *	numtasks	: length of overruns (in), number of tasks (out)
+ *
+ * Output Parameters:
+ *	overruns	: number of overruns per task, may be NULL
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_TaskRunTimeInfo(int32_t halt, int32_t* overruns, int32_t *numtasks)
+{
+	UNUSED_PARAMETER(halt);
+	
+	if ((overruns != NULL) && (numtasks != NULL) && (*numtasks > 0))
+	{
+		overruns[0] = 0;
+	}
+	
+	if (numtasks != NULL)
+	{
+		*numtasks = 1;
+	}
+	
+	return NI_OK;
+}
+
  /*========================================================================*
  * Function: NIRT_GetBuildInfo
  *
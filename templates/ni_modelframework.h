@@ -91,6 +91,49 @@
 #define NI_OK		0
 #define NI_ERROR	1
 
+/* Size of a cache line on the target, used to align and pad the model arena */
+#ifndef NI_CACHE_LINE_SIZE
+	#define NI_CACHE_LINE_SIZE 64
+#endif
+
+/* NI_CACHE_ALIGNED
+ * Aligns a struct type or a struct member to the start of a cache line */
+#ifdef _MSC_VER
+	#define NI_CACHE_ALIGNED __declspec(align(NI_CACHE_LINE_SIZE))
+#else
+	#define NI_CACHE_ALIGNED __attribute__ ((aligned(NI_CACHE_LINE_SIZE)))
+#endif
+
+/* Atomic operations and spin-wait hint used by the lock-free parts of the framework.
+ * Loads have acquire and stores release semantics, NI_AtomicAdd32 returns the previous value,
+ * NI_AtomicCAS64 returns non-zero if *p was equal to expected and has been set to desired,
+ * NI_MemoryFence orders all loads and stores before it against all after it. */
+#ifdef _MSC_VER
+	#define NI_AtomicLoad32(p)						InterlockedCompareExchange((volatile LONG *)(p), 0, 0)
+	#define NI_AtomicStore32(p, v)					InterlockedExchange((volatile LONG *)(p), (LONG)(v))
+	#define NI_AtomicAdd32(p, v)					InterlockedExchangeAdd((volatile LONG *)(p), (LONG)(v))
+	#define NI_AtomicLoad64(p)						InterlockedCompareExchange64((volatile LONG64 *)(p), 0, 0)
+	#define NI_AtomicStore64(p, v)					InterlockedExchange64((volatile LONG64 *)(p), (LONG64)(v))
+	#define NI_AtomicCAS64(p, expected, desired)	(InterlockedCompareExchange64((volatile LONG64 *)(p), (LONG64)(desired), (LONG64)(expected)) == (LONG64)(expected))
+	#define NI_MemoryFence()						MemoryBarrier()
+	#define NI_CpuRelax()							YieldProcessor()
+#else
+	#define NI_AtomicLoad32(p)						__atomic_load_n((p), __ATOMIC_ACQUIRE)
+	#define NI_AtomicStore32(p, v)					__atomic_store_n((p), (v), __ATOMIC_RELEASE)
+	#define NI_AtomicAdd32(p, v)					__atomic_fetch_add((p), (v), __ATOMIC_ACQ_REL)
+	#define NI_AtomicLoad64(p)						__atomic_load_n((p), __ATOMIC_ACQUIRE)
+	#define NI_AtomicStore64(p, v)					__atomic_store_n((p), (v), __ATOMIC_RELEASE)
+	#define NI_AtomicCAS64(p, expected, desired)	__sync_bool_compare_and_swap((p), (expected), (desired))
+	#define NI_MemoryFence()						__atomic_thread_fence(__ATOMIC_SEQ_CST)
+	#if defined (__i386__) || defined (__x86_64__)
+		#define NI_CpuRelax()						__builtin_ia32_pause()
+	#elif defined (__arm__) || defined (__aarch64__)
+		#define NI_CpuRelax()						__asm__ __volatile__ ("yield")
+	#else
+		#define NI_CpuRelax()
+	#endif
+#endif
+
 typedef struct {
   int32_t idx;			/* not used */
   const char* name;		/* name of the external IO, e.g., "In1" */
@@ -101,9 +144,16 @@ typedef struct {
   int32_t dimY;			/* 2nd dimension size */
 } NI_ExternalIO;
 
+/* Parameter and signal names are offsets into rtStrings, where each distinct name is stored 
+   once: the distance back to the entry of its prefix up to the last '/' (a varint, 0 if it
+   has none), then the rest of the name and a NUL. The model name and block paths shared by
+   many names are stored once. The attribute tables held pointers to the names up to version
+   1 of this layout; they are in the sections .NIVS.paramlist2 and .NIVS.siglist2 since 
+   version 2, so a reader of the pointer layout does not find them instead of misreading them. */
+#define NI_NAME_LAYOUT_VERSION	2
 typedef struct {
   int32_t idx;			/* not used */
-  const char* paramname;/* name of the parameter, e.g., "Amplitude" */
+  uint32_t paramname;	/* offset of the name of the parameter in rtStrings, e.g., "sinewave/Amplitude" */
   uintptr_t addr;		/* address or offset of the parameter in the Parameters struct */
   int32_t datatype;		/* integer describing a user defined datatype. Must have a corresponding entry in GetValueByDataType and SetValueByDataType */
   int32_t width;		/* size of parameter */
@@ -114,10 +164,10 @@ typedef struct {
 
 typedef struct {
   int32_t idx;			/* not used */
-  const char* blockname;/* name of the block where the signals originates, e.g., "sinewave/sine" */
+  uint32_t blockname;	/* offset in rtStrings of the name of the block where the signals originates, e.g., "sinewave/sine" */
   int32_t portno;		/* the port number of the block */
-  const char* signalname;/* name of the signal, e.g., "Sinewave + In1" */
-  uintptr_t addr;		/* address or offset of the storage for the signal */
+  uint32_t signalname;	/* offset in rtStrings of the name of the signal, e.g., "Sinewave + In1" */
+  uintptr_t addr;		/* offset of the storage for the signal in rtModel */
   uintptr_t baseaddr;	/* not used */
   int32_t datatype;		/* integer describing a user defined datatype. Must have a corresponding entry in GetValueByDataType */
   int32_t width;		/* size of signal */
@@ -139,6 +189,94 @@ typedef struct {
   int32_t basetype;
 } ParamSizeWidth;
 
+/* Parameter set file (NIRT_SaveParameterSet, NIRT_LoadParameterSet): a header, the image
+   of the Parameters struct, a directory of the parameters and their names */
+#define NI_PARAMSET_MAGIC	"NIPS"
+#define NI_PARAMSET_VERSION	1
+
+typedef struct {
+  char magic[4];			/* NI_PARAMSET_MAGIC */
+  uint32_t version;			/* NI_PARAMSET_VERSION */
+  uint32_t layoutHash;		/* hash of the parameter layout of the model that saved the file */
+  uint32_t count;			/* number of entries in the directory */
+  uint32_t imageOffset;		/* offset of the image of the Parameters struct in the file */
+  uint32_t imageSize;		/* size of the image */
+  uint32_t directoryOffset;	/* offset of the directory in the file */
+  uint32_t fileSize;		/* size of the file */
+} NI_ParamSetHeader;
+
+typedef struct {
+  uint32_t nameOffset;		/* offset of the NUL terminated name of the parameter in the file */
+  uint32_t offset;			/* offset of the parameter in the image */
+  int32_t datatype;			/* datatype of the parameter */
+  int32_t size;				/* size of an element */
+  int32_t width;			/* number of elements */
+} NI_ParamSetEntry;
+
+/* Model metadata image (NIRT_GetModelMetadata): a header, one entry per parameter, signal,
+   external input and external output in this order, their dimensions and names. The code
+   generator emits it as static data without pointers in .NIVS.metadata, so a loader gets
+   the whole model description with one copy instead of one Get*Spec call per entry. The
+   names are a copy of rtStrings, encoded as described above, which NIRT_GetModelMetadata
+   appends to the static part: the names are not stored twice in the model. */
+#define NI_METADATA_MAGIC	"NIMD"
+#define NI_METADATA_VERSION	2
+
+typedef struct {
+  char magic[4];			/* NI_METADATA_MAGIC */
+  uint32_t version;			/* NI_METADATA_VERSION */
+  uint32_t size;			/* size of the image */
+  uint32_t nameOffset;		/* offset in the names of the name of the model, lowercase as NIRT_GetModelSpec returns it */
+  double baseRate;			/* base rate of the model */
+  uint32_t numParameters;	/* number of parameter entries */
+  uint32_t numSignals;		/* number of signal entries */
+  uint32_t numInports;		/* number of external input entries */
+  uint32_t numOutports;		/* number of external output entries */
+  uint32_t entryOffset;		/* offset of the entries in the image */
+  uint32_t dimOffset;		/* offset of the int32_t dimensions in the image */
+  uint32_t stringOffset;	/* offset of the names (rtStrings) in the image, the size of the static part */
+  uint32_t stringSize;		/* size of the names */
+} NI_MetadataHeader;
+
+typedef struct {
+  uint32_t nameOffset;		/* offset of the name in the names (paramname, blockname, IO name) */
+  uint32_t descOffset;		/* offset in the names of the signal name of a signal, the name otherwise */
+  uint32_t offset;			/* parameters: offset in Parameters, signals: offset in ModelArena, IO: index in inData/outData */
+  int32_t datatype;			/* datatype, as in the attribute tables */
+  int32_t width;			/* number of elements */
+  int32_t numDims;			/* number of dimensions */
+  int32_t dimListOffset;	/* offset into the dimensions */
+  int32_t reserved;
+} NI_MetadataEntry;
+
+/* Shared-memory signal publication (NI_SHM_PUBLISH): the segment holds a header, a directory 
+   of the signals and outports, their names and the data, which the model rewrites every step 
+   under the sequence lock of the header. See ni_shmreader.h for the reader side. */
+#define NI_SHM_MAGIC	"NISM"
+#define NI_SHM_VERSION	2
+
+typedef struct {
+  char magic[4];				/* NI_SHM_MAGIC */
+  uint32_t version;				/* NI_SHM_VERSION */
+  volatile uint32_t sequence;	/* odd while the model writes the data */
+  uint32_t count;				/* number of entries in the directory */
+  uint64_t tick;				/* base rate tick of the data */
+  double timestamp;				/* simulation time of the data */
+  uint32_t directoryOffset;		/* offset of the directory in the segment */
+  uint32_t dataOffset;			/* offset of the data in the segment */
+  uint32_t dataSize;			/* size of the data */
+  uint32_t segmentSize;			/* size of the segment */
+  int32_t owner;				/* process id of the model publishing to the segment */
+} NI_ShmHeader;
+
+typedef struct {
+  uint32_t nameOffset;			/* offset of the NUL terminated name in the segment */
+  uint32_t offset;				/* offset of the value in the data */
+  int32_t datatype;				/* datatype of the value, as in rtSignalAttribs */
+  int32_t width;				/* number of elements */
+  int32_t size;					/* size of an element in bytes */
+} NI_ShmSignal;
+
 typedef struct {
 	uint32_t major;
 	uint32_t minor;
@@ -148,12 +286,48 @@ typedef struct {
 
 extern NI_Version NIVS_APIversion;
 
+typedef struct {
+  int32_t stopExecutionFlag;
+  const char *errmsg;
+  HANDLE flip;
+  uint32_t inCriticalSection;
+  int32_t SetParamTxStatus;
+  uint64_t tick;				/* base rate ticks since initialization, the authoritative model time */
+  double timestamp;				/* tick * USER_BaseRate, recomputed whenever tick changes */
+  uint32_t paramGeneration;	/* incremented whenever the read side parameters change */
+  uint32_t probeGeneration;	/* incremented whenever the watched signals change */
+} NI_System;
+
+/* A subsystem is a function of the model step that can run concurrently with the 
+   subsystems it does not depend on. Entries are padded to a cache line each, as 
+   "done" is written by the worker that ran the subsystem. */
+typedef struct NI_CACHE_ALIGNED {
+  void (*fn)(double timestamp);	/* subsystem function */
+  const char* name;				/* name of the subsystem */
+  int32_t numDeps;				/* number of subsystems that must complete first */
+  int32_t depListOffset;		/* offset into the dependency list */
+  int32_t optional;				/* 1 if the subsystem is shed when the step runs out of time */
+  volatile int64_t done;		/* step generation in which the subsystem last completed */
+  double cost;					/* running estimate of the execution time of an optional subsystem (s) */
+} NI_Subsystem;
+
+/* A state whose convergence, together with unchanged inputs and parameters, means the model is quiescent */
+typedef struct {
+  void* addr;			/* address of the state */
+  int32_t datatype;		/* user defined datatype of the state */
+  double tolerance;		/* largest distance from the anchor for which the state counts as converged */
+  double anchor;		/* value of the state when it was last found moving */
+} NI_SteadyState;
+
 /* Definition of user defined function for getting values of user defined types */
 double USER_GetValueByDataType(void* ptr, int32_t subindex, int32_t type);
 
 /* Definition of user defined function for setting values of user defined types */
 int32_t USER_SetValueByDataType(void* ptr, int32_t subindex, double value, int32_t type);
 
+/* Definition of user defined function for getting the size of an element of user defined types, 0 if unknown */
+int32_t USER_DataTypeSize(int32_t type);
+
 /* Definition of user defined function for initializing the model. */
 int32_t USER_Initialize(void);
 
@@ -166,6 +340,54 @@ int32_t USER_TakeOneStep(double *inData, double *outData, double timestamp);
 /* Definition of user defined function for doing work after model execution has stopped */
 int32_t USER_Finalize(void);
 
+/* Definition of user defined function for touching every model buffer so its pages are mapped before execution starts */
+int32_t USER_PrefaultMemory(void);
+
+/* Definition of user defined function for writing the current outport values to outData, used when a step is skipped */
+int32_t USER_PublishOutputs(double *outData);
+
+/* Runs the subsystems of the model, on the worker pool when the model has one. Called from USER_TakeOneStep. */
+int32_t NI_RunSubsystems(double timestamp);
+
+/* Create, resume and destroy the sequence coroutine of a model with a "Sequence" (ni_sequence.hpp) */
+int32_t NI_StartSequence(void);
+int32_t NI_ResumeSequence(void);
+void NI_StopSequence(void);
+
+/* Writes every page of a buffer in place, so the pages are mapped (and locked under mlockall) before use */
+void NI_TouchMemory(void* ptr, size_t size);
+
+/* Monotonic time in seconds */
+double NI_Now(void);
+
+/* Sets the error (isError, stops the model) or warning message returned by NIRT_ModelError */
+void SetErrorMessage(char *ErrMsg, int32_t isError);
+
+/* Discretization methods of NI_Discretize */
+#define NI_ZOH		0
+#define NI_TUSTIN	1
+
+/* Number of doubles of the work buffer of NI_Discretize */
+#define NI_DISCRETIZE_WORK(n, m)	(6 * ((n) + (m)) * ((n) + (m)))
+
+/* State-space realization of a transfer function, for NI_Discretize */
+int32_t NI_TransferFunction(int32_t n, const double *num, const double *den, double *A, double *B, double *C, double *D);
+
+/* Discretizes a continuous state-space system with zero-order hold or the bilinear transform. 
+   Used by the generated "LTI" blocks when their parameters change. */
+int32_t NI_Discretize(int32_t n, int32_t m, int32_t p, const double *A, const double *B, const double *C, const double *D,
+					  double T, int32_t method, double *Ad, double *Bd, double *Cd, double *Dd, double *work);
+
+/* Checks if optional work expected to take cost seconds still fits before the step deadline.
+   Once optional work is shed, the rest of the step's optional work is shed too. Returns 1 to run it. */
+int32_t NI_RunOptional(double cost);
+
+/* Runs an optional function of the step unless it is shed, cost is its running cost estimate. Returns 1 if it ran. */
+int32_t NI_RunOptionalSubsystem(void (*fn)(double timestamp), double* cost, double timestamp);
+
+/* Moves the model time to the given base rate tick. The caller must hold the flip semaphore. */
+void NI_SetModelTick(uint64_t tick);
+
  /*========================================================================*
  * Function: NIRT_GetModelFrameworkVersion
  *
@@ -194,6 +416,19 @@ DLL_EXPORT int32_t NIRT_GetModelFrameworkVersion(uint32_t* major, uint32_t* mino
  *========================================================================*/
 DLL_EXPORT int32_t NIRT_ModelStart(void);
 
+ /*========================================================================*
+ * Function: NIRT_PrefaultMemory
+ *
+ * Abstract:
+ *	Touches every page of the model arena (parameter buffers, IO, signals and framework
+ *	state) and of any additional user buffers. Called by a real-time host after mlockall and before 
+ *	NIRT_ModelStart, so no page faults occur while the model is executing.
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_PrefaultMemory(void);
+
  /*========================================================================*
  * Function: NIRT_InitializeModel
  *
@@ -218,7 +453,10 @@ DLL_EXPORT int32_t NIRT_InitializeModel(double finaltime, double *outTimeStep, i
  * Function: NIRT_PostOutputs
  *
  * Abstract:
- *		Pushes outport data out to LabVIEW for Multi-rate models.
+ *		Publishes the outports and signals of the step that was just computed and pushes 
+ *		outport data out to LabVIEW. Call it from the model thread after NIRT_Schedule. 
+ *		Once a model has published its outputs, NIRT_ProbeSignals reads the last published 
+ *		frame instead of the live values and may be called from any thread at any time.
  *
  * Output Parameters:
  *		outData: preallocated array of model outputs
@@ -242,6 +480,79 @@ DLL_EXPORT int32_t NIRT_PostOutputs(double *outData);
  *========================================================================*/
 DLL_EXPORT int32_t NIRT_ModelUpdate(void);
 
+ /*========================================================================*
+ * Function: NIRT_ScheduleN
+ *
+ * Abstract:
+ *	Runs numTicks consecutive base rate ticks in one call, the equivalent of numTicks
+ *	NIRT_Schedule/NIRT_ModelUpdate pairs, for faster than real-time and test bench
+ *	use. Parameter commits wait until the call returns, so all ticks see the same 
+ *	parameters; queued parameter changes are applied at their tick as usual.
+ *	Must not be called between NIRT_Schedule and NIRT_ModelUpdate.
+ *
+ * Input Parameters: 
+ *	inData		: numTicks rows of model inputs, one row per tick, or NULL
+ *	numTicks	: number of ticks to run
+ *
+ * Output Parameters:
+ *	outData		: numTicks rows of model outputs, one row per tick, or NULL
+ *	outTime		: simulation time of the last tick computed
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if a tick failed; the ticks before it were run
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_ScheduleN(const double *inData, double *outData, int32_t numTicks, double *outTime);
+
+ /*========================================================================*
+ * Function: NIRT_GetModelMetadata
+ *
+ * Abstract:
+ *	Copies the metadata image of the model (see NI_MetadataHeader): names, types, 
+ *	dimensions and offsets of all parameters, signals and external IO.
+ *
+ * Input/Output Parameters:
+ *	size	: size of the image buffer (in), size of the image (out). 
+ *			  If image is NULL, only the size is returned.
+ *
+ * Output Parameters:
+ *	image	: buffer receiving the image
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the buffer is too small
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_GetModelMetadata(void* image, uint32_t* size);
+
+ /*========================================================================*
+ * Function: NIRT_GetModelTick
+ *
+ * Abstract:
+ *	Returns the number of base rate ticks since the model was initialized. The
+ *	simulation time is always tick * baserate, so it does not drift on long runs.
+ *
+ * Output Parameters:
+ *	tick	: current base rate tick
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_GetModelTick(uint64_t* tick);
+
+ /*========================================================================*
+ * Function: NIRT_SetModelTick
+ *
+ * Abstract:
+ *	Moves the model time to the given base rate tick, e.g. to fast-forward a run. 
+ *	The resulting simulation time is bit-identical to reaching the tick step by step.
+ *	Waits for the current step (Schedule to ModelUpdate) to complete.
+ *
+ * Input Parameters: 
+ *	tick	: new base rate tick
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_SetModelTick(uint64_t tick);
+
  /*========================================================================*
  * Function: NIRT_Schedule
  *
@@ -277,6 +588,52 @@ DLL_EXPORT int32_t NIRT_Schedule(double *inData, double *outData, double *outTim
  *========================================================================*/
 DLL_EXPORT int32_t NIRT_TaskTakeOneStep(int32_t taskid);
 
+ /*========================================================================*
+ * Function: NIRT_GetSteadyStateInfo
+ *
+ * Abstract:
+ *	Reports whether a model with steady-state detection is currently quiescent, i.e. 
+ *	skipping its equations, and how many steps it has skipped so far.
+ *
+ * Output Parameters:
+ *	steady			: 1 if the model is quiescent, 0 otherwise
+ *	skippedSteps	: number of steps skipped since the model was initialized
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the model has no steady-state detection
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_GetSteadyStateInfo(int32_t* steady, double* skippedSteps);
+
+ /*========================================================================*
+ * Function: NIRT_GetSheddingInfo
+ *
+ * Abstract:
+ *	Reports how often a model with a step deadline shed optional work to meet it.
+ *
+ * Output Parameters:
+ *	shedSteps	: number of steps in which optional work was shed
+ *	shedCount	: number of optional computations shed
+ *	stepCost	: running estimate of the step execution time (s)
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the model has no step deadline
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_GetSheddingInfo(double* shedSteps, double* shedCount, double* stepCost);
+
+ /*========================================================================*
+ * Function: NIRT_GetMemoizationInfo
+ *
+ * Abstract:
+ *	Reports how many steps a pure model has skipped by reusing its previous outputs.
+ *
+ * Output Parameters:
+ *	reusedSteps	: number of steps skipped since the model was initialized
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the model is not pure
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_GetMemoizationInfo(double* reusedSteps);
+
  /*========================================================================*
  * Function: NIRT_FinalizeModel
  *
@@ -317,6 +674,55 @@ DLL_EXPORT int32_t NIRT_FinalizeModel(void);
  *========================================================================*/
 DLL_EXPORT int32_t NIRT_ProbeSignals(int32_t *sigindices, int32_t numsigs, double *value, int32_t* num);
 
+ /*========================================================================*
+ * Function: NIRT_ProbeSignalChanges
+ *
+ * Abstract:
+ *	Returns the signals of a list that moved more than their deadband since this stream
+ *	last returned them, as (index, value) pairs, and periodically all of them (a keyframe) 
+ *	for consumers to resynchronize. Requires "ChangeOnly" in the model definition.
+ *
+ * Input Parameters: 
+ *	stream		: stream of the consumer, each consumer (thread) uses its own
+ *	sigindices	: indices of the signals, NULL for the subscribed signals (NIRT_SubscribeSignal)
+ *	numsigs		: length of sigindices
+ * 	  
+ * Input/Output Parameters
+ *	num			: (in) length of indices and values (out) number of pairs returned
+ * 	  
+ * Output Parameters: 
+ *	indices		: signal indices of the pairs
+ *	values		: signal values of the pairs
+ *	keyframe	: 1 if all signals of the list were returned, 0 if only the changes
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_ProbeSignalChanges(int32_t stream, const int32_t* sigindices, int32_t numsigs, int32_t* indices, double* values, int32_t* num, int32_t* keyframe);
+
+ /*========================================================================*
+ * Function: NIRT_ResyncSignalChanges
+ *
+ * Abstract:
+ *	Makes the next NIRT_ProbeSignalChanges call of a stream return a keyframe.
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_ResyncSignalChanges(int32_t stream);
+
+ /*========================================================================*
+ * Function: NIRT_SetSignalDeadband
+ *
+ * Abstract:
+ *	Sets the deadband of a signal (-1 for all signals) for NIRT_ProbeSignalChanges: 
+ *	0 returns every change, a negative deadband every value.
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_SetSignalDeadband(int32_t index, double deadband);
+
  /*========================================================================*
  * Function: NIRT_SetScalarParameterInline
  *
@@ -349,6 +755,121 @@ DLL_EXPORT int32_t NIRT_SetScalarParameterInline(uint32_t index,  uint32_t subin
  *========================================================================*/
 DLL_EXPORT int32_t NIRT_SetVectorParameter(uint32_t index, const double* paramvalues, uint32_t paramlength);
 
+ /*========================================================================*
+ * Function: NIRT_SetParameterBatch
+ *
+ * Abstract:
+ *	Sets many parameter values and commits them at once, with a single flip of the 
+ *	read side. The whole batch is validated and converted into a staging copy of 
+ *	the write side first: if any entry is invalid, nothing is applied. Parameters
+ *	set with NIRT_SetParameter and not yet committed are committed with the batch.
+ *
+ * Input Parameters:
+ *	indices		: indices of the parameters as returned by NIRT_GetParameterSpec()
+ *	subindices	: offsets of the elements within the parameters, NULL for scalars
+ *	values		: values to set
+ *	count		: number of entries
+ *
+ * Output Parameters:
+ *	errors		: NI_OK or NI_ERROR per entry, may be NULL
+ *
+ * Returns:
+ *	NI_OK if the batch was committed, NI_ERROR otherwise
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_SetParameterBatch(const int32_t* indices, const int32_t* subindices, const double* values, int32_t count, int32_t* errors);
+
+ /*========================================================================*
+ * Function: NIRT_SetParameterImage
+ *
+ * Abstract:
+ *	Replaces all the parameters with a contiguous image of the Parameters struct 
+ *	(e.g. saved from NIRT_GetParameterImage) and commits it with a single flip of 
+ *	the read side.
+ *
+ * Input Parameters:
+ *	image	: image of the Parameters struct
+ *	size	: size of the image, must be the size of the Parameters struct
+ *
+ * Returns:
+ *	NI_OK if the image was committed, NI_ERROR otherwise
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_SetParameterImage(const void* image, uint32_t size);
+
+ /*========================================================================*
+ * Function: NIRT_GetParameterImage
+ *
+ * Abstract:
+ *	Copies the read side parameters, as a contiguous image of the Parameters struct.
+ *
+ * Input/Output Parameters:
+ *	size	: size of the image buffer (in), size of the Parameters struct (out). 
+ *			  If image is NULL, only the size is returned.
+ *
+ * Output Parameters:
+ *	image	: buffer receiving the image
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the buffer is too small
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_GetParameterImage(void* image, uint32_t* size);
+
+ /*========================================================================*
+ * Function: NIRT_LoadParameterSet
+ *
+ * Abstract:
+ *	Loads a parameter set file saved by NIRT_SaveParameterSet and commits it with a 
+ *	single flip of the read side. The file is memory-mapped where the target supports it.
+ *	If it was saved from the same parameter layout (same layout hash), its image is 
+ *	copied as a whole; otherwise its parameters are matched by name, and those missing
+ *	from the model or of a different width are left out.
+ *
+ * Input Parameters:
+ *	path		: path of the file
+ *
+ * Output Parameters:
+ *	unmatched	: number of parameters of the file left out, may be NULL
+ *
+ * Returns:
+ *	NI_OK if the parameter set was committed, NI_ERROR otherwise
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_LoadParameterSet(const char* path, int32_t* unmatched);
+
+ /*========================================================================*
+ * Function: NIRT_SaveParameterSet
+ *
+ * Abstract:
+ *	Saves a snapshot of the read side parameters to a parameter set file.
+ *
+ * Input Parameters:
+ *	path	: path of the file
+ *
+ * Returns:
+ *	NI_OK if no error
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_SaveParameterSet(const char* path);
+
+ /*========================================================================*
+ * Function: NIRT_QueueParameter
+ *
+ * Abstract:
+ *	Queues a parameter change to take effect at a given simulation time: it is applied
+ *	by NIRT_Schedule at the first step whose time is not earlier than the requested one
+ *	(within half a base rate), before the model computes that step. Changes due at the
+ *	same step are applied in the order they were queued. Can be called from any thread,
+ *	it never blocks and never blocks the step (requires "ParameterQueue" in the model
+ *	definition).
+ *
+ * Input Parameters:
+ *	timestamp	: simulation time at which the change takes effect
+ *	index		: index of the parameter as returned by NIRT_GetParameterSpec()
+ *	subindex	: offset of the element within the parameter
+ *	value		: value to set the parameter to
+ *
+ * Returns:
+ *	NI_OK if queued, NI_ERROR if the parameter is out of bounds or the queue is full
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_QueueParameter(double timestamp, int32_t index, int32_t subindex, double value);
+
  /*========================================================================*
  * Function: NIRT_SetParameter
  *
@@ -443,8 +964,14 @@ DLL_EXPORT int32_t NIRT_TaskRunTimeInfo(int32_t halt, int32_t* overruns, int32_t
  * Function: NIRT_GetSimState
  *
  * Abstract:
+ *	Returns the states of the model, counts only if a count is negative. The names
+ *	of the states of a kind are NI_SIMSTATE_NAME_SIZE characters apart. The clock
+ *	ticks are the low and high words of the 64 bit base rate tick (clockTick0,
+ *	clockTick1), only the low word if the caller passes *numClockTicks = 1.
  *
  *========================================================================*/
+#define NI_SIMSTATE_NAME_SIZE	100
+
 DLL_EXPORT int32_t NIRT_GetSimState(int32_t* numContStates, char* contStatesNames, double* contStates, int32_t* numDiscStates, 
 								char* discStatesNames, double* discStates, int32_t* numClockTicks, char* clockTicksNames, int32_t* clockTicks);
 
@@ -452,6 +979,8 @@ DLL_EXPORT int32_t NIRT_GetSimState(int32_t* numContStates, char* contStatesName
  * Function: NIRT_SetSimState
  *
  * Abstract:
+ *	Restores states returned by NIRT_GetSimState, the tick from as many clock
+ *	tick words as NIRT_GetSimState returned.
  *
  *========================================================================*/
 DLL_EXPORT int32_t NIRT_SetSimState(double* contStates, double* discStates, int32_t* clockTicks);
@@ -558,6 +1087,23 @@ DLL_EXPORT int32_t NIRT_GetParameterIndices(int32_t* indices, int32_t* len);
 DLL_EXPORT int32_t NIRT_GetParameterSpec(int32_t* paramidx, char* ID, int32_t* ID_len, char* paramname, int32_t *pnlen, 
 									  int32_t *datatype, int32_t* dims, int32_t* numdim);
 
+ /*========================================================================*
+ * Function: NIRT_SubscribeSignal
+ *
+ * Abstract:
+ *	Keeps a signal watched (see IS_PROBED) regardless of the NIRT_ProbeSignals lists, 
+ *	e.g. for logging. Call it after NIRT_InitializeModel, from the thread running the
+ *	model or while it is stopped.
+ *
+ * Input Parameters: 
+ *	index		: index of the signal, -1 for all signals
+ *	subscribe	: 1 to subscribe, 0 to unsubscribe
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the index is out of bounds
+ *========================================================================*/
+DLL_EXPORT int32_t NIRT_SubscribeSignal(int32_t index, int32_t subscribe);
+
  /*========================================================================*
  * Function: NIRT_GetSignalSpec
  *
@@ -0,0 +1,188 @@
+/*========================================================================*
+ * NI VeriStand Model Framework
+ * Shared-memory signal monitor
+ *
+ * Abstract:
+ *      Samples the signals a model built with "SharedMemory" publishes, from any
+ *      number of reader threads, each with its own mapping as a separate process
+ *      would have. At the end it prints the last values and the read throughput,
+ *      which shows what many monitors cost: nothing on the model side, the model
+ *      never waits for a reader.
+ *
+ *      Usage: monitor [-r readers] [-t seconds] segment [signal ...]
+ *        -r readers : number of reader threads (default: 1)
+ *        -t seconds : sampling time (default: 1)
+ *        segment    : name of the shared memory segment, e.g. /ni_sinewave
+ *        signal     : names of the signals to read (default: all)
+ *
+ *========================================================================*/
+
+#include "ni_shmreader.h"
+#include <pthread.h>
+#include <unistd.h>
+
+#define NSEC_PER_SEC	1000000000LL
+
+typedef struct {
+	pthread_t thread;
+	NI_ShmReader reader;
+	const int32_t *indices;
+	int32_t count;
+	double *values;
+	int32_t len;			/* number of values of the signals */
+	uint64_t tick;			/* tick of the last read */
+	double ticksSeen;		/* number of different steps read */
+	double backwards;		/* reads older than the previous one, must stay 0 */
+	int32_t error;
+} MonitorReader;
+
+static volatile int32_t stopReaders = 0;
+
+static int64_t NowNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static void *ReaderThread(void *arg)
+{
+	MonitorReader *r = (MonitorReader *)arg;
+	uint64_t tick;
+	int32_t len;
+
+	while (!NI_AtomicLoad32(&stopReaders))
+	{
+		len = r->len;
+		if (NI_ShmRead(&r->reader, r->indices, r->count, r->values, &len, &tick, NULL) != NI_OK)
+		{
+			r->error = 1;
+			break;
+		}
+
+		if ((r->reader.reads > 1) && (tick < r->tick))
+		{
+			r->backwards++;
+		}
+		if ((r->reader.reads == 1) || (tick != r->tick))
+		{
+			r->ticksSeen++;
+		}
+		r->tick = tick;
+	}
+
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	NI_ShmReader directory;
+	MonitorReader *readers;
+	int32_t *indices;
+	int32_t numReaders = 1, count = 0, len = 0, i, j, k;
+	double seconds = 1.0, reads = 0.0, retries = 0.0;
+	int64_t start, elapsed;
+	int c;
+
+	while ((c = getopt(argc, argv, "r:t:")) != -1)
+	{
+		switch (c)
+		{
+			case 'r': numReaders = atoi(optarg); break;
+			case 't': seconds = atof(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-r readers] [-t seconds] segment [signal ...]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if ((optind >= argc) || (numReaders < 1))
+	{
+		fprintf(stderr, "Usage: %s [-r readers] [-t seconds] segment [signal ...]\n", argv[0]);
+		return 1;
+	}
+
+	if (NI_ShmOpen(&directory, argv[optind]) != NI_OK)
+	{
+		fprintf(stderr, "Cannot open the shared memory segment %s, is the model running?\n", argv[optind]);
+		return 1;
+	}
+
+	/* Signals to read: the ones named on the command line, or all */
+	indices = (int32_t *)calloc((size_t)NI_ShmSignalCount(&directory) + (size_t)argc, sizeof(int32_t));
+	for (i = optind + 1; i < argc; i++)
+	{
+		indices[count] = NI_ShmFindSignal(&directory, argv[i]);
+		if (indices[count] < 0)
+		{
+			fprintf(stderr, "Unknown signal %s.\n", argv[i]);
+			return 1;
+		}
+		count++;
+	}
+	for (i = 0; (optind + 1 >= argc) && (i < NI_ShmSignalCount(&directory)); i++)
+	{
+		indices[count++] = i;
+	}
+	for (j = 0; j < count; j++)
+	{
+		len += NI_ShmSignalWidth(&directory, indices[j]);
+	}
+
+	readers = (MonitorReader *)calloc((size_t)numReaders, sizeof(MonitorReader));
+	for (i = 0; i < numReaders; i++)
+	{
+		readers[i].indices = indices;
+		readers[i].count = count;
+		readers[i].len = len;
+		readers[i].values = (double *)calloc((size_t)len + 1, sizeof(double));
+		if (NI_ShmOpen(&readers[i].reader, argv[optind]) != NI_OK)
+		{
+			fprintf(stderr, "Cannot open the shared memory segment %s.\n", argv[optind]);
+			return 1;
+		}
+	}
+
+	start = NowNs();
+	for (i = 0; i < numReaders; i++)
+	{
+		pthread_create(&readers[i].thread, NULL, ReaderThread, &readers[i]);
+	}
+
+	usleep((useconds_t)(seconds * 1e6));
+	NI_AtomicStore32(&stopReaders, 1);
+
+	for (i = 0; i < numReaders; i++)
+	{
+		pthread_join(readers[i].thread, NULL);
+	}
+	elapsed = NowNs() - start;
+
+	printf("tick %llu\n", (unsigned long long)readers[0].tick);
+	for (j = 0, k = 0; j < count; j++)
+	{
+		printf("  %-32s", NI_ShmSignalName(&directory, indices[j]));
+		for (i = 0; i < NI_ShmSignalWidth(&directory, indices[j]); i++)
+		{
+			printf(" %.17g", readers[0].values[k++]);
+		}
+		printf("\n");
+	}
+
+	printf("\n*******************************************************************************\n");
+	for (i = 0; i < numReaders; i++)
+	{
+		printf("reader %3d: %12.0f reads  %10.0f retries  %10.0f steps seen  %s\n", i, readers[i].reader.reads,
+			readers[i].reader.retries, readers[i].ticksSeen, (readers[i].error || readers[i].backwards) ? "FAILED" : "ok");
+		reads += readers[i].reader.reads;
+		retries += readers[i].reader.retries;
+		NI_ShmClose(&readers[i].reader);
+	}
+	printf("total: %d readers, %d signals, %.0f reads/s, %.0f ns per read, %.3f%% retried\n", numReaders, count,
+		reads * NSEC_PER_SEC / (double)elapsed, (double)elapsed * numReaders / (reads > 0 ? reads : 1),
+		100.0 * retries / (reads > 0 ? reads : 1));
+	printf("*******************************************************************************\n");
+
+	NI_ShmClose(&directory);
+	return 0;
+}
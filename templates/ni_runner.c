@@ -0,0 +1,359 @@
+/*========================================================================*
+ * NI VeriStand Model Framework
+ * Linux host runner
+ *
+ * Abstract:
+ *      Drives a generated model on a plain Linux host the way the VeriStand
+ *      engine does: NIRT_InitializeModel, NIRT_ModelStart, then one
+ *      NIRT_Schedule/NIRT_ModelUpdate pair per base rate tick.
+ *
+ *      The step thread runs with a real-time profile to keep jitter low:
+ *        - pinned to a single (ideally isolated) CPU
+ *        - scheduled under SCHED_FIFO
+ *        - all memory locked with mlockall and every model buffer prefaulted
+ *          before NIRT_ModelStart
+ *        - ticks paced on absolute deadlines with clock_nanosleep(TIMER_ABSTIME),
+ *          optionally finished with a busy-wait tail
+ *
+ *      At the end of the run a jitter report is printed to stdout.
+ *
+ *      Usage: runner [-c cpu] [-p priority] [-n ticks] [-s spin_us] [-o file]
+ *        -c cpu      : CPU to pin the step thread to (default: no pinning)
+ *        -p priority : SCHED_FIFO priority, 0 keeps SCHED_OTHER (default: 80)
+ *        -n ticks    : number of base rate ticks to run (default: 1000)
+ *        -s spin_us  : busy-wait tail before each deadline in us (default: 0)
+ *        -o file     : write the raw per-tick samples as CSV to file
+ *
+ *========================================================================*/
+
+#ifndef _GNU_SOURCE
+	#define _GNU_SOURCE
+#endif
+
+#include "ni_modelframework.h"
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define NSEC_PER_SEC	1000000000LL
+
+/* Size of the stack region touched before the run to avoid stack page faults */
+#define PREFAULT_STACK_SIZE	(256 * 1024)
+
+typedef struct {
+	int32_t cpu;
+	int32_t priority;
+	int64_t ticks;
+	int64_t spinNs;
+	const char *csvFile;
+} RunnerOptions;
+
+typedef struct {
+	int64_t *lateness;	/* wake-up time minus deadline, per tick (ns) */
+	int64_t *execTime;	/* time spent in Schedule + ModelUpdate, per tick (ns) */
+	int64_t overruns;	/* ticks whose step finished after the next deadline */
+} RunnerSamples;
+
+static int64_t TimespecToNs(const struct timespec *ts)
+{
+	return (int64_t)ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+}
+
+static void NsToTimespec(int64_t ns, struct timespec *ts)
+{
+	ts->tv_sec = (time_t)(ns / NSEC_PER_SEC);
+	ts->tv_nsec = (long)(ns % NSEC_PER_SEC);
+}
+
+static int64_t NowNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return TimespecToNs(&ts);
+}
+
+ /*========================================================================*
+ * Function: PrefaultStack
+ *
+ * Abstract:
+ *	Touches a region of the stack so that it is mapped (and locked) before the run.
+ *
+ * Returns:
+ *	a byte of the region, read back so that the writes are not optimized out
+ ========================================================================*/
+static int32_t PrefaultStack(void)
+{
+	volatile unsigned char stack[PREFAULT_STACK_SIZE];
+	int32_t i;
+
+	for (i = 0; i < PREFAULT_STACK_SIZE; i += 4096)
+	{
+		stack[i] = 0;
+	}
+	return stack[0];
+}
+
+ /*========================================================================*
+ * Function: SetRealtimeProfile
+ *
+ * Abstract:
+ *	Pins the calling thread, switches it to SCHED_FIFO and locks all memory.
+ *	Failures are reported as warnings; the run continues without that setting.
+ ========================================================================*/
+static void SetRealtimeProfile(const RunnerOptions *opts)
+{
+	if (opts->cpu >= 0)
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(opts->cpu, &set);
+
+		if (sched_setaffinity(0, sizeof(set), &set) != 0)
+		{
+			perror("Warning: sched_setaffinity");
+		}
+	}
+
+	if (opts->priority > 0)
+	{
+		struct sched_param param;
+		memset(&param, 0, sizeof(param));
+		param.sched_priority = opts->priority;
+
+		if (sched_setscheduler(0, SCHED_FIFO, &param) != 0)
+		{
+			perror("Warning: sched_setscheduler(SCHED_FIFO)");
+		}
+	}
+
+	if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+	{
+		perror("Warning: mlockall");
+	}
+
+	(void)PrefaultStack();
+}
+
+ /*========================================================================*
+ * Function: WaitUntil
+ *
+ * Abstract:
+ *	Sleeps until the absolute deadline. When spinNs is set, sleeps until
+ *	spinNs before the deadline and busy-waits the rest.
+ *
+ * Returns:
+ *	the wake-up time (ns)
+ ========================================================================*/
+static int64_t WaitUntil(int64_t deadline, int64_t spinNs)
+{
+	struct timespec ts;
+	int64_t now;
+
+	NsToTimespec(deadline - spinNs, &ts);
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+	{
+		/* interrupted by a signal, sleep again */
+	}
+
+	now = NowNs();
+	while (now < deadline)
+	{
+		now = NowNs();
+	}
+
+	return now;
+}
+
+static int CompareInt64(const void *a, const void *b)
+{
+	int64_t x = *(const int64_t *)a;
+	int64_t y = *(const int64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+ /*========================================================================*
+ * Function: PrintJitterReport
+ *
+ * Abstract:
+ *	Prints min/avg/max and percentiles of the wake-up lateness and the step time.
+ ========================================================================*/
+static void PrintJitterReport(const RunnerOptions *opts, RunnerSamples *samples, int64_t ticks, int64_t period)
+{
+	const char *names[2] = {"lateness", "step"};
+	int64_t *series[2];
+	int32_t s;
+
+	series[0] = samples->lateness;
+	series[1] = samples->execTime;
+
+	if (opts->csvFile != NULL)
+	{
+		FILE *fp = fopen(opts->csvFile, "w");
+		int64_t i;
+
+		if (fp != NULL)
+		{
+			fprintf(fp, "tick,lateness_ns,step_ns\n");
+			for (i = 0; i < ticks; i++)
+			{
+				fprintf(fp, "%lld,%lld,%lld\n", (long long)i, (long long)samples->lateness[i], (long long)samples->execTime[i]);
+			}
+			fclose(fp);
+		}
+		else
+		{
+			perror("Warning: cannot write samples");
+		}
+	}
+
+	printf("\n*******************************************************************************\n");
+	printf("Jitter report: %lld ticks, period %lld ns, cpu %d, priority %d, spin %lld ns\n",
+		(long long)ticks, (long long)period, opts->cpu, opts->priority, (long long)opts->spinNs);
+
+	for (s = 0; s < 2 && ticks > 0; s++)
+	{
+		int64_t *v = series[s];
+		double sum = 0.0;
+		int64_t i;
+
+		for (i = 0; i < ticks; i++)
+		{
+			sum += (double)v[i];
+		}
+
+		/* sorting is done after the run, the samples are not needed in order anymore */
+		qsort(v, (size_t)ticks, sizeof(int64_t), CompareInt64);
+
+		printf("%-9s(ns): min %8lld  avg %10.1f  p50 %8lld  p99 %8lld  p99.9 %8lld  max %8lld\n", names[s],
+			(long long)v[0], sum / (double)ticks, (long long)v[ticks / 2],
+			(long long)v[(ticks * 99) / 100], (long long)v[(ticks * 999) / 1000], (long long)v[ticks - 1]);
+	}
+
+	printf("overruns: %lld\n", (long long)samples->overruns);
+	printf("*******************************************************************************\n");
+}
+
+static void ParseOptions(int argc, char **argv, RunnerOptions *opts)
+{
+	int c;
+
+	opts->cpu = -1;
+	opts->priority = 80;
+	opts->ticks = 1000;
+	opts->spinNs = 0;
+	opts->csvFile = NULL;
+
+	while ((c = getopt(argc, argv, "c:p:n:s:o:")) != -1)
+	{
+		switch (c)
+		{
+			case 'c': opts->cpu = atoi(optarg); break;
+			case 'p': opts->priority = atoi(optarg); break;
+			case 'n': opts->ticks = atoll(optarg); break;
+			case 's': opts->spinNs = atoll(optarg) * 1000; break;
+			case 'o': opts->csvFile = optarg; break;
+			default:
+				fprintf(stderr, "Usage: %s [-c cpu] [-p priority] [-n ticks] [-s spin_us] [-o file]\n", argv[0]);
+				exit(1);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	RunnerOptions opts;
+	RunnerSamples samples;
+	double baseRate = 0.0, simTime = 0.0;
+	int32_t numIn = 0, numOut = 0, numTasks = 0;
+	double *inData = NULL, *outData = NULL;
+	int64_t period, deadline, start, end, tick;
+	int32_t retval = NI_OK;
+
+	ParseOptions(argc, argv, &opts);
+
+	if (NIRT_InitializeModel((double)opts.ticks, &baseRate, &numIn, &numOut, &numTasks) != NI_OK)
+	{
+		fprintf(stderr, "Model initialization failed.\n");
+		return 1;
+	}
+
+	period = (int64_t)(baseRate * (double)NSEC_PER_SEC + 0.5);
+	if (period <= 0)
+	{
+		fprintf(stderr, "Invalid base rate %g.\n", baseRate);
+		return 1;
+	}
+
+	/* Allocate everything the loop touches before locking memory */
+	inData = (double *)calloc((size_t)numIn + 1, sizeof(double));
+	outData = (double *)calloc((size_t)numOut + 1, sizeof(double));
+	samples.lateness = (int64_t *)calloc((size_t)opts.ticks + 1, sizeof(int64_t));
+	samples.execTime = (int64_t *)calloc((size_t)opts.ticks + 1, sizeof(int64_t));
+	samples.overruns = 0;
+
+	if (!inData || !outData || !samples.lateness || !samples.execTime)
+	{
+		fprintf(stderr, "Out of memory.\n");
+		return 1;
+	}
+
+	SetRealtimeProfile(&opts);
+
+	/* Lock and fault in all model buffers and the sample buffers before the first tick */
+	NIRT_PrefaultMemory();
+	memset(samples.lateness, 0, (size_t)opts.ticks * sizeof(int64_t));
+	memset(samples.execTime, 0, (size_t)opts.ticks * sizeof(int64_t));
+
+	if (NIRT_ModelStart() != NI_OK)
+	{
+		fprintf(stderr, "Model start failed.\n");
+		return 1;
+	}
+
+	deadline = NowNs() + period;
+	for (tick = 0; tick < opts.ticks; tick++)
+	{
+		start = WaitUntil(deadline, opts.spinNs);
+
+		retval = NIRT_Schedule(inData, outData, &simTime, NULL);
+		NIRT_ModelUpdate();
+
+		end = NowNs();
+		samples.lateness[tick] = start - deadline;
+		samples.execTime[tick] = end - start;
+
+		if (retval != NI_OK)
+		{
+			tick++;
+			break;
+		}
+
+		/* Keep the absolute schedule on overrun, the next tick simply starts late */
+		deadline += period;
+		if (end > deadline)
+		{
+			samples.overruns++;
+		}
+	}
+
+	if (retval != NI_OK)
+	{
+		char msg[256];
+		int32_t msglen = sizeof(msg) - 1;
+
+		NIRT_ModelError(msg, &msglen);
+		msg[msglen > 0 ? msglen : 0] = 0;
+		fprintf(stderr, "Model stopped at t=%g: %s\n", simTime, msg);
+	}
+
+	PrintJitterReport(&opts, &samples, tick, period);
+	NIRT_FinalizeModel();
+
+	free(inData);
+	free(outData);
+	free(samples.lateness);
+	free(samples.execTime);
+
+	return retval == NI_OK ? 0 : 1;
+}
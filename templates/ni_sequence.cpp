@@ -0,0 +1,109 @@
+/*========================================================================*
+ * NI VeriStand Model Framework
+ * Model sequences
+ *
+ * Abstract:
+ *      Runs the sequence coroutine of the model, see ni_sequence.hpp.
+ *
+ *========================================================================*/
+
+#include "ni_sequence.hpp"
+#include <stdio.h>
+
+typedef std::coroutine_handle<NI_Sequence::promise_type> NI_SequenceHandle;
+
+void *NI_Sequence::promise_type::operator new(size_t size) noexcept
+{
+	/* one frame at a time, the sequence cannot call another coroutine */
+	rtModel.sequence.frameSize = (uint32_t)size;
+	if ((size > sizeof(rtModel.sequence.frame)) || (rtModel.sequence.handle != NULL))
+	{
+		return NULL;
+	}
+	return rtModel.sequence.frame;
+}
+
+void NI_Sequence::promise_type::operator delete(void *frame) noexcept
+{
+	UNUSED_PARAMETER(frame);
+}
+
+void NI_Sequence::promise_type::unhandled_exception() noexcept
+{
+	rtModel.sequence.status = NI_ERROR;
+}
+
+ /*========================================================================*
+ * Function: NI_StartSequence
+ *
+ * Abstract:
+ *	Creates the sequence coroutine in the arena, replacing the one of the last run.
+ *	It first runs on tick 0.
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the frame does not fit into NI_SEQUENCE_FRAME_SIZE
+========================================================================*/
+int32_t NI_StartSequence(void)
+{
+	static char message[128];
+
+	NI_StopSequence();
+	rtModel.sequence.status = NI_OK;
+
+	NI_Sequence sequence = USER_Sequence();
+	if (!sequence.handle)
+	{
+		sprintf(message, "The sequence frame needs %u bytes, more than NI_SEQUENCE_FRAME_SIZE (%u).",
+			rtModel.sequence.frameSize, (uint32_t)sizeof(rtModel.sequence.frame));
+		SetErrorMessage(message, 1);
+		return NI_ERROR;
+	}
+
+	rtModel.sequence.handle = sequence.handle.address();
+	rtModel.sequence.wakeTick = 0;
+	return NI_OK;
+}
+
+ /*========================================================================*
+ * Function: NI_ResumeSequence
+ *
+ * Abstract:
+ *	Resumes the sequence until it awaits the next time. A sequence that finished, or
+ *	that an exception escaped, is not resumed again.
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if an exception escaped the sequence
+========================================================================*/
+int32_t NI_ResumeSequence(void)
+{
+	NI_SequenceHandle handle = NI_SequenceHandle::from_address(rtModel.sequence.handle);
+
+	handle.resume();
+	if (handle.done())
+	{
+		rtModel.sequence.wakeTick = UINT64_MAX;
+	}
+
+	if (rtModel.sequence.status != NI_OK)
+	{
+		SetErrorMessage((char *)"An exception escaped the sequence.", 1);
+		return NI_ERROR;
+	}
+	return NI_OK;
+}
+
+ /*========================================================================*
+ * Function: NI_StopSequence
+ *
+ * Abstract:
+ *	Destroys the sequence coroutine, running the destructors of its locals.
+========================================================================*/
+void NI_StopSequence(void)
+{
+	if (rtModel.sequence.handle != NULL)
+	{
+		NI_SequenceHandle::from_address(rtModel.sequence.handle).destroy();
+		rtModel.sequence.handle = NULL;
+	}
+	rtModel.sequence.wakeTick = UINT64_MAX;
+}
@@ -0,0 +1,85 @@
+/*========================================================================*
+ * NI VeriStand Model Framework
+ * Model sequences
+ *
+ * Abstract:
+ *      Sequential logic (power-up sequences, fault timers, staged starts) written
+ *      as a C++20 coroutine instead of a state machine in USER_TakeOneStep:
+ *
+ *      	NI_Sequence USER_Sequence()
+ *      	{
+ *      		rtSignal.relay = 1.0;
+ *      		co_await wait_for(0.2);
+ *      		rtSignal.starter = 1.0;
+ *      		while (rtSignal.RPM < readParam.crankRPM)
+ *      			co_await next_tick();
+ *      		...
+ *      	}
+ *
+ *      The framework creates the coroutine in NIRT_InitializeModel and resumes it
+ *      once per tick from NIRT_Schedule, before USER_TakeOneStep, when the tick it
+ *      waits for has come. The coroutine frame lives in the model arena
+ *      (rtModel.sequence, NI_SEQUENCE_FRAME_SIZE bytes), never on the heap, so
+ *      running the sequence does not allocate. A frame larger than the arena space
+ *      fails NIRT_InitializeModel with the size needed. The sequence only awaits
+ *      next_tick() and wait_for(); it cannot await another coroutine.
+ *
+ *========================================================================*/
+
+#ifndef NI_SEQUENCE_HPP
+#define NI_SEQUENCE_HPP
+
+extern "C" {
+#include "ni_modelframework.h"
+#include "model.h"
+
+extern double USER_BaseRate;
+}
+
+#include <coroutine>
+#include <math.h>
+
+struct NI_Sequence {
+	struct promise_type {
+		/* the frame is placed in rtModel.sequence.frame */
+		static void *operator new(size_t size) noexcept;
+		static void operator delete(void *frame) noexcept;
+		static NI_Sequence get_return_object_on_allocation_failure() noexcept { return NI_Sequence(nullptr); }
+
+		NI_Sequence get_return_object() noexcept { return NI_Sequence(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_always final_suspend() noexcept { return {}; }
+		void return_void() noexcept {}
+		void unhandled_exception() noexcept;
+	};
+
+	explicit NI_Sequence(std::coroutine_handle<promise_type> h) noexcept : handle(h) {}
+
+	std::coroutine_handle<promise_type> handle;
+};
+
+/* Suspends the sequence for a number of base rate ticks, at least one */
+struct NI_WaitTicks {
+	uint64_t ticks;
+
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<>) const noexcept { rtModel.sequence.wakeTick = NI_TICK + ((ticks > 0) ? ticks : 1); }
+	void await_resume() const noexcept {}
+};
+
+/* Resumes the sequence on the next tick */
+inline NI_WaitTicks next_tick() noexcept
+{
+	return NI_WaitTicks{ 1 };
+}
+
+/* Resumes the sequence after a number of seconds, rounded to the nearest tick */
+inline NI_WaitTicks wait_for(double seconds) noexcept
+{
+	return NI_WaitTicks{ (seconds > 0.0) ? (uint64_t)llround(seconds / USER_BaseRate) : 0 };
+}
+
+/* The sequence of the model, in the "Sequence" file of the model definition */
+NI_Sequence USER_Sequence();
+
+#endif
@@ -0,0 +1,499 @@
+/*========================================================================*
+ * NI VeriStand Model Framework
+ * Model server
+ *
+ * Abstract:
+ *      Hosts the model in its own process, isolated from the test executive, and
+ *      serves the NIRT_* calls the client library (ni_client.c) forwards over the
+ *      shared memory rings described in ni_server.h. The server busy-waits for
+ *      requests; pin it to its own CPU for the lowest latency.
+ *
+ *      Usage: server [-c cpu] [-p priority] [-k capacity] [-n name]
+ *        -c cpu      : CPU to pin the server to (default: no pinning)
+ *        -p priority : SCHED_FIFO priority, 0 keeps SCHED_OTHER (default: 0)
+ *        -k capacity : payload values per message, limits IO, probe, vector, image and
+ *                      string sizes (default: 1024)
+ *        -n name     : name of the shared memory segment (default: NI_SERVER_NAME)
+ *
+ *========================================================================*/
+
+#ifndef _GNU_SOURCE
+	#define _GNU_SOURCE
+#endif
+
+#include "ni_server.h"
+#include <sched.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifndef NI_SERVER_NAME
+	#define NI_SERVER_NAME	"/ni_model_server"
+#endif
+
+static volatile sig_atomic_t stopServer = 0;
+
+/* Signal indices of a probe request, converted from the payload */
+static int32_t *probeIndices = NULL;
+
+/* Metadata image of the model, sent in parts of a message */
+static unsigned char *metadata = NULL;
+static uint32_t metadataSize = 0;
+
+static void OnSignal(int sig)
+{
+	UNUSED_PARAMETER(sig);
+	stopServer = 1;
+}
+
+ /*========================================================================*
+ * Function: CreateSegment
+ *
+ * Abstract:
+ *	Creates the shared memory segment with empty rings.
+ *
+ * Returns:
+ *	the header of the segment, NULL on error
+ ========================================================================*/
+static NI_ServerHeader *CreateSegment(const char *name, uint32_t capacity, int32_t numIn, int32_t numOut)
+{
+	NI_ServerHeader header;
+	void *segment;
+	int fd;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, NI_SERVER_MAGIC, 4);
+	header.version = NI_SERVER_VERSION;
+	header.capacity = capacity;
+	header.slotSize = (uint32_t)(sizeof(NI_ServerMessage) + capacity * sizeof(double) + NI_CACHE_LINE_SIZE - 1) & ~(uint32_t)(NI_CACHE_LINE_SIZE - 1);
+	header.requestOffset = (uint32_t)(sizeof(NI_ServerHeader) + NI_CACHE_LINE_SIZE - 1) & ~(uint32_t)(NI_CACHE_LINE_SIZE - 1);
+	header.responseOffset = header.requestOffset + NI_SERVER_SLOTS * header.slotSize;
+	header.segmentSize = header.responseOffset + NI_SERVER_SLOTS * header.slotSize;
+	header.serverPid = (int32_t)getpid();
+	header.numInports = numIn;
+	header.numOutports = numOut;
+
+	shm_unlink(name);
+	fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0)
+	{
+		perror("shm_open");
+		return NULL;
+	}
+
+	segment = (ftruncate(fd, header.segmentSize) == 0) ? mmap(NULL, header.segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+	close(fd);
+	if (segment == MAP_FAILED)
+	{
+		perror("mmap");
+		shm_unlink(name);
+		return NULL;
+	}
+
+	memset(segment, 0, header.segmentSize);
+	memcpy(segment, &header, sizeof(header));
+	return (NI_ServerHeader *)segment;
+}
+
+ /*========================================================================*
+ * Function: Serve
+ *
+ * Abstract:
+ *	Executes one forwarded call. The lengths a request passes are clamped to the
+ *	payload, so a call never writes past its message.
+ ========================================================================*/
+static void Serve(const NI_ServerHeader *header, const NI_ServerMessage *request, NI_ServerMessage *response, int32_t numIn, int32_t numOut)
+{
+	const double *in = NI_SERVER_PAYLOAD(request);
+	double *out = NI_SERVER_PAYLOAD(response);
+	int32_t bytes = (int32_t)(header->capacity * sizeof(double));
+	int32_t fieldSize = (int32_t)NI_SERVER_FIELD_SIZE(header);
+	int32_t mask = request->args[7];
+	int32_t i, len;
+
+	memset(response, 0, sizeof(NI_ServerMessage));
+	response->op = request->op;
+	response->epoch = header->epoch;
+
+	switch (request->op)
+	{
+		case NI_OP_INITIALIZE:
+			response->retval = NIRT_InitializeModel(request->scalars[0], &response->scalars[0], &response->args[0], &response->args[1], &response->args[2]);
+			break;
+		case NI_OP_MODELSTART:
+			response->retval = NIRT_ModelStart();
+			break;
+		case NI_OP_SCHEDULE:
+			response->retval = NIRT_Schedule((request->count >= (uint32_t)numIn) ? (double *)in : NULL, out, &response->scalars[0], NULL);
+			response->count = (uint32_t)numOut;
+			break;
+		case NI_OP_MODELUPDATE:
+			response->retval = NIRT_ModelUpdate();
+			break;
+		case NI_OP_POSTOUTPUTS:
+			response->retval = NIRT_PostOutputs(out);
+			response->count = (uint32_t)numOut;
+			break;
+		case NI_OP_FINALIZE:
+			response->retval = NIRT_FinalizeModel();
+			break;
+		case NI_OP_SETPARAMETER:
+			response->retval = NIRT_SetParameter(request->args[0], request->args[1], request->scalars[0]);
+			break;
+		case NI_OP_GETPARAMETER:
+			response->retval = NIRT_GetParameter(request->args[0], request->args[1], &response->scalars[0]);
+			break;
+		case NI_OP_PROBESIGNALS:
+		{
+			int32_t numsigs = (request->args[0] < (int32_t)header->capacity) ? request->args[0] : (int32_t)header->capacity;
+
+			for (i = 0; i < numsigs; i++)
+			{
+				probeIndices[i] = (int32_t)in[i];
+			}
+			len = (request->args[1] < (int32_t)header->capacity) ? request->args[1] : (int32_t)header->capacity;
+			response->retval = NIRT_ProbeSignals(probeIndices, numsigs, out, &len);
+			response->args[0] = len;
+			response->count = (uint32_t)len;
+			break;
+		}
+		case NI_OP_SUBSCRIBESIGNAL:
+			response->retval = NIRT_SubscribeSignal(request->args[0], request->args[1]);
+			break;
+		case NI_OP_QUEUEPARAMETER:
+			response->retval = NIRT_QueueParameter(request->scalars[0], request->args[0], request->args[1], request->scalars[1]);
+			break;
+		case NI_OP_MODELERROR:
+			len = (request->args[0] < (int32_t)(header->capacity * sizeof(double))) ? request->args[0] : (int32_t)(header->capacity * sizeof(double));
+			response->retval = NIRT_ModelError((char *)out, &len);
+			response->args[0] = len;
+			break;
+		case NI_OP_GETMODELTICK:
+			response->retval = NIRT_GetModelTick(&response->tick);
+			break;
+		case NI_OP_SETMODELTICK:
+			response->retval = NIRT_SetModelTick(request->tick);
+			break;
+		case NI_OP_GETFRAMEWORKVERSION:
+			response->retval = NIRT_GetModelFrameworkVersion((uint32_t *)&response->args[0], (uint32_t *)&response->args[1], (uint32_t *)&response->args[2], (uint32_t *)&response->args[3]);
+			break;
+		case NI_OP_PREFAULTMEMORY:
+			response->retval = NIRT_PrefaultMemory();
+			break;
+		case NI_OP_SCHEDULEN:
+		{
+			int32_t width = (numIn > numOut) ? numIn : numOut;
+			int32_t numTicks = (width > 0 && request->args[0] > (int32_t)header->capacity / width) ? (int32_t)header->capacity / width : request->args[0];
+
+			response->retval = NIRT_ScheduleN(request->args[1] ? in : NULL, out, numTicks, &response->scalars[0]);
+			response->args[0] = numTicks;
+			response->count = (uint32_t)(numTicks * numOut);
+			break;
+		}
+		case NI_OP_GETMODELMETADATA:
+		{
+			uint32_t offset = (uint32_t)request->args[0];
+
+			len = (offset < metadataSize) ? (int32_t)(metadataSize - offset) : 0;
+			len = (len < bytes) ? len : bytes;
+			memcpy(out, metadata + offset, (size_t)len);
+			response->retval = (metadata != NULL) ? NI_OK : NI_ERROR;
+			response->args[0] = (int32_t)metadataSize;
+			response->count = (uint32_t)len;
+			break;
+		}
+		case NI_OP_TASKTAKEONESTEP:
+			response->retval = NIRT_TaskTakeOneStep(request->args[0]);
+			break;
+		case NI_OP_GETSTEADYSTATEINFO:
+			response->retval = NIRT_GetSteadyStateInfo(&response->args[0], &response->scalars[0]);
+			break;
+		case NI_OP_GETSHEDDINGINFO:
+			response->retval = NIRT_GetSheddingInfo(&response->scalars[0], &response->scalars[1], &response->scalars[2]);
+			break;
+		case NI_OP_GETMEMOIZATIONINFO:
+			response->retval = NIRT_GetMemoizationInfo(&response->scalars[0]);
+			break;
+		case NI_OP_PROBESIGNALCHANGES:
+		{
+			/* the values fill the payload in front of the indices */
+			int32_t numsigs = (request->args[3] && (request->args[1] > bytes / (int32_t)sizeof(int32_t))) ? bytes / (int32_t)sizeof(int32_t) : request->args[1];
+			int32_t num = (request->args[2] < bytes / 12) ? request->args[2] : bytes / 12;
+
+			if (request->args[3])
+			{
+				memcpy(probeIndices, in, (size_t)(numsigs > 0 ? numsigs : 0) * sizeof(int32_t));
+			}
+			response->retval = NIRT_ProbeSignalChanges(request->args[0], request->args[3] ? probeIndices : NULL, numsigs, (int32_t *)(out + num), out, &num, &response->args[1]);
+			response->args[0] = num;
+			break;
+		}
+		case NI_OP_RESYNCSIGNALCHANGES:
+			response->retval = NIRT_ResyncSignalChanges(request->args[0]);
+			break;
+		case NI_OP_SETSIGNALDEADBAND:
+			response->retval = NIRT_SetSignalDeadband(request->args[0], request->scalars[0]);
+			break;
+		case NI_OP_SETSCALARPARAMETERINLINE:
+			response->retval = NIRT_SetScalarParameterInline((uint32_t)request->args[0], (uint32_t)request->args[1], request->scalars[0]);
+			break;
+		case NI_OP_SETVECTORPARAMETER:
+			response->retval = ((uint32_t)request->args[1] <= header->capacity) ? NIRT_SetVectorParameter((uint32_t)request->args[0], in, (uint32_t)request->args[1]) : NI_ERROR;
+			break;
+		case NI_OP_GETVECTORPARAMETER:
+			response->retval = ((uint32_t)request->args[1] <= header->capacity) ? NIRT_GetVectorParameter((uint32_t)request->args[0], out, (uint32_t)request->args[1]) : NI_ERROR;
+			break;
+		case NI_OP_SETPARAMETERBATCH:
+		{
+			int32_t count = (request->args[0] <= bytes / 16) ? request->args[0] : 0;
+			const int32_t *indices = (const int32_t *)(in + count);
+
+			response->retval = (count == request->args[0]) ? NIRT_SetParameterBatch(indices, request->args[1] ? indices + count : NULL, in, count, (int32_t *)out) : NI_ERROR;
+			break;
+		}
+		case NI_OP_SETPARAMETERIMAGE:
+			response->retval = (request->args[0] <= bytes) ? NIRT_SetParameterImage(in, (uint32_t)request->args[0]) : NI_ERROR;
+			break;
+		case NI_OP_GETPARAMETERIMAGE:
+		{
+			uint32_t size = (uint32_t)((request->args[0] < bytes) ? request->args[0] : bytes);
+
+			response->retval = NIRT_GetParameterImage((request->args[0] < 0) ? NULL : out, &size);
+			response->args[0] = (int32_t)size;
+			break;
+		}
+		case NI_OP_LOADPARAMETERSET:
+			((char *)in)[bytes - 1] = 0;
+			response->retval = NIRT_LoadParameterSet((const char *)in, &response->args[0]);
+			break;
+		case NI_OP_SAVEPARAMETERSET:
+			((char *)in)[bytes - 1] = 0;
+			response->retval = NIRT_SaveParameterSet((const char *)in);
+			break;
+		case NI_OP_GETERRORMESSAGELENGTH:
+			response->retval = NIRT_GetErrorMessageLength();
+			break;
+		case NI_OP_TASKRUNTIMEINFO:
+			response->args[0] = (request->args[1] < bytes / (int32_t)sizeof(int32_t)) ? request->args[1] : bytes / (int32_t)sizeof(int32_t);
+			response->retval = NIRT_TaskRunTimeInfo(request->args[0], (int32_t *)out, &response->args[0]);
+			break;
+		case NI_OP_GETSIMSTATE:
+		{
+			/* names and states in fields 0 to 5, the counts are clamped to the names that fit into a field */
+			int32_t *counts = &response->args[0];
+
+			memset(out, 0, (size_t)bytes);
+			for (i = 0; i < 3; i++)
+			{
+				counts[i] = (request->args[i] < fieldSize / NI_SIMSTATE_NAME_SIZE) ? request->args[i] : fieldSize / NI_SIMSTATE_NAME_SIZE;
+			}
+			response->retval = NIRT_GetSimState((mask & NI_SERVER_MASK(0)) ? &counts[0] : NULL, (mask & NI_SERVER_MASK(1)) ? NI_SERVER_FIELD(header, response, 0) : NULL, (mask & NI_SERVER_MASK(2)) ? (double *)NI_SERVER_FIELD(header, response, 1) : NULL,
+												(mask & NI_SERVER_MASK(0)) ? &counts[1] : NULL, (mask & NI_SERVER_MASK(3)) ? NI_SERVER_FIELD(header, response, 2) : NULL, (mask & NI_SERVER_MASK(4)) ? (double *)NI_SERVER_FIELD(header, response, 3) : NULL,
+												(mask & NI_SERVER_MASK(0)) ? &counts[2] : NULL, (mask & NI_SERVER_MASK(5)) ? NI_SERVER_FIELD(header, response, 4) : NULL, (mask & NI_SERVER_MASK(6)) ? (int32_t *)NI_SERVER_FIELD(header, response, 5) : NULL);
+			for (i = 0; i < 6; i += 2)
+			{
+				NI_SERVER_FIELD(header, response, i)[fieldSize - 1] = 0;
+			}
+			response->args[7] = mask;
+			break;
+		}
+		case NI_OP_SETSIMSTATE:
+			response->retval = NIRT_SetSimState((mask & NI_SERVER_MASK(0)) ? (double *)NI_SERVER_FIELD(header, request, 0) : NULL, (mask & NI_SERVER_MASK(1)) ? (double *)NI_SERVER_FIELD(header, request, 1) : NULL,
+												(mask & NI_SERVER_MASK(2)) ? (int32_t *)NI_SERVER_FIELD(header, request, 2) : NULL);
+			break;
+		case NI_OP_GETBUILDINFO:
+			len = (request->args[0] < bytes - 1) ? request->args[0] : bytes - 1;
+			response->retval = NIRT_GetBuildInfo((char *)out, &len);
+			response->args[0] = len;
+			break;
+		case NI_OP_GETMODELSPEC:
+			len = (request->args[0] < bytes) ? request->args[0] : bytes;
+			response->retval = NIRT_GetModelSpec((mask & NI_SERVER_MASK(0)) ? (char *)out : NULL, (mask & NI_SERVER_MASK(1)) ? &len : NULL, &response->scalars[0], &response->args[1], &response->args[2], &response->args[3]);
+			response->args[0] = len;
+			break;
+		case NI_OP_GETPARAMETERINDICES:
+			len = (request->args[0] < bytes / (int32_t)sizeof(int32_t)) ? request->args[0] : bytes / (int32_t)sizeof(int32_t);
+			response->retval = NIRT_GetParameterIndices((int32_t *)out, &len);
+			response->args[0] = len;
+			break;
+		case NI_OP_GETPARAMETERSPEC:
+		{
+			int32_t *args = &response->args[0];
+
+			/* index, ID_len, pnlen and numdim, the ID of a lookup is NUL terminated in field 0 */
+			memcpy(args, request->args, 4 * sizeof(int32_t));
+			memcpy(NI_SERVER_FIELD(header, response, 0), NI_SERVER_FIELD(header, request, 0), (size_t)fieldSize);
+			NI_SERVER_FIELD(header, response, 0)[fieldSize - 1] = 0;
+			args[1] = (args[1] < fieldSize - 1) ? args[1] : fieldSize - 1;
+			args[2] = (args[2] < fieldSize) ? args[2] : fieldSize;
+			args[3] = (args[3] < fieldSize / (int32_t)sizeof(int32_t)) ? args[3] : fieldSize / (int32_t)sizeof(int32_t);
+			response->retval = NIRT_GetParameterSpec(&args[0], (mask & NI_SERVER_MASK(0)) ? NI_SERVER_FIELD(header, response, 0) : NULL, &args[1], (mask & NI_SERVER_MASK(1)) ? NI_SERVER_FIELD(header, response, 1) : NULL, &args[2],
+													&args[4], (mask & NI_SERVER_MASK(2)) ? (int32_t *)NI_SERVER_FIELD(header, response, 2) : NULL, &args[3]);
+			break;
+		}
+		case NI_OP_GETSIGNALSPEC:
+		{
+			int32_t *args = &response->args[0];
+
+			/* index, ID_len, bnlen, snlen and numdim, the ID of a lookup is NUL terminated in field 0 */
+			memcpy(args, request->args, 5 * sizeof(int32_t));
+			memcpy(NI_SERVER_FIELD(header, response, 0), NI_SERVER_FIELD(header, request, 0), (size_t)fieldSize);
+			NI_SERVER_FIELD(header, response, 0)[fieldSize - 1] = 0;
+			args[1] = (args[1] < fieldSize - 1) ? args[1] : fieldSize - 1;
+			args[2] = (args[2] < fieldSize) ? args[2] : fieldSize;
+			args[3] = (args[3] < fieldSize) ? args[3] : fieldSize;
+			args[4] = (args[4] < fieldSize / (int32_t)sizeof(int32_t)) ? args[4] : fieldSize / (int32_t)sizeof(int32_t);
+			response->retval = NIRT_GetSignalSpec(&args[0], (mask & NI_SERVER_MASK(0)) ? NI_SERVER_FIELD(header, response, 0) : NULL, &args[1], (mask & NI_SERVER_MASK(1)) ? NI_SERVER_FIELD(header, response, 1) : NULL, &args[2], &args[5],
+												(mask & NI_SERVER_MASK(2)) ? NI_SERVER_FIELD(header, response, 2) : NULL, &args[3], &args[6], (mask & NI_SERVER_MASK(3)) ? (int32_t *)NI_SERVER_FIELD(header, response, 3) : NULL, &args[4]);
+			break;
+		}
+		case NI_OP_GETTASKSPEC:
+			response->retval = NIRT_GetTaskSpec(request->args[0], &response->args[0], &response->scalars[0], &response->scalars[1]);
+			break;
+		case NI_OP_GETEXTIOSPEC:
+		{
+			/* the name buffer is sized by its string, as NIRT_GetExtIOSpec expects */
+			int32_t size = (request->args[1] < fieldSize - 1) ? request->args[1] : fieldSize - 1;
+			char *name = NI_SERVER_FIELD(header, response, 0);
+			int32_t index = request->args[0];
+
+			if ((index != -1) && ((index < 0) || (index >= NIRT_GetExtIOSpec(-1, NULL, NULL, NULL, NULL, NULL, NULL))))
+			{
+				response->retval = NI_ERROR;
+				break;
+			}
+
+			size = (size > 0) ? size : 0;
+			memset(name, '.', (size_t)size);
+			name[size] = 0;
+			response->args[3] = request->args[2];
+			response->retval = NIRT_GetExtIOSpec(index, &response->args[0], (size > 0) ? name : NULL, &response->args[1], &response->args[2], (int32_t *)NI_SERVER_FIELD(header, response, 1), &response->args[3]);
+			break;
+		}
+		default:
+			response->retval = NI_ERROR;
+			break;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *name = NI_SERVER_NAME;
+	NI_ServerHeader *header;
+	int32_t cpu = -1, priority = 0, numIn = 0, numOut = 0, numTasks = 0;
+	uint32_t capacity = NI_SERVER_CAPACITY, spins = 0, spinLimit;
+	double baseRate;
+	int c;
+
+	while ((c = getopt(argc, argv, "c:p:k:n:")) != -1)
+	{
+		switch (c)
+		{
+			case 'c': cpu = atoi(optarg); break;
+			case 'p': priority = atoi(optarg); break;
+			case 'k': capacity = (uint32_t)atoi(optarg); break;
+			case 'n': name = optarg; break;
+			default:
+				fprintf(stderr, "Usage: %s [-c cpu] [-p priority] [-k capacity] [-n name]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	NIRT_GetModelSpec(NULL, 0, &baseRate, &numIn, &numOut, &numTasks);
+	if (capacity < (uint32_t)numIn || capacity < (uint32_t)numOut)
+	{
+		capacity = (uint32_t)((numIn > numOut) ? numIn : numOut);
+	}
+	capacity = (capacity > NI_SERVER_MIN_CAPACITY) ? (capacity + 7) & ~7u : NI_SERVER_MIN_CAPACITY;
+
+	if ((NIRT_GetModelMetadata(NULL, &metadataSize) == NI_OK) && ((metadata = (unsigned char *)malloc(metadataSize)) != NULL))
+	{
+		NIRT_GetModelMetadata(metadata, &metadataSize);
+	}
+
+	if (cpu >= 0)
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		if (sched_setaffinity(0, sizeof(set), &set) != 0)
+		{
+			perror("Warning: sched_setaffinity");
+		}
+	}
+
+	if (priority > 0)
+	{
+		struct sched_param param;
+		memset(&param, 0, sizeof(param));
+		param.sched_priority = priority;
+		if (sched_setscheduler(0, SCHED_FIFO, &param) != 0)
+		{
+			perror("Warning: sched_setscheduler(SCHED_FIFO)");
+		}
+	}
+
+	header = CreateSegment(name, capacity, numIn, numOut);
+	probeIndices = (int32_t *)calloc(2 * capacity, sizeof(int32_t));
+	if ((header == NULL) || (probeIndices == NULL))
+	{
+		return 1;
+	}
+
+	if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+	{
+		perror("Warning: mlockall");
+	}
+
+	/* spinning only pays off when the client runs on another CPU */
+	spinLimit = (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? NI_SERVER_SPIN : 0;
+	signal(SIGINT, OnSignal);
+	signal(SIGTERM, OnSignal);
+	printf("Serving on %s (%u payload values per message)\n", name, capacity);
+	fflush(stdout);
+
+	while (!stopServer)
+	{
+		uint32_t tail, head;
+
+		/* a new client waits for its session: drop what the previous one left in the rings */
+		if (NI_AtomicLoad32(&header->requestedEpoch) != header->epoch)
+		{
+			header->request.head = 0;
+			header->request.tail = 0;
+			header->response.head = 0;
+			header->response.tail = 0;
+			NI_AtomicStore32(&header->epoch, header->requestedEpoch);
+			continue;
+		}
+
+		tail = header->request.tail;
+		head = header->response.head;
+
+		/* wait for a request, and for room for the response */
+		if ((NI_AtomicLoad32(&header->request.head) == tail) || (head - NI_AtomicLoad32(&header->response.tail) >= NI_SERVER_SLOTS))
+		{
+			/* spin for the next request, yield the CPU when it takes long */
+			if (++spins < spinLimit)
+			{
+				NI_CpuRelax();
+			}
+			else
+			{
+				sched_yield();
+			}
+			continue;
+		}
+
+		spins = 0;
+		Serve(header, NI_SERVER_SLOT(header, header->requestOffset, tail), NI_SERVER_SLOT(header, header->responseOffset, head), numIn, numOut);
+		NI_AtomicStore32(&header->request.tail, tail + 1);
+		NI_AtomicStore32(&header->response.head, head + 1);
+	}
+
+	shm_unlink(name);
+	munmap(header, header->segmentSize);
+	return 0;
+}
@@ -0,0 +1,134 @@
+/*========================================================================*
+ * NI VeriStand Model Framework
+ * Model server protocol
+ *
+ * Abstract:
+ *      The model server (ni_server.c) hosts a model in its own process; the client
+ *      library (ni_client.c) implements the NIRT_* step, parameter and probe calls
+ *      by forwarding them to it. Both sides share one POSIX shared memory segment
+ *      holding a request ring (client to server) and a response ring (server to
+ *      client). Each ring is single producer, single consumer: the producer fills
+ *      the slot at head and then advances head, the consumer processes the slot at
+ *      tail and then advances tail. Both sides busy-wait, so a call costs two
+ *      cache line transfers each way and no system call.
+ *
+ *      Every client attach starts a new session: the client requests the next
+ *      epoch, and the server empties both rings before accepting it, so the
+ *      requests and responses a dead client left behind never reach the new one.
+ *
+ *========================================================================*/
+
+#ifndef NI_SERVER_H
+#define NI_SERVER_H
+
+#include "ni_modelframework.h"
+
+#define NI_SERVER_MAGIC		"NISV"
+#define NI_SERVER_VERSION	2
+
+/* Number of slots of each ring, a power of two */
+#define NI_SERVER_SLOTS		8
+
+/* Number of spins after which a waiting side yields the CPU (it yields right away on a single CPU) */
+#define NI_SERVER_SPIN		4096
+
+/* Default number of payload values of a message, at least the number of inports and outports */
+#define NI_SERVER_CAPACITY	1024
+
+/* Smallest number of payload values of a message, the capacity is also a multiple of 8. A field
+   then holds the two clock tick names of NIRT_GetSimState. */
+#define NI_SERVER_MIN_CAPACITY	256
+
+/* The calls with several string or array arguments split the payload into fields of NI_SERVER_FIELD_SIZE bytes */
+#define NI_SERVER_FIELDS	8
+
+/* Forwarded calls */
+enum {
+	NI_OP_INITIALIZE = 1,	/* scalars[0] finaltime -> scalars[0] timestep, args num_in, num_out, num_tasks */
+	NI_OP_MODELSTART,
+	NI_OP_SCHEDULE,			/* payload inData -> payload outData, scalars[0] time */
+	NI_OP_MODELUPDATE,
+	NI_OP_POSTOUTPUTS,		/* -> payload outData */
+	NI_OP_FINALIZE,
+	NI_OP_SETPARAMETER,		/* args index, subindex, scalars[0] value */
+	NI_OP_GETPARAMETER,		/* args index, subindex -> scalars[0] value */
+	NI_OP_PROBESIGNALS,		/* args numsigs, len, payload sigindices -> args len, payload values */
+	NI_OP_SUBSCRIBESIGNAL,	/* args index, subscribe */
+	NI_OP_QUEUEPARAMETER,	/* scalars[0] timestamp, args index, subindex, scalars[1] value */
+	NI_OP_MODELERROR,		/* args msglen -> args msglen, payload message */
+	NI_OP_GETMODELTICK,		/* -> tick */
+	NI_OP_SETMODELTICK,		/* tick */
+	NI_OP_GETFRAMEWORKVERSION,	/* -> args major, minor, fix, build */
+	NI_OP_PREFAULTMEMORY,
+	NI_OP_SCHEDULEN,		/* args numTicks, has inData, payload inData -> payload outData, scalars[0] time */
+	NI_OP_GETMODELMETADATA,	/* args offset -> args size, count bytes of the image at offset in the payload */
+	NI_OP_TASKTAKEONESTEP,	/* args taskid */
+	NI_OP_GETSTEADYSTATEINFO,	/* -> args steady, scalars[0] skippedSteps */
+	NI_OP_GETSHEDDINGINFO,	/* -> scalars shedSteps, shedCount, stepCost */
+	NI_OP_GETMEMOIZATIONINFO,	/* -> scalars[0] reusedSteps */
+	NI_OP_PROBESIGNALCHANGES,	/* args stream, numsigs, num, has sigindices, payload sigindices -> args num, keyframe, payload values then indices */
+	NI_OP_RESYNCSIGNALCHANGES,	/* args stream */
+	NI_OP_SETSIGNALDEADBAND,	/* args index, scalars[0] deadband */
+	NI_OP_SETSCALARPARAMETERINLINE,	/* args index, subindex, scalars[0] value */
+	NI_OP_SETVECTORPARAMETER,	/* args index, length, payload values */
+	NI_OP_GETVECTORPARAMETER,	/* args index, length -> payload values */
+	NI_OP_SETPARAMETERBATCH,	/* args count, has subindices, payload values, indices, subindices -> payload errors */
+	NI_OP_SETPARAMETERIMAGE,	/* args size, payload image */
+	NI_OP_GETPARAMETERIMAGE,	/* args size or -1 for the size only -> args size, payload image */
+	NI_OP_LOADPARAMETERSET,		/* payload path -> args unmatched */
+	NI_OP_SAVEPARAMETERSET,		/* payload path */
+	NI_OP_GETERRORMESSAGELENGTH,
+	NI_OP_TASKRUNTIMEINFO,		/* args halt, numtasks -> args numtasks, payload overruns */
+	NI_OP_GETSIMSTATE,		/* args numContStates, numDiscStates, numClockTicks, mask -> the same, fields names and states */
+	NI_OP_SETSIMSTATE,		/* args numContStates, numDiscStates, numClockTicks, mask, fields states */
+	NI_OP_GETBUILDINFO,		/* args len -> args len, payload detail */
+	NI_OP_GETMODELSPEC,		/* args namelen, mask -> args namelen, inports, outports, tasks, scalars[0] base rate, payload name */
+	NI_OP_GETPARAMETERINDICES,	/* args len -> args len, payload indices */
+	NI_OP_GETPARAMETERSPEC,	/* args index, ID_len, pnlen, numdim, mask, field ID -> args and datatype, fields ID, name, dims */
+	NI_OP_GETSIGNALSPEC,	/* args index, ID_len, bnlen, snlen, numdim, mask, field ID -> args, portnum, datatype, fields ID, names, dims */
+	NI_OP_GETTASKSPEC,		/* args index -> args tid, scalars tstep, offset */
+	NI_OP_GETEXTIOSPEC		/* args index, name size, numdims -> args idx, tid, type, numdims, fields name, dims */
+};
+
+/* Bit of the mask argument of the calls above telling the server that the n-th buffer argument is not NULL */
+#define NI_SERVER_MASK(n)	(1 << (n))
+
+typedef struct {
+  uint32_t op;				/* NI_OP_* */
+  int32_t retval;			/* return value of the call (response) */
+  int32_t args[8];			/* integer arguments and results */
+  double scalars[4];		/* floating point arguments and results */
+  uint64_t tick;			/* tick argument or result */
+  uint32_t count;			/* number of values in the payload */
+  uint32_t epoch;			/* session of the response, see NI_ServerHeader */
+} NI_ServerMessage;			/* followed by the payload, capacity doubles */
+
+typedef struct {
+  NI_CACHE_ALIGNED volatile uint32_t head;	/* next slot the producer fills */
+  NI_CACHE_ALIGNED volatile uint32_t tail;	/* next slot the consumer processes */
+} NI_ServerRing;
+
+typedef struct {
+  char magic[4];			/* NI_SERVER_MAGIC */
+  uint32_t version;			/* NI_SERVER_VERSION */
+  uint32_t slotSize;		/* size of a message including its payload */
+  uint32_t capacity;		/* number of payload values of a message */
+  uint32_t requestOffset;	/* offset of the request slots in the segment */
+  uint32_t responseOffset;	/* offset of the response slots in the segment */
+  uint32_t segmentSize;		/* size of the segment */
+  volatile int32_t serverPid;	/* process id of the server */
+  volatile int32_t clientPid;	/* process id of the attached client, 0 if none */
+  int32_t numInports;		/* number of external inputs of the model */
+  int32_t numOutports;		/* number of external outputs of the model */
+  volatile uint32_t epoch;	/* session the rings belong to, every response carries it */
+  volatile uint32_t requestedEpoch;	/* session a new client waits for, the server empties the rings to start it */
+  NI_ServerRing request;
+  NI_ServerRing response;
+} NI_ServerHeader;
+
+#define NI_SERVER_SLOT(header, offset, index)	((NI_ServerMessage *)((unsigned char *)(header) + (offset) + ((index) & (NI_SERVER_SLOTS - 1)) * (header)->slotSize))
+#define NI_SERVER_PAYLOAD(message)				((double *)((NI_ServerMessage *)(message) + 1))
+#define NI_SERVER_FIELD_SIZE(header)			((header)->capacity * sizeof(double) / NI_SERVER_FIELDS)
+#define NI_SERVER_FIELD(header, message, n)		((char *)NI_SERVER_PAYLOAD(message) + (n) * NI_SERVER_FIELD_SIZE(header))
+
+#endif
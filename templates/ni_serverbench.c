@@ -0,0 +1,166 @@
+/*========================================================================*
+ * NI VeriStand Model Framework
+ * Model server benchmark
+ *
+ * Abstract:
+ *      Measures what hosting a model out of process costs: runs the same number
+ *      of NIRT_Schedule/NIRT_ModelUpdate ticks (plus one NIRT_ProbeSignals of all
+ *      signals) against the model library in process and against the client
+ *      library talking to a running model server, back to back without pacing,
+ *      and prints the time per tick of both.
+ *
+ *      Usage: serverbench [-n ticks] model_library client_library
+ *        -n ticks : number of ticks per run (default: 100000)
+ *
+ *========================================================================*/
+
+#ifndef _GNU_SOURCE
+	#define _GNU_SOURCE
+#endif
+
+#include "ni_modelframework.h"
+#include <dlfcn.h>
+#include <unistd.h>
+
+#define NSEC_PER_SEC	1000000000LL
+
+typedef int32_t (*InitializeFn)(double, double*, int32_t*, int32_t*, int32_t*);
+typedef int32_t (*ScheduleFn)(double*, double*, double*, int32_t*);
+typedef int32_t (*VoidFn)(void);
+typedef int32_t (*ProbeFn)(int32_t*, int32_t, double*, int32_t*);
+
+static int64_t NowNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static int CompareInt64(const void *a, const void *b)
+{
+	int64_t x = *(const int64_t *)a;
+	int64_t y = *(const int64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+ /*========================================================================*
+ * Function: RunTicks
+ *
+ * Abstract:
+ *	Loads a library exporting the NIRT_* calls and times ticks against it.
+ *
+ * Returns:
+ *	NI_OK if no error
+ ========================================================================*/
+static int32_t RunTicks(const char *library, int64_t ticks, int64_t *samples)
+{
+	/* DEEPBIND keeps the model and the client library, which export the same names, apart */
+	void *lib = dlopen(library, RTLD_NOW | RTLD_LOCAL | RTLD_DEEPBIND);
+	InitializeFn initialize;
+	ScheduleFn schedule;
+	VoidFn start, update, finalize;
+	ProbeFn probe;
+	double baseRate, simTime, inData[1024], outData[1024], values[1024];
+	int32_t numIn, numOut, numTasks, indices[1024], len, i;
+	int64_t tick, begin;
+
+	if (lib == NULL)
+	{
+		fprintf(stderr, "%s\n", dlerror());
+		return NI_ERROR;
+	}
+
+	initialize = (InitializeFn)dlsym(lib, "NIRT_InitializeModel");
+	schedule = (ScheduleFn)dlsym(lib, "NIRT_Schedule");
+	start = (VoidFn)dlsym(lib, "NIRT_ModelStart");
+	update = (VoidFn)dlsym(lib, "NIRT_ModelUpdate");
+	finalize = (VoidFn)dlsym(lib, "NIRT_FinalizeModel");
+	probe = (ProbeFn)dlsym(lib, "NIRT_ProbeSignals");
+
+	if (!initialize || !schedule || !start || !update || !finalize || !probe ||
+		(initialize((double)ticks, &baseRate, &numIn, &numOut, &numTasks) != NI_OK) || (numIn > 1024) || (numOut > 1024) || (start() != NI_OK))
+	{
+		fprintf(stderr, "Cannot start the model with %s.\n", library);
+		return NI_ERROR;
+	}
+
+	/* list of all signals, the first entry is the bookkeeping index */
+	indices[0] = 0;
+	for (i = 1; i < 1023; i++)
+	{
+		indices[i] = i - 1;
+	}
+	indices[1023] = -1;
+	memset(inData, 0, sizeof(inData));
+
+	for (tick = 0; tick < ticks; tick++)
+	{
+		begin = NowNs();
+		schedule(inData, outData, &simTime, NULL);
+		len = 1024;
+		probe(indices, 1024, values, &len);
+		update();
+		samples[tick] = NowNs() - begin;
+	}
+
+	finalize();
+	dlclose(lib);
+	return NI_OK;
+}
+
+static void PrintSamples(const char *name, int64_t *samples, int64_t ticks)
+{
+	double sum = 0.0;
+	int64_t i;
+
+	for (i = 0; i < ticks; i++)
+	{
+		sum += (double)samples[i];
+	}
+
+	qsort(samples, (size_t)ticks, sizeof(int64_t), CompareInt64);
+	printf("%-12s(ns): min %8lld  avg %10.1f  p50 %8lld  p99 %8lld  max %8lld\n", name, (long long)samples[0], sum / (double)ticks,
+		(long long)samples[ticks / 2], (long long)samples[(ticks * 99) / 100], (long long)samples[ticks - 1]);
+}
+
+int main(int argc, char **argv)
+{
+	int64_t ticks = 100000;
+	int64_t *local, *remote;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:")) != -1)
+	{
+		switch (c)
+		{
+			case 'n': ticks = atoll(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-n ticks] model_library client_library\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if ((optind + 2 > argc) || (ticks < 1))
+	{
+		fprintf(stderr, "Usage: %s [-n ticks] model_library client_library\n", argv[0]);
+		return 1;
+	}
+
+	local = (int64_t *)calloc((size_t)ticks, sizeof(int64_t));
+	remote = (int64_t *)calloc((size_t)ticks, sizeof(int64_t));
+	if (!local || !remote || (RunTicks(argv[optind], ticks, local) != NI_OK) || (RunTicks(argv[optind + 1], ticks, remote) != NI_OK))
+	{
+		return 1;
+	}
+
+	printf("\n*******************************************************************************\n");
+	printf("Schedule + ProbeSignals + ModelUpdate, %lld ticks\n", (long long)ticks);
+	PrintSamples("in process", local, ticks);
+	PrintSamples("server", remote, ticks);
+	printf("*******************************************************************************\n");
+
+	free(local);
+	free(remote);
+	return 0;
+}
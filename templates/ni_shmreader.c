@@ -0,0 +1,273 @@
+/*========================================================================*
+ * NI VeriStand Model Framework
+ * Shared-memory signal reader
+ *
+ * Abstract:
+ *      Reader side of the shared-memory signal publication, see ni_shmreader.h.
+ *
+ *========================================================================*/
+
+#include "ni_shmreader.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Datatypes of the published values (rtDBL and rtINT of the model) */
+#define NI_SHM_DBL	0
+#define NI_SHM_INT	2
+
+/* Number of attempts after which a read gives up on a model that stays in the middle of a write */
+#define NI_SHM_MAX_RETRIES	1000000
+
+/* Copies values out of the data of the segment, see NI_ShmConsistentRead */
+typedef void (*NI_ShmCopy)(const NI_ShmReader *reader, const unsigned char *data, void *context);
+
+typedef struct {
+	const int32_t *indices;
+	int32_t count;
+	double *values;
+} NI_ShmValues;
+
+typedef struct {
+	int32_t index;
+	void *buffer;
+} NI_ShmRaw;
+
+int32_t NI_ShmOpen(NI_ShmReader *reader, const char *name)
+{
+	const NI_ShmHeader *header;
+	struct stat st;
+	void *segment;
+	int32_t i;
+	int fd;
+
+	memset(reader, 0, sizeof(NI_ShmReader));
+
+	fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0)
+	{
+		return NI_ERROR;
+	}
+
+	if ((fstat(fd, &st) != 0) || (st.st_size < (off_t)sizeof(NI_ShmHeader)))
+	{
+		close(fd);
+		return NI_ERROR;
+	}
+
+	segment = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (segment == MAP_FAILED)
+	{
+		return NI_ERROR;
+	}
+
+	header = (const NI_ShmHeader *)segment;
+	if ((memcmp(header->magic, NI_SHM_MAGIC, 4) != 0) || (header->version != NI_SHM_VERSION) ||
+		(header->segmentSize > (uint32_t)st.st_size) || (header->dataOffset + header->dataSize > header->segmentSize) ||
+		(header->directoryOffset + header->count * sizeof(NI_ShmSignal) > header->dataOffset))
+	{
+		munmap(segment, (size_t)st.st_size);
+		return NI_ERROR;
+	}
+
+	reader->header = header;
+	reader->signals = (const NI_ShmSignal *)((const unsigned char *)segment + header->directoryOffset);
+	reader->size = (uint32_t)st.st_size;
+
+	/* Every value must lie within the data, every name within the segment */
+	for (i = 0; i < (int32_t)header->count; i++)
+	{
+		const NI_ShmSignal *signal = &reader->signals[i];
+
+		if ((signal->width < 0) || (signal->size < 0) || (signal->offset > header->dataSize) ||
+			((uint64_t)signal->width * (uint64_t)signal->size > header->dataSize - signal->offset) ||
+			(signal->nameOffset >= header->segmentSize) || 
+			(memchr((const char *)header + signal->nameOffset, 0, header->segmentSize - signal->nameOffset) == NULL))
+		{
+			NI_ShmClose(reader);
+			return NI_ERROR;
+		}
+	}
+
+	return NI_OK;
+}
+
+void NI_ShmClose(NI_ShmReader *reader)
+{
+	if (reader->header != NULL)
+	{
+		munmap((void *)reader->header, reader->size);
+		reader->header = NULL;
+	}
+}
+
+int32_t NI_ShmSignalCount(const NI_ShmReader *reader)
+{
+	return (int32_t)reader->header->count;
+}
+
+const char *NI_ShmSignalName(const NI_ShmReader *reader, int32_t index)
+{
+	if ((index < 0) || (index >= (int32_t)reader->header->count))
+	{
+		return NULL;
+	}
+
+	return (const char *)reader->header + reader->signals[index].nameOffset;
+}
+
+int32_t NI_ShmSignalWidth(const NI_ShmReader *reader, int32_t index)
+{
+	if ((index < 0) || (index >= (int32_t)reader->header->count))
+	{
+		return -1;
+	}
+
+	return reader->signals[index].width;
+}
+
+int32_t NI_ShmFindSignal(const NI_ShmReader *reader, const char *name)
+{
+	int32_t i;
+
+	for (i = 0; i < (int32_t)reader->header->count; i++)
+	{
+		if (strcmp(NI_ShmSignalName(reader, i), name) == 0)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/* Calls copy until it copied the data of a step the model did not write meanwhile */
+static int32_t NI_ShmConsistentRead(NI_ShmReader *reader, NI_ShmCopy copy, void *context, uint64_t *tick, double *timestamp)
+{
+	const NI_ShmHeader *header = reader->header;
+	const unsigned char *data = (const unsigned char *)header + header->dataOffset;
+	uint64_t readTick;
+	double readTimestamp;
+	uint32_t sequence;
+	int32_t attempts = 0;
+
+	for (;;)
+	{
+		sequence = NI_AtomicLoad32(&header->sequence);
+		if (!(sequence & 1))
+		{
+			readTick = header->tick;
+			readTimestamp = header->timestamp;
+			copy(reader, data, context);
+
+			/* the values are only valid if the model did not write meanwhile */
+			NI_MemoryFence();
+			if (NI_AtomicLoad32(&header->sequence) == sequence)
+			{
+				break;
+			}
+		}
+
+		reader->retries++;
+		if (++attempts >= NI_SHM_MAX_RETRIES)
+		{
+			return NI_ERROR;
+		}
+		NI_CpuRelax();
+	}
+
+	if (tick)
+	{
+		*tick = readTick;
+	}
+
+	if (timestamp)
+	{
+		*timestamp = readTimestamp;
+	}
+
+	reader->reads++;
+	return NI_OK;
+}
+
+/* Converts every element of the signals to double, unknown datatypes read as NaN */
+static void NI_ShmCopyValues(const NI_ShmReader *reader, const unsigned char *data, void *context)
+{
+	const NI_ShmValues *request = (const NI_ShmValues *)context;
+	double *values = request->values;
+	int32_t i, j;
+
+	for (i = 0; i < request->count; i++)
+	{
+		const NI_ShmSignal *signal = &reader->signals[request->indices[i]];
+		const unsigned char *value = data + signal->offset;
+
+		for (j = 0; j < signal->width; j++)
+		{
+			switch (signal->datatype)
+			{
+				case NI_SHM_DBL: memcpy(values, value + j * sizeof(double), sizeof(double)); break;
+				case NI_SHM_INT: { int32_t v; memcpy(&v, value + j * sizeof(int32_t), sizeof(int32_t)); *values = (double)v; } break;
+				default: *values = NAN; break;
+			}
+			values++;
+		}
+	}
+}
+
+static void NI_ShmCopyRaw(const NI_ShmReader *reader, const unsigned char *data, void *context)
+{
+	const NI_ShmRaw *request = (const NI_ShmRaw *)context;
+	const NI_ShmSignal *signal = &reader->signals[request->index];
+
+	memcpy(request->buffer, data + signal->offset, (size_t)signal->width * (size_t)signal->size);
+}
+
+int32_t NI_ShmRead(NI_ShmReader *reader, const int32_t *indices, int32_t count, double *values, int32_t *len, uint64_t *tick, double *timestamp)
+{
+	NI_ShmValues request;
+	int32_t i, total = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		if ((indices[i] < 0) || (indices[i] >= (int32_t)reader->header->count))
+		{
+			return NI_ERROR;
+		}
+		total += reader->signals[indices[i]].width;
+	}
+
+	if (total > *len)
+	{
+		return NI_ERROR;
+	}
+
+	request.indices = indices;
+	request.count = count;
+	request.values = values;
+	if (NI_ShmConsistentRead(reader, NI_ShmCopyValues, &request, tick, timestamp) != NI_OK)
+	{
+		return NI_ERROR;
+	}
+
+	*len = total;
+	return NI_OK;
+}
+
+int32_t NI_ShmReadRaw(NI_ShmReader *reader, int32_t index, void *buffer, uint32_t size, uint64_t *tick, double *timestamp)
+{
+	NI_ShmRaw request;
+
+	if ((index < 0) || (index >= (int32_t)reader->header->count) ||
+		((uint64_t)reader->signals[index].width * (uint64_t)reader->signals[index].size > size))
+	{
+		return NI_ERROR;
+	}
+
+	request.index = index;
+	request.buffer = buffer;
+	return NI_ShmConsistentRead(reader, NI_ShmCopyRaw, &request, tick, timestamp);
+}
@@ -0,0 +1,135 @@
+/*========================================================================*
+ * NI VeriStand Model Framework
+ * Shared-memory signal reader
+ *
+ * Abstract:
+ *      Reads the signals and outports a model built with "SharedMemory" publishes
+ *      every step (see NI_ShmHeader). Any number of processes can read at the same
+ *      time; reads take no locks and make no system calls, and never slow down the
+ *      model: a read that overlaps with the model writing a step is retried.
+ *
+ *========================================================================*/
+
+#ifndef NI_SHMREADER_H
+#define NI_SHMREADER_H
+
+#include "ni_modelframework.h"
+
+typedef struct {
+	const NI_ShmHeader *header;		/* mapped segment */
+	const NI_ShmSignal *signals;	/* directory of the segment */
+	uint32_t size;					/* size of the mapping */
+	double reads;					/* number of consistent reads */
+	double retries;					/* number of reads repeated because the model wrote meanwhile */
+} NI_ShmReader;
+
+ /*========================================================================*
+ * Function: NI_ShmOpen
+ *
+ * Abstract:
+ *	Maps the segment of a running model read-only. The mapping stays valid when
+ *	the model stops, but a restarted model publishes to a new segment.
+ *
+ * Input Parameters:
+ *	name	: name of the segment, e.g. "/ni_sinewave"
+ *
+ * Output Parameters:
+ *	reader	: the reader
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the segment does not exist or is not valid
+ *========================================================================*/
+int32_t NI_ShmOpen(NI_ShmReader *reader, const char *name);
+
+ /*========================================================================*
+ * Function: NI_ShmClose
+ *
+ * Abstract:
+ *	Unmaps the segment.
+ *========================================================================*/
+void NI_ShmClose(NI_ShmReader *reader);
+
+ /*========================================================================*
+ * Function: NI_ShmSignalCount
+ *
+ * Returns:
+ *	the number of signals and outports in the segment
+ *========================================================================*/
+int32_t NI_ShmSignalCount(const NI_ShmReader *reader);
+
+ /*========================================================================*
+ * Function: NI_ShmSignalName
+ *
+ * Returns:
+ *	the name of a signal (e.g. "sinewave/sum") or outport (e.g. "Out1"), NULL if
+ *	the index is out of bounds
+ *========================================================================*/
+const char *NI_ShmSignalName(const NI_ShmReader *reader, int32_t index);
+
+ /*========================================================================*
+ * Function: NI_ShmFindSignal
+ *
+ * Returns:
+ *	the index of the signal or outport with the given name, -1 if there is none
+ *========================================================================*/
+int32_t NI_ShmFindSignal(const NI_ShmReader *reader, const char *name);
+
+ /*========================================================================*
+ * Function: NI_ShmSignalWidth
+ *
+ * Returns:
+ *	the number of elements of a signal or outport, -1 if the index is out of bounds
+ *========================================================================*/
+int32_t NI_ShmSignalWidth(const NI_ShmReader *reader, int32_t index);
+
+ /*========================================================================*
+ * Function: NI_ShmRead
+ *
+ * Abstract:
+ *	Reads a list of signals, all from the same step. The elements of each signal 
+ *	follow each other in values (NI_ShmSignalWidth of them). Values of datatypes
+ *	other than double and int32 read as NaN, see NI_ShmReadRaw.
+ *
+ * Input Parameters:
+ *	indices	: indices of the signals
+ *	count	: number of indices
+ *
+ * Input/Output Parameters:
+ *	len		: length of values (in), number of values read (out)
+ *
+ * Output Parameters:
+ *	values		: values of the signals
+ *	tick		: base rate tick of the step, may be NULL
+ *	timestamp	: simulation time of the step, may be NULL
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if an index is out of bounds, the values do not
+ *	fit into len or the model stays in the middle of a write (it stopped while
+ *	writing)
+ *========================================================================*/
+int32_t NI_ShmRead(NI_ShmReader *reader, const int32_t *indices, int32_t count, double *values, int32_t *len, uint64_t *tick, double *timestamp);
+
+ /*========================================================================*
+ * Function: NI_ShmReadRaw
+ *
+ * Abstract:
+ *	Copies the elements of one signal as the model stores them, for datatypes
+ *	NI_ShmRead does not convert. The directory entry gives the datatype and the
+ *	size of an element.
+ *
+ * Input Parameters:
+ *	index	: index of the signal
+ *	size	: size of buffer in bytes
+ *
+ * Output Parameters:
+ *	buffer		: the elements of the signal
+ *	tick		: base rate tick of the step, may be NULL
+ *	timestamp	: simulation time of the step, may be NULL
+ *
+ * Returns:
+ *	NI_OK if no error, NI_ERROR if the index is out of bounds, the elements do
+ *	not fit into size bytes or the model stays in the middle of a write
+ *========================================================================*/
+int32_t NI_ShmReadRaw(NI_ShmReader *reader, int32_t index, void *buffer, uint32_t size, uint64_t *tick, double *timestamp);
+
+#endif
@@ -0,0 +1,13 @@
+/* Sequence of the model @model-name@, generated from @definition@.
+   The sequence is a C++20 coroutine, see ni_sequence.hpp. */
+
+/* Include headers */
+#include "ni_sequence.hpp"
+
+/* !!!! IMPORTANT !!!!
+   Accessing parameters values must be done through rtParameter[READSIDE]
+   The macro readParam is defined for you as a simple way to access parameters
+   !!!! IMPORTANT !!!! */
+#define readParam rtParameter[READSIDE]
+
+@implementation@
@@ -0,0 +1,36 @@
+/* Sub-model @instance@ of the composite model @model-name@, generated from @definition@.
+   Each sub-model is compiled in its own translation unit, so helpers of different
+   sub-models (or of two instances of the same definition) do not clash. */
+
+/* Include headers */
+#include "ni_modelframework.h"
+#include "model.h"
+#include <stddef.h>
+#include <math.h>
+
+/* The implementation sees its own part of the composite model's IO and signals 
+   through the usual names */
+#undef rtInport
+#undef rtOutport
+#undef rtSignal
+#define rtInport	(rtModel.inport.@instance@)
+#define rtOutport	(rtModel.outport.@instance@)
+#define rtSignal	(rtModel.signal.@instance@)
+
+#undef IS_PROBED
+#define IS_PROBED(sig)	NI_IS_PROBED_INDEX(rtSignalIndex_@instance@_##sig)
+
+/* !!!! IMPORTANT !!!!
+   Accessing parameters values must be done through rtParameter[READSIDE]
+   The macro readParam is defined for you as a simple way to access parameters
+   !!!! IMPORTANT !!!! */
+#define readParam (rtParameter[READSIDE].@instance@)
+
+/* The step is called from the static schedule of @model-name@ */
+#define USER_TakeOneStep @model-name@_@instance@_TakeOneStep
+
+@Subsystems-Decl@
+@LTI@
+@Filters@
+@implementation@
+@Subsystems@